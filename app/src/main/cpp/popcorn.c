@@ -49,7 +49,7 @@ void popcorn_onPause(void* priv)
 {
 	ASSERT(priv);
 
-	// ignore
+	popcorn_renderer_pause((popcorn_renderer_t*) priv);
 }
 
 void popcorn_onDraw(void* priv)
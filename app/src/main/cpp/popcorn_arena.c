@@ -0,0 +1,856 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_arena.h"
+#include "popcorn_frametime.h"
+#include "popcorn_memory.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static uint32_t popcorn_arena_align(uint32_t x, uint32_t a)
+{
+	return ((x + a - 1)/a)*a;
+}
+
+static popcorn_arenaPage_t*
+popcorn_arenaPage_new(vkk_engine_t* engine, uint32_t mask,
+                      uint32_t size_vc, uint32_t size_ic)
+{
+	ASSERT(engine);
+
+	popcorn_arenaPage_t* self;
+	self = (popcorn_arenaPage_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                             1, sizeof(popcorn_arenaPage_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	// the staging is zeroed so unused ranges are
+	// degenerate triangles
+	self->ib = (uint16_t*)
+	           popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                                 size_ic, sizeof(uint16_t));
+	self->vb = (float*)
+	           popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                                 size_vc, 3*sizeof(float));
+	self->nb = (float*)
+	           popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                                 size_vc, 3*sizeof(float));
+	self->id = (uint32_t*)
+	           popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                                 size_vc, sizeof(uint32_t));
+	if((self->ib == NULL) || (self->vb == NULL) ||
+	   (self->nb == NULL) || (self->id == NULL))
+	{
+		LOGE("CALLOC failed");
+		goto fail_staging;
+	}
+
+	// the buffers are created once at the page capacity
+	// and later changes only update the used range
+	self->gpu_ib = vkk_buffer_new(engine,
+	                              VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                              VKK_BUFFER_USAGE_INDEX,
+	                              2*((size_t) size_ic),
+	                              self->ib);
+	self->gpu_vb[0] = vkk_buffer_new(engine,
+	                                 VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                 VKK_BUFFER_USAGE_VERTEX,
+	                                 12*((size_t) size_vc),
+	                                 self->vb);
+	self->gpu_vb[1] = vkk_buffer_new(engine,
+	                                 VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                 VKK_BUFFER_USAGE_VERTEX,
+	                                 12*((size_t) size_vc),
+	                                 self->nb);
+	self->gpu_vb[2] = vkk_buffer_new(engine,
+	                                 VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                 VKK_BUFFER_USAGE_VERTEX,
+	                                 4*((size_t) size_vc),
+	                                 self->id);
+	if((self->gpu_ib    == NULL) ||
+	   (self->gpu_vb[0] == NULL) ||
+	   (self->gpu_vb[1] == NULL) ||
+	   (self->gpu_vb[2] == NULL))
+	{
+		goto fail_buffers;
+	}
+
+	self->size_vc  = size_vc;
+	self->size_ic  = size_ic;
+	self->mask     = mask;
+	self->size_gpu = 2*((size_t) size_ic) + 28*((size_t) size_vc);
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_ARENA,
+	                        self->size_gpu);
+
+	// success
+	return self;
+
+	// failure
+	fail_buffers:
+		vkk_buffer_delete(&self->gpu_vb[2]);
+		vkk_buffer_delete(&self->gpu_vb[1]);
+		vkk_buffer_delete(&self->gpu_vb[0]);
+		vkk_buffer_delete(&self->gpu_ib);
+	fail_staging:
+		popcorn_memory_free(self->id);
+		popcorn_memory_free(self->nb);
+		popcorn_memory_free(self->vb);
+		popcorn_memory_free(self->ib);
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+static void
+popcorn_arenaPage_delete(popcorn_arenaPage_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_arenaPage_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_ARENA,
+		                       self->size_gpu);
+		vkk_buffer_delete(&self->gpu_vb[2]);
+		vkk_buffer_delete(&self->gpu_vb[1]);
+		vkk_buffer_delete(&self->gpu_vb[0]);
+		vkk_buffer_delete(&self->gpu_ib);
+
+		popcorn_arenaAlloc_t* alloc = self->head;
+		while(alloc)
+		{
+			popcorn_arenaAlloc_t* next = alloc->next;
+			popcorn_memory_free(alloc);
+			alloc = next;
+		}
+
+		popcorn_memory_free(self->id);
+		popcorn_memory_free(self->nb);
+		popcorn_memory_free(self->vb);
+		popcorn_memory_free(self->ib);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+static int
+popcorn_arenaPage_fit(popcorn_arenaPage_t* self,
+                      uint32_t vc, uint32_t ic,
+                      popcorn_arenaAlloc_t** _prev,
+                      uint32_t* _vo, uint32_t* _io)
+{
+	ASSERT(self);
+	ASSERT(_prev);
+	ASSERT(_vo);
+	ASSERT(_io);
+
+	// first fit in the gaps between the live allocations
+	// where the vertex and index gaps must both fit
+	// since the ranges are kept in the same order
+	uint32_t              v    = 0;
+	uint32_t              i    = 0;
+	popcorn_arenaAlloc_t* prev = NULL;
+	popcorn_arenaAlloc_t* next = self->head;
+	while(1)
+	{
+		uint32_t vo = popcorn_arena_align(v, POPCORN_ARENA_ALIGN_VERTICES);
+		uint32_t io = popcorn_arena_align(i, POPCORN_ARENA_ALIGN_INDICES);
+		uint32_t ve = next ? next->vo : self->size_vc;
+		uint32_t ie = next ? next->io : self->size_ic;
+		if((vo + vc <= ve) && (io + ic <= ie))
+		{
+			*_prev = prev;
+			*_vo   = vo;
+			*_io   = io;
+			return 1;
+		}
+
+		if(next == NULL)
+		{
+			return 0;
+		}
+
+		v    = next->vo + next->vc;
+		i    = next->io + next->ic;
+		prev = next;
+		next = next->next;
+	}
+}
+
+static void
+popcorn_arenaPage_end(popcorn_arenaPage_t* self,
+                      popcorn_arenaAlloc_t* last)
+{
+	ASSERT(self);
+
+	if(last)
+	{
+		self->vc = last->vo + last->vc;
+		self->ic = last->io + last->ic;
+	}
+	else
+	{
+		self->vc = 0;
+		self->ic = 0;
+	}
+}
+
+static void
+popcorn_arenaPage_defrag(popcorn_arenaPage_t* self)
+{
+	ASSERT(self);
+
+	// allocations are in ascending order so live ranges
+	// are moved down
+	uint32_t v = 0;
+	uint32_t i = 0;
+
+	popcorn_arenaAlloc_t* last  = NULL;
+	popcorn_arenaAlloc_t* alloc = self->head;
+	while(alloc)
+	{
+		uint32_t vo = popcorn_arena_align(v, POPCORN_ARENA_ALIGN_VERTICES);
+		uint32_t io = popcorn_arena_align(i, POPCORN_ARENA_ALIGN_INDICES);
+		memmove(&self->vb[3*vo], &self->vb[3*alloc->vo],
+		        12*((size_t) alloc->vc));
+		memmove(&self->nb[3*vo], &self->nb[3*alloc->vo],
+		        12*((size_t) alloc->vc));
+		memmove(&self->id[vo], &self->id[alloc->vo],
+		        4*((size_t) alloc->vc));
+
+		uint32_t j;
+		uint16_t delta = (uint16_t) (alloc->vo - vo);
+		for(j = 0; j < alloc->ic; ++j)
+		{
+			self->ib[io + j] = self->ib[alloc->io + j] - delta;
+		}
+		memset(&self->ib[i], 0, 2*((size_t) (io - i)));
+
+		alloc->vo = vo;
+		alloc->io = io;
+		v = vo + alloc->vc;
+		i = io + alloc->ic;
+
+		last  = alloc;
+		alloc = alloc->next;
+	}
+
+	// clear the indices past the compacted end so the
+	// gap is degenerate when the end grows again
+	memset(&self->ib[i], 0, 2*((size_t) (self->ic - i)));
+	popcorn_arenaPage_end(self, last);
+}
+
+static float
+popcorn_arenaPage_depth(popcorn_arenaPage_t* self)
+{
+	ASSERT(self);
+
+	double   x = 0.0;
+	double   y = 0.0;
+	double   z = 0.0;
+	uint32_t n = 0;
+
+	popcorn_arenaAlloc_t* alloc = self->head;
+	while(alloc)
+	{
+		uint32_t j;
+		for(j = alloc->vo; j < alloc->vo + alloc->vc; ++j)
+		{
+			x += self->vb[3*j];
+			y += self->vb[3*j + 1];
+			z += self->vb[3*j + 2];
+		}
+		n += alloc->vc;
+
+		alloc = alloc->next;
+	}
+
+	if(n == 0)
+	{
+		return 0.0f;
+	}
+
+	x /= (double) n;
+	y /= (double) n;
+	z /= (double) n;
+	return (float) sqrt(x*x + y*y + z*z);
+}
+
+static void
+popcorn_arenaPage_update(popcorn_arenaPage_t* self,
+                         popcorn_arena_t* arena,
+                         vkk_renderer_t* rend)
+{
+	ASSERT(self);
+	ASSERT(arena);
+	ASSERT(rend);
+
+	// compact before the first update of a change
+	if(((self->dirty_ib == POPCORN_ARENA_FRAMES) ||
+	    (self->dirty_vb == POPCORN_ARENA_FRAMES)) &&
+	   (POPCORN_ARENA_DEFRAG*(self->vc - self->live_vc) > self->vc))
+	{
+		popcorn_arenaPage_defrag(self);
+		self->dirty_ib = POPCORN_ARENA_FRAMES;
+		self->dirty_vb = POPCORN_ARENA_FRAMES;
+		++arena->defrags;
+	}
+
+	// the buffer update writes the copy of the current
+	// frame and only the range up to the last allocation
+	// is used
+	if(self->dirty_ib && self->ic)
+	{
+		popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_UPLOAD);
+		vkk_renderer_updateBuffer(rend, self->gpu_ib,
+		                          2*((size_t) self->ic),
+		                          (const void*) self->ib);
+		arena->upload_size += 2*((size_t) self->ic);
+		++arena->uploads;
+	}
+
+	if(self->dirty_vb && self->vc)
+	{
+		if(self->dirty_vb == POPCORN_ARENA_FRAMES)
+		{
+			self->depth = popcorn_arenaPage_depth(self);
+		}
+
+		popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_UPLOAD);
+		vkk_renderer_updateBuffer(rend, self->gpu_vb[0],
+		                          12*((size_t) self->vc),
+		                          (const void*) self->vb);
+		vkk_renderer_updateBuffer(rend, self->gpu_vb[1],
+		                          12*((size_t) self->vc),
+		                          (const void*) self->nb);
+		vkk_renderer_updateBuffer(rend, self->gpu_vb[2],
+		                          4*((size_t) self->vc),
+		                          (const void*) self->id);
+		arena->upload_size += 28*((size_t) self->vc);
+		++arena->uploads;
+	}
+
+	if(self->dirty_ib)
+	{
+		--self->dirty_ib;
+	}
+
+	if(self->dirty_vb)
+	{
+		--self->dirty_vb;
+	}
+}
+
+static popcorn_arenaPage_t*
+popcorn_arena_newPage(popcorn_arena_t* self, uint32_t mask,
+                      uint32_t vc, uint32_t ic)
+{
+	ASSERT(self);
+
+	// the page holds at least vc vertices and ic indices
+	// up to the page limit
+	uint32_t size_vc = POPCORN_ARENA_PAGE;
+	while(size_vc < vc)
+	{
+		size_vc *= 2;
+	}
+
+	if(size_vc > POPCORN_ARENA_VERTICES)
+	{
+		size_vc = POPCORN_ARENA_VERTICES;
+	}
+
+	uint32_t size_ic = 3*POPCORN_ARENA_TRIANGLES*size_vc;
+	if((vc <= size_vc) && (size_ic < ic))
+	{
+		size_ic = popcorn_arena_align(ic,
+		                              POPCORN_ARENA_ALIGN_INDICES);
+	}
+
+	popcorn_arenaPage_t* page;
+	page = popcorn_arenaPage_new(self->engine, mask,
+	                             size_vc, size_ic);
+	if(page == NULL)
+	{
+		return NULL;
+	}
+
+	if(cc_list_append(self->pages, NULL,
+	                  (const void*) page) == NULL)
+	{
+		popcorn_arenaPage_delete(&page);
+		return NULL;
+	}
+
+	return page;
+}
+
+static int popcorn_arena_newAlloc(popcorn_arena_t* self)
+{
+	ASSERT(self);
+
+	popcorn_arenaAlloc_t* alloc;
+	alloc = (popcorn_arenaAlloc_t*)
+	        popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                              1, sizeof(popcorn_arenaAlloc_t));
+	if(alloc == NULL)
+	{
+		LOGE("CALLOC failed");
+		return 0;
+	}
+
+	alloc->next = self->spare;
+	self->spare = alloc;
+
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_arena_t* popcorn_arena_new(vkk_engine_t* engine)
+{
+	ASSERT(engine);
+
+	popcorn_arena_t* self;
+	self = (popcorn_arena_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_ARENA,
+	                             1, sizeof(popcorn_arena_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->engine = engine;
+
+	self->pages = cc_list_new();
+	if(self->pages == NULL)
+	{
+		goto fail_pages;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_pages:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_arena_delete(popcorn_arena_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_arena_t* self = *_self;
+	if(self)
+	{
+		cc_listIter_t* iter = cc_list_head(self->pages);
+		while(iter)
+		{
+			popcorn_arenaPage_t* page;
+			page = (popcorn_arenaPage_t*)
+			       cc_list_remove(self->pages, &iter);
+			popcorn_arenaPage_delete(&page);
+		}
+
+		popcorn_arenaAlloc_t* alloc = self->spare;
+		while(alloc)
+		{
+			popcorn_arenaAlloc_t* next = alloc->next;
+			popcorn_memory_free(alloc);
+			alloc = next;
+		}
+
+		cc_list_delete(&self->pages);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+popcorn_arenaAlloc_t*
+popcorn_arena_alloc(popcorn_arena_t* self, uint32_t node,
+                    uint32_t mask,
+                    uint32_t ic, const uint16_t* ib,
+                    uint32_t vc, const float* vb,
+                    const float* nb)
+{
+	ASSERT(self);
+	ASSERT(ib);
+	ASSERT(vb);
+	ASSERT(nb);
+
+	if((vc == 0) || (vc > POPCORN_ARENA_VERTICES) || (ic % 3))
+	{
+		LOGE("invalid vc=%u, ic=%u", vc, ic);
+		return NULL;
+	}
+
+	// first fit in a page of the same levels
+	uint32_t              vo   = 0;
+	uint32_t              io   = 0;
+	popcorn_arenaAlloc_t* prev = NULL;
+	popcorn_arenaPage_t*  page = NULL;
+	cc_listIter_t*        iter = cc_list_head(self->pages);
+	while(iter)
+	{
+		page = (popcorn_arenaPage_t*) cc_list_peekIter(iter);
+		if((page->mask == mask) &&
+		   popcorn_arenaPage_fit(page, vc, ic, &prev, &vo, &io))
+		{
+			break;
+		}
+
+		page = NULL;
+		iter = cc_list_next(iter);
+	}
+
+	if(page == NULL)
+	{
+		page = popcorn_arena_newPage(self, mask, vc, ic);
+		if(page == NULL)
+		{
+			return NULL;
+		}
+
+		prev = NULL;
+		vo   = 0;
+		io   = 0;
+	}
+
+	// allocation records are reused
+	if((self->spare == NULL) &&
+	   (popcorn_arena_newAlloc(self) == 0))
+	{
+		return NULL;
+	}
+
+	popcorn_arenaAlloc_t* alloc = self->spare;
+	self->spare = alloc->next;
+
+	alloc->page = page;
+	alloc->prev = prev;
+	alloc->next = prev ? prev->next : page->head;
+	alloc->node = node;
+	alloc->vo   = vo;
+	alloc->vc   = vc;
+	alloc->io   = io;
+	alloc->ic   = ic;
+	if(alloc->next)
+	{
+		alloc->next->prev = alloc;
+	}
+	if(prev)
+	{
+		prev->next = alloc;
+	}
+	else
+	{
+		page->head = alloc;
+	}
+
+	// copy into the staging buffers and rebase the
+	// indices to the page
+	// the padding before the allocation is already
+	// zero since freed and compacted ranges are cleared
+	uint32_t i;
+	memcpy(&page->vb[3*vo], vb, 12*((size_t) vc));
+	memcpy(&page->nb[3*vo], nb, 12*((size_t) vc));
+	for(i = 0; i < vc; ++i)
+	{
+		page->id[vo + i] = node;
+	}
+	for(i = 0; i < ic; ++i)
+	{
+		page->ib[io + i] = (uint16_t) (ib[i] + vo);
+	}
+
+	if(alloc->next == NULL)
+	{
+		popcorn_arenaPage_end(page, alloc);
+	}
+	page->live_vc  += vc;
+	page->live_ic  += ic;
+	page->dirty_ib  = POPCORN_ARENA_FRAMES;
+	page->dirty_vb  = POPCORN_ARENA_FRAMES;
+	++page->count;
+
+	return alloc;
+}
+
+int popcorn_arena_reserve(popcorn_arena_t* self,
+                          uint32_t mask,
+                          uint32_t vc, uint32_t ic,
+                          uint32_t count)
+{
+	ASSERT(self);
+
+	// the capacity of the existing pages counts towards
+	// the reservation
+	uint32_t size_vc = 0;
+	uint32_t size_ic = 0;
+
+	cc_listIter_t* iter = cc_list_head(self->pages);
+	while(iter)
+	{
+		popcorn_arenaPage_t* page;
+		page = (popcorn_arenaPage_t*) cc_list_peekIter(iter);
+		if(page->mask == mask)
+		{
+			size_vc += page->size_vc - page->live_vc;
+			size_ic += page->size_ic - page->live_ic;
+		}
+
+		iter = cc_list_next(iter);
+	}
+
+	while((size_vc < vc) || (size_ic < ic))
+	{
+		uint32_t rem_vc = (size_vc < vc) ? vc - size_vc : 0;
+		uint32_t rem_ic = (size_ic < ic) ? ic - size_ic : 0;
+
+		popcorn_arenaPage_t* page;
+		page = popcorn_arena_newPage(self, mask, rem_vc, rem_ic);
+		if(page == NULL)
+		{
+			return 0;
+		}
+
+		size_vc += page->size_vc;
+		size_ic += page->size_ic;
+	}
+
+	uint32_t i;
+	for(i = 0; i < count; ++i)
+	{
+		if(popcorn_arena_newAlloc(self) == 0)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int popcorn_arena_fit(popcorn_arena_t* self, uint32_t mask,
+                      uint32_t vc, uint32_t ic)
+{
+	ASSERT(self);
+
+	if(self->spare == NULL)
+	{
+		return 0;
+	}
+
+	// a page without a gap is compacted when its free
+	// space would fit the allocation
+	popcorn_arenaPage_t* page = NULL;
+	cc_listIter_t*       iter = cc_list_head(self->pages);
+	while(iter)
+	{
+		popcorn_arenaPage_t* p;
+		p = (popcorn_arenaPage_t*) cc_list_peekIter(iter);
+
+		popcorn_arenaAlloc_t* prev;
+		uint32_t              vo;
+		uint32_t              io;
+		if(p->mask == mask)
+		{
+			if(popcorn_arenaPage_fit(p, vc, ic, &prev, &vo, &io))
+			{
+				return 1;
+			}
+
+			// bound the alignment padding of the
+			// compacted allocations
+			uint32_t n = p->count + 1;
+			if((page == NULL) &&
+			   (p->live_vc + vc + POPCORN_ARENA_ALIGN_VERTICES*n <=
+			    p->size_vc) &&
+			   (p->live_ic + ic + POPCORN_ARENA_ALIGN_INDICES*n <=
+			    p->size_ic))
+			{
+				page = p;
+			}
+		}
+
+		iter = cc_list_next(iter);
+	}
+
+	if(page == NULL)
+	{
+		return 0;
+	}
+
+	popcorn_arenaPage_defrag(page);
+	page->dirty_ib = POPCORN_ARENA_FRAMES;
+	page->dirty_vb = POPCORN_ARENA_FRAMES;
+	++self->defrags;
+
+	popcorn_arenaAlloc_t* prev;
+	uint32_t              vo;
+	uint32_t              io;
+	return popcorn_arenaPage_fit(page, vc, ic, &prev, &vo, &io);
+}
+
+void popcorn_arena_free(popcorn_arena_t* self,
+                        popcorn_arenaAlloc_t** _alloc)
+{
+	ASSERT(self);
+	ASSERT(_alloc);
+
+	popcorn_arenaAlloc_t* alloc = *_alloc;
+	if(alloc)
+	{
+		// freed ranges are drawn as degenerate triangles
+		// until they are reused or the page is compacted
+		// so only the indices are updated
+		popcorn_arenaPage_t* page = alloc->page;
+		memset(&page->ib[alloc->io], 0, 2*((size_t) alloc->ic));
+		page->live_vc -= alloc->vc;
+		page->live_ic -= alloc->ic;
+		page->dirty_ib = POPCORN_ARENA_FRAMES;
+		--page->count;
+
+		if(alloc->prev)
+		{
+			alloc->prev->next = alloc->next;
+		}
+		else
+		{
+			page->head = alloc->next;
+		}
+
+		if(alloc->next)
+		{
+			alloc->next->prev = alloc->prev;
+		}
+		else
+		{
+			popcorn_arenaPage_end(page, alloc->prev);
+		}
+
+		alloc->next = self->spare;
+		self->spare = alloc;
+		*_alloc     = NULL;
+	}
+}
+
+void popcorn_arena_flush(popcorn_arena_t* self,
+                         vkk_renderer_t* rend)
+{
+	ASSERT(self);
+	ASSERT(rend);
+
+	// empty pages are kept since their buffers are
+	// reused by later allocations
+	cc_listIter_t* iter = cc_list_head(self->pages);
+	while(iter)
+	{
+		popcorn_arenaPage_t* page;
+		page = (popcorn_arenaPage_t*) cc_list_peekIter(iter);
+		if(page->dirty_ib || page->dirty_vb)
+		{
+			popcorn_arenaPage_update(page, self, rend);
+		}
+
+		iter = cc_list_next(iter);
+	}
+}
+
+void popcorn_arena_enqueue(popcorn_arena_t* self,
+                           popcorn_queue_t* queue,
+                           popcorn_queueLayer_e layer,
+                           vkk_graphicsPipeline_t* gp,
+                           vkk_uniformSet_t* us0,
+                           uint32_t level)
+{
+	ASSERT(self);
+	ASSERT(queue);
+	ASSERT(gp);
+	ASSERT(us0);
+
+	cc_listIter_t* iter = cc_list_head(self->pages);
+	while(iter)
+	{
+		popcorn_arenaPage_t* page;
+		page = (popcorn_arenaPage_t*) cc_list_peekIter(iter);
+		if(page->count && (page->mask & (1 << level)))
+		{
+			popcorn_queue_drawIndexed(queue, layer, gp, us0,
+			                          page->depth, page->ic,
+			                          3, page->gpu_ib,
+			                          page->gpu_vb);
+		}
+
+		iter = cc_list_next(iter);
+	}
+}
+
+void popcorn_arena_report(popcorn_arena_t* self)
+{
+	ASSERT(self);
+
+	// fragmentation is the fraction of freed vertices
+	// below the end of the page which are not reused
+	int idx = 0;
+
+	cc_listIter_t* iter = cc_list_head(self->pages);
+	while(iter)
+	{
+		popcorn_arenaPage_t* page;
+		page = (popcorn_arenaPage_t*) cc_list_peekIter(iter);
+
+		float frag = 0.0f;
+		if(page->vc)
+		{
+			frag = 100.0f*((float) (page->vc - page->live_vc))/
+			       ((float) page->vc);
+		}
+
+		LOGI("page=%i, mask=0x%X, allocs=%u, vc=%u/%u, ic=%u/%u, live_vc=%u, frag=%.1f%%",
+		     idx, page->mask, page->count,
+		     page->vc, page->size_vc, page->ic, page->size_ic,
+		     page->live_vc, frag);
+
+		++idx;
+		iter = cc_list_next(iter);
+	}
+
+	LOGI("arena pages=%i, uploads=%u, upload_size=%u, defrags=%u",
+	     idx, self->uploads, (uint32_t) self->upload_size,
+	     self->defrags);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_arena_H
+#define popcorn_arena_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libcc/cc_list.h"
+#include "libvkk/vkk.h"
+#include "popcorn_queue.h"
+
+// static mesh arena
+// parts are suballocated from pages of shared index,
+// vertex, normal and node id buffers which are drawn
+// with one call per page since the node id selects the
+// transform
+// pages are limited by the uint16 index type
+#define POPCORN_ARENA_VERTICES 65536
+
+// minimum page capacity in vertices where the index
+// capacity is POPCORN_ARENA_TRIANGLES per vertex
+#ifndef POPCORN_ARENA_PAGE
+#define POPCORN_ARENA_PAGE 16384
+#endif
+#define POPCORN_ARENA_TRIANGLES 2
+
+// page buffers are created once at their capacity and
+// updated asynchronously so a change is uploaded for
+// each of the swapchain images which may be in flight
+#define POPCORN_ARENA_FRAMES 4
+
+// suballocations are aligned in elements and index
+// ranges are also a multiple of 3 so the padding is
+// drawn as degenerate triangles
+#define POPCORN_ARENA_ALIGN_VERTICES 4
+#define POPCORN_ARENA_ALIGN_INDICES  12
+
+// compact pages when freed vertices exceed 1/4
+#define POPCORN_ARENA_DEFRAG 4
+
+// popcorn_arena_reserve creates pages and allocation
+// records up front and popcorn_arena_fit checks that an
+// allocation needs neither so that streamed parts are
+// allocated without heap or driver allocations
+
+// parts are allocated with a mask of the LOD levels which
+// draw them and pages only hold parts of the same mask
+// see popcorn_lod_mask
+
+typedef struct popcorn_arenaPage_s  popcorn_arenaPage_t;
+typedef struct popcorn_arenaAlloc_s popcorn_arenaAlloc_t;
+
+typedef struct popcorn_arenaAlloc_s
+{
+	popcorn_arenaPage_t*  page;
+	popcorn_arenaAlloc_t* prev;
+	popcorn_arenaAlloc_t* next;
+	uint32_t              node;
+	uint32_t              vo;
+	uint32_t              vc;
+	uint32_t              io;
+	uint32_t              ic;
+} popcorn_arenaAlloc_t;
+
+typedef struct popcorn_arenaPage_s
+{
+	// capacity
+	uint32_t size_vc;
+	uint32_t size_ic;
+
+	// host staging
+	// vc and ic are the end of the last allocation
+	uint32_t  vc;
+	uint32_t  ic;
+	uint16_t* ib;
+	float*    vb;
+	float*    nb;
+	uint32_t* id;
+
+	// LOD levels which draw the page
+	uint32_t mask;
+
+	// live allocations in ascending order where the
+	// gaps between them are reused by later allocations
+	popcorn_arenaAlloc_t* head;
+	uint32_t              count;
+	uint32_t              live_vc;
+	uint32_t              live_ic;
+
+	// frames which must still update the index and
+	// vertex buffers
+	uint32_t dirty_ib;
+	uint32_t dirty_vb;
+
+	// persistent buffers
+	vkk_buffer_t* gpu_ib;
+	vkk_buffer_t* gpu_vb[3];
+	size_t        size_gpu;
+
+	// distance to the centroid of the live vertices
+	// from the model origin for front to back sorting
+	float depth;
+} popcorn_arenaPage_t;
+
+typedef struct
+{
+	vkk_engine_t* engine;
+	cc_list_t*    pages;
+
+	// freed allocation records
+	popcorn_arenaAlloc_t* spare;
+
+	// statistics
+	uint32_t uploads;
+	size_t   upload_size;
+	uint32_t defrags;
+} popcorn_arena_t;
+
+popcorn_arena_t*      popcorn_arena_new(vkk_engine_t* engine);
+void                  popcorn_arena_delete(popcorn_arena_t** _self);
+popcorn_arenaAlloc_t* popcorn_arena_alloc(popcorn_arena_t* self,
+                                          uint32_t node,
+                                          uint32_t mask,
+                                          uint32_t ic,
+                                          const uint16_t* ib,
+                                          uint32_t vc,
+                                          const float* vb,
+                                          const float* nb);
+int                   popcorn_arena_reserve(popcorn_arena_t* self,
+                                            uint32_t mask,
+                                            uint32_t vc,
+                                            uint32_t ic,
+                                            uint32_t count);
+int                   popcorn_arena_fit(popcorn_arena_t* self,
+                                        uint32_t mask,
+                                        uint32_t vc,
+                                        uint32_t ic);
+void                  popcorn_arena_free(popcorn_arena_t* self,
+                                         popcorn_arenaAlloc_t** _alloc);
+void                  popcorn_arena_flush(popcorn_arena_t* self,
+                                          vkk_renderer_t* rend);
+void                  popcorn_arena_enqueue(popcorn_arena_t* self,
+                                            popcorn_queue_t* queue,
+                                            popcorn_queueLayer_e layer,
+                                            vkk_graphicsPipeline_t* gp,
+                                            vkk_uniformSet_t* us0,
+                                            uint32_t level);
+void                  popcorn_arena_report(popcorn_arena_t* self);
+
+#endif
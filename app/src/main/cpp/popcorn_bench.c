@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libcc/cc_timestamp.h"
+#include "popcorn_convert.h"
+#include "popcorn_memory.h"
+#include "popcorn_particle.h"
+
+// benchmark of the glTF conversion and particle kernels
+// compares the vectorized kernels against the scalar
+// reference and verifies the outputs match
+
+#define POPCORN_BENCH_COUNT  (1024*1024)
+#define POPCORN_BENCH_REPEAT 32
+
+// particles are stepped at 60Hz and expire during the
+// benchmark so the compaction is included
+#define POPCORN_BENCH_PARTICLES (64*1024)
+#define POPCORN_BENCH_STEPS     120
+
+typedef struct
+{
+	const char* name;
+	int         type;
+	int         normalized;
+	size_t      stride;
+} popcorn_benchVec3f_t;
+
+static const popcorn_benchVec3f_t POPCORN_BENCH_VEC3F[] =
+{
+	{ "float",              POPCORN_CONVERT_FLOAT,          0, 12 },
+	{ "float/interleaved",  POPCORN_CONVERT_FLOAT,          0, 24 },
+	{ "short/normalized",   POPCORN_CONVERT_SHORT,          1, 8  },
+	{ "ushort/quantized",   POPCORN_CONVERT_UNSIGNED_SHORT, 0, 8  },
+	{ "byte/normalized",    POPCORN_CONVERT_BYTE,           1, 4  },
+	{ "ubyte/normalized",   POPCORN_CONVERT_UNSIGNED_BYTE,  1, 4  },
+	{ NULL,                 0,                              0, 0  },
+};
+
+static const int POPCORN_BENCH_INDICES[] =
+{
+	POPCORN_CONVERT_UNSIGNED_BYTE,
+	POPCORN_CONVERT_UNSIGNED_SHORT,
+	POPCORN_CONVERT_UNSIGNED_INT,
+	0,
+};
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static void
+popcorn_bench_report(const char* name, size_t bytes,
+                     double dt_ref, double dt)
+{
+	ASSERT(name);
+
+	double mb = ((double) bytes)/(1024.0*1024.0);
+	LOGI("%-20s ref=%8.1f MB/s, simd=%8.1f MB/s, speedup=%.2f",
+	     name, mb/dt_ref, mb/dt, dt_ref/dt);
+}
+
+static int
+popcorn_bench_vec3f(const popcorn_benchVec3f_t* bench,
+                    const char* src, float* ref, float* dst)
+{
+	ASSERT(bench);
+	ASSERT(src);
+	ASSERT(ref);
+	ASSERT(dst);
+
+	uint32_t count = POPCORN_BENCH_COUNT;
+
+	int    i;
+	double t0 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_REPEAT; ++i)
+	{
+		popcorn_convert_vec3fRef(bench->type, bench->normalized,
+		                         src, bench->stride, count, ref);
+	}
+	double t1 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_REPEAT; ++i)
+	{
+		popcorn_convert_vec3f(bench->type, bench->normalized,
+		                      src, bench->stride, count, dst);
+	}
+	double t2 = cc_timestamp();
+
+	if(memcmp(ref, dst, 12*((size_t) count)) != 0)
+	{
+		LOGE("%s mismatch", bench->name);
+		return 0;
+	}
+
+	popcorn_bench_report(bench->name,
+	                     POPCORN_BENCH_REPEAT*bench->stride*count,
+	                     t1 - t0, t2 - t1);
+	return 1;
+}
+
+static int
+popcorn_bench_indices(int type, const char* src,
+                      uint32_t* ref, uint32_t* dst)
+{
+	ASSERT(src);
+	ASSERT(ref);
+	ASSERT(dst);
+
+	uint32_t count = POPCORN_BENCH_COUNT;
+
+	int    i;
+	double t0 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_REPEAT; ++i)
+	{
+		popcorn_convert_indicesRef(type, src, count, ref);
+	}
+	double t1 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_REPEAT; ++i)
+	{
+		popcorn_convert_indices(type, src, count, dst);
+	}
+	double t2 = cc_timestamp();
+
+	char name[32];
+	snprintf(name, 32, "indices/0x%X", (uint32_t) type);
+	if(memcmp(ref, dst, 4*((size_t) count)) != 0)
+	{
+		LOGE("%s mismatch", name);
+		return 0;
+	}
+
+	size_t size = popcorn_convert_size(type);
+	popcorn_bench_report(name, POPCORN_BENCH_REPEAT*size*count,
+	                     t1 - t0, t2 - t1);
+	return 1;
+}
+
+static int
+popcorn_bench_narrow(const uint32_t* src,
+                     uint16_t* ref, uint16_t* dst)
+{
+	ASSERT(src);
+	ASSERT(ref);
+	ASSERT(dst);
+
+	uint32_t count = POPCORN_BENCH_COUNT;
+
+	int    i;
+	double t0 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_REPEAT; ++i)
+	{
+		popcorn_convert_narrowRef(src, count, 65536, ref);
+	}
+	double t1 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_REPEAT; ++i)
+	{
+		popcorn_convert_narrow(src, count, 65536, dst);
+	}
+	double t2 = cc_timestamp();
+
+	if(memcmp(ref, dst, 2*((size_t) count)) != 0)
+	{
+		LOGE("narrow mismatch");
+		return 0;
+	}
+
+	// out of range indices must be rejected
+	if(popcorn_convert_narrow(src, count, 256, dst))
+	{
+		LOGE("narrow limit");
+		return 0;
+	}
+
+	popcorn_bench_report("narrow",
+	                     POPCORN_BENCH_REPEAT*4*count,
+	                     t1 - t0, t2 - t1);
+	return 1;
+}
+
+static void
+popcorn_bench_fill(popcorn_particle_t* particle)
+{
+	ASSERT(particle);
+
+	srand(2);
+
+	uint32_t i;
+	for(i = 0; i < particle->budget; ++i)
+	{
+		float p[3];
+		float v[3];
+		int   j;
+		for(j = 0; j < 3; ++j)
+		{
+			p[j] = (float) (rand() % 2001 - 1000)/100.0f;
+			v[j] = (float) (rand() % 2001 - 1000)/1000.0f;
+		}
+
+		float life = 0.5f + (float) (rand() % 1000)/500.0f;
+		popcorn_particle_emit(particle, p, v, life);
+	}
+}
+
+static int
+popcorn_bench_match(const float* a, const float* b,
+                    uint32_t count)
+{
+	ASSERT(a);
+	ASSERT(b);
+
+	// the SIMD kernel may contract multiply-adds
+	uint32_t i;
+	for(i = 0; i < count; ++i)
+	{
+		if(fabsf(a[i] - b[i]) > 1.0e-4f)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int popcorn_bench_particle(void)
+{
+	popcorn_particle_t* ref;
+	ref = popcorn_particle_new(POPCORN_BENCH_PARTICLES);
+	if(ref == NULL)
+	{
+		return 0;
+	}
+
+	popcorn_particle_t* dst;
+	dst = popcorn_particle_new(POPCORN_BENCH_PARTICLES);
+	if(dst == NULL)
+	{
+		goto fail_dst;
+	}
+
+	popcorn_bench_fill(ref);
+	popcorn_bench_fill(dst);
+
+	popcorn_particleForce_t force =
+	{
+		.g    = { 0.0f, 0.0f, 0.002f },
+		.drag = 0.5f,
+	};
+	float dt = 1.0f/60.0f;
+
+	// particles updated by each kernel
+	uint64_t count_ref = 0;
+	uint64_t count_dst = 0;
+
+	int    i;
+	double t0 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_STEPS; ++i)
+	{
+		count_ref += ref->count;
+		popcorn_particle_updateRef(ref, &force, dt);
+	}
+	double t1 = cc_timestamp();
+	for(i = 0; i < POPCORN_BENCH_STEPS; ++i)
+	{
+		count_dst += dst->count;
+		popcorn_particle_update(dst, &force, dt);
+	}
+	double t2 = cc_timestamp();
+
+	if((ref->count != dst->count) ||
+	   (count_ref  != count_dst)  ||
+	   (memcmp(ref->age, dst->age,
+	           sizeof(float)*ref->count) != 0) ||
+	   (popcorn_bench_match(ref->px, dst->px, ref->count) == 0) ||
+	   (popcorn_bench_match(ref->py, dst->py, ref->count) == 0) ||
+	   (popcorn_bench_match(ref->pz, dst->pz, ref->count) == 0) ||
+	   (popcorn_bench_match(ref->vx, dst->vx, ref->count) == 0) ||
+	   (popcorn_bench_match(ref->vy, dst->vy, ref->count) == 0) ||
+	   (popcorn_bench_match(ref->vz, dst->vz, ref->count) == 0))
+	{
+		LOGE("particle mismatch");
+		goto fail_match;
+	}
+
+	double ms_ref = 1000.0*(t1 - t0);
+	double ms_dst = 1000.0*(t2 - t1);
+	LOGI("%-20s ref=%8.0f p/ms, simd=%8.0f p/ms, speedup=%.2f",
+	     "particle", ((double) count_ref)/ms_ref,
+	     ((double) count_dst)/ms_dst, ms_ref/ms_dst);
+
+	popcorn_particle_delete(&dst);
+	popcorn_particle_delete(&ref);
+
+	// success
+	return 1;
+
+	// failure
+	fail_match:
+		popcorn_particle_delete(&dst);
+	fail_dst:
+		popcorn_particle_delete(&ref);
+	return 0;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	size_t count = POPCORN_BENCH_COUNT;
+
+	// sized for the largest stride and output
+	size_t size_src = 24*count;
+	size_t size_dst = 12*count;
+
+	char* buf;
+	buf = (char*)
+	      popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH, 1,
+	                            size_src + 2*size_dst);
+	if(buf == NULL)
+	{
+		LOGE("CALLOC failed");
+		return EXIT_FAILURE;
+	}
+
+	char*  src = buf;
+	float* ref = (float*) (buf + size_src);
+	float* dst = (float*) (buf + size_src + size_dst);
+
+	// fill the source with finite floats so every
+	// component type reads valid data
+	size_t i;
+	float* fsrc = (float*) src;
+	srand(1);
+	for(i = 0; i < size_src/4; ++i)
+	{
+		fsrc[i] = (float) (rand() % 65536) - 32768.0f;
+	}
+
+	const popcorn_benchVec3f_t* bench = POPCORN_BENCH_VEC3F;
+	while(bench->name)
+	{
+		if(popcorn_bench_vec3f(bench, src, ref, dst) == 0)
+		{
+			goto fail_bench;
+		}
+		++bench;
+	}
+
+	const int* type = POPCORN_BENCH_INDICES;
+	while(*type)
+	{
+		if(popcorn_bench_indices(*type, src, (uint32_t*) ref,
+		                         (uint32_t*) dst) == 0)
+		{
+			goto fail_bench;
+		}
+		++type;
+	}
+
+	// narrow the widened uint16 indices
+	uint32_t* wide = (uint32_t*) (src + size_dst);
+	popcorn_convert_indices(POPCORN_CONVERT_UNSIGNED_SHORT,
+	                        src, count, wide);
+	if(popcorn_bench_narrow(wide,
+	                        (uint16_t*) ref,
+	                        (uint16_t*) dst) == 0)
+	{
+		goto fail_bench;
+	}
+
+	if(popcorn_bench_particle() == 0)
+	{
+		goto fail_bench;
+	}
+
+	popcorn_memory_free(buf);
+
+	// success
+	return EXIT_SUCCESS;
+
+	// failure
+	fail_bench:
+		popcorn_memory_free(buf);
+	return EXIT_FAILURE;
+}
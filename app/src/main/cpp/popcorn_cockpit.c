@@ -20,6 +20,7 @@
  * THE SOFTWARE.
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,228 +29,385 @@
 #include "libcc/math/cc_mat4f.h"
 #include "libcc/math/cc_vec4f.h"
 #include "libcc/cc_log.h"
-#include "libcc/cc_memory.h"
+#include "libcc/cc_timestamp.h"
 #include "libgltf/gltf.h"
 #include "libpak/pak_file.h"
+#include "popcorn_arena.h"
 #include "popcorn_cockpit.h"
+#include "popcorn_frametime.h"
+#include "popcorn_gltf.h"
+#include "popcorn_lod.h"
+#include "popcorn_memory.h"
+#include "popcorn_mesh.h"
+#include "popcorn_pakmap.h"
+#include "popcorn_scene.h"
+#include "popcorn_startup.h"
 
 /***********************************************************
 * private                                                  *
 ***********************************************************/
 
 static popcorn_part_t*
-popcorn_part_new(vkk_engine_t* engine, gltf_file_t* file,
-                 gltf_primitive_t* primitive)
+popcorn_part_new(popcorn_arena_t* arena,
+                 uint32_t node, uint32_t mask, uint32_t ic,
+                 const uint16_t* ib, uint32_t vc,
+                 const float* vb, const float* nb)
 {
-	ASSERT(engine);
-	ASSERT(file);
-	ASSERT(primitive);
-
-	gltf_accessor_t* aib;
-	gltf_accessor_t* anb = NULL;
-	gltf_accessor_t* avb = NULL;
+	ASSERT(arena);
+	ASSERT(ib);
+	ASSERT(vb);
+	ASSERT(nb);
 
-	// get accessors
-	cc_listIter_t* iter;
-	iter = cc_list_head(primitive->attributes);
-	aib  = gltf_file_getAccessor(file, primitive->indices);
-	while(iter)
+	popcorn_part_t* self;
+	self = (popcorn_part_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_PART,
+	                             1, sizeof(popcorn_part_t));
+	if(self == NULL)
 	{
-		gltf_attribute_t* attr;
-		attr = (gltf_attribute_t*) cc_list_peekIter(iter);
-
-		if(strcmp(attr->name, "POSITION") == 0)
-		{
-			avb = gltf_file_getAccessor(file, attr->accessor);
-		}
-		else if(strcmp(attr->name, "NORMAL") == 0)
-		{
-			anb = gltf_file_getAccessor(file, attr->accessor);
-		}
-
-		iter = cc_list_next(iter);
+		LOGE("CALLOC failed");
+		return NULL;
 	}
-	if((aib == NULL) || (anb == NULL) || (avb == NULL))
+
+	// the arena copies the buffers into its staging pages
+	// which are uploaded by popcorn_arena_flush
+	self->alloc = popcorn_arena_alloc(arena, node, mask,
+	                                  ic, ib, vc, vb, nb);
+	if(self->alloc == NULL)
 	{
-		LOGE("invalid accessors=%p,%p,%p",
-		     aib, anb, avb);
-		return NULL;
+		goto fail_alloc;
 	}
 
-	// check for required accessor types
-	if((aib->type != GLTF_ACCESSOR_TYPE_SCALAR) ||
-	   (anb->type != GLTF_ACCESSOR_TYPE_VEC3)   ||
-	   (avb->type != GLTF_ACCESSOR_TYPE_VEC3))
+	self->ic   = ic;
+	self->vc   = vc;
+	self->node = node;
+	self->mask = mask;
+
+	// success
+	return self;
+
+	// failure
+	fail_alloc:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+static popcorn_part_t*
+popcorn_part_newGltf(uint32_t node,
+                     popcorn_gltf_t* loader,
+                     gltf_file_t* file,
+                     gltf_primitive_t* primitive)
+{
+	ASSERT(loader);
+	ASSERT(file);
+	ASSERT(primitive);
+
+	// convert into the loader scratch buffers
+	if(popcorn_gltf_load(loader, file, primitive) == 0)
 	{
-		LOGE("invalid type=0x%X,0x%X,0x%X",
-		     aib->type, anb->type, avb->type);
 		return NULL;
 	}
 
-	// check for required component types
-	if((aib->componentType != GLTF_COMPONENT_TYPE_UNSIGNED_SHORT) ||
-	   (anb->componentType != GLTF_COMPONENT_TYPE_FLOAT)          ||
-	   (avb->componentType != GLTF_COMPONENT_TYPE_FLOAT))
+	popcorn_part_t* self;
+	self = (popcorn_part_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_PART,
+	                             1, sizeof(popcorn_part_t));
+	if(self == NULL)
 	{
-		LOGE("invalid componentType=0x%X,0x%X,0x%X",
-		     aib->componentType,
-		     anb->componentType,
-		     avb->componentType);
+		LOGE("CALLOC failed");
 		return NULL;
 	}
 
-	// require bufferViews
-	if((aib->has_bufferView == 0) ||
-	   (anb->has_bufferView == 0) ||
-	   (avb->has_bufferView == 0))
+	// the converted part is kept in one block since the
+	// glTF file is closed after loading
+	uint32_t ic = loader->ic;
+	uint32_t vc = loader->vc;
+	float*   vb;
+	vb = (float*)
+	     popcorn_memory_calloc(POPCORN_MEMORY_TAG_PART, 1,
+	                           24*((size_t) vc) +
+	                           2*((size_t) ic));
+	if(vb == NULL)
 	{
-		LOGE("invalid bufferView=%u,%u,%u",
-		     (uint32_t) aib->has_bufferView,
-		     (uint32_t) anb->has_bufferView,
-		     (uint32_t) avb->has_bufferView);
-		return NULL;
+		LOGE("CALLOC failed");
+		goto fail_vb;
 	}
 
-	// get bufferViews
-	gltf_bufferView_t* bvib;
-	gltf_bufferView_t* bvnb;
-	gltf_bufferView_t* bvvb;
-	bvib = gltf_file_getBufferView(file, aib->bufferView);
-	bvnb = gltf_file_getBufferView(file, anb->bufferView);
-	bvvb = gltf_file_getBufferView(file, avb->bufferView);
-	if((bvib == NULL) || (bvnb == NULL) || (bvvb == NULL))
+	self->vb = vb;
+	self->nb = &vb[3*vc];
+	self->ib = (uint16_t*) &vb[6*vc];
+	memcpy(self->vb, loader->vb, 12*((size_t) vc));
+	memcpy(self->nb, loader->nb, 12*((size_t) vc));
+	memcpy(self->ib, loader->ib, 2*((size_t) ic));
+
+	// glTF primitives have no LOD chain and the part is
+	// not resident until it is streamed
+	self->ic   = ic;
+	self->vc   = vc;
+	self->node = node;
+	self->mask = popcorn_lod_mask(0, 1);
+
+	// success
+	return self;
+
+	// failure
+	fail_vb:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+static void
+popcorn_part_bound(popcorn_part_t* self,
+                   const cc_mat4f_t* world,
+                   const float* lo, const float* hi)
+{
+	ASSERT(self);
+	ASSERT(world);
+	ASSERT(lo);
+	ASSERT(hi);
+
+	// bound the box in the rest pose
+	float min[3];
+	float max[3];
+	int   i;
+	for(i = 0; i < 3; ++i)
 	{
-		LOGE("invalid bufferView=%p,%p,%p",
-		     bvib, bvnb, bvvb);
-		return NULL;
+		min[i] = INFINITY;
+		max[i] = -INFINITY;
 	}
 
-	// disallow byteStride
-	if(bvib->has_byteStride ||
-	   bvnb->has_byteStride ||
-	   bvvb->has_byteStride)
+	for(i = 0; i < 8; ++i)
 	{
-		LOGE("invalid byteStride=%u,%u,%u",
-		     (uint32_t) bvib->has_byteStride,
-		     (uint32_t) bvnb->has_byteStride,
-		     (uint32_t) bvvb->has_byteStride);
-		return NULL;
+		cc_vec4f_t p =
+		{
+			.x = (i & 1) ? hi[0] : lo[0],
+			.y = (i & 2) ? hi[1] : lo[1],
+			.z = (i & 4) ? hi[2] : lo[2],
+			.w = 1.0f,
+		};
+		cc_mat4f_mulv(world, &p);
+
+		float q[3] = { p.x, p.y, p.z };
+		int   c;
+		for(c = 0; c < 3; ++c)
+		{
+			if(q[c] < min[c])
+			{
+				min[c] = q[c];
+			}
+			if(q[c] > max[c])
+			{
+				max[c] = q[c];
+			}
+		}
 	}
 
-	// get buffers
-	const char* bib = gltf_file_getBuffer(file, bvib);
-	const char* bnb = gltf_file_getBuffer(file, bvnb);
-	const char* bvb = gltf_file_getBuffer(file, bvvb);
-	if((bib == NULL) || (bnb == NULL) || (bvb == NULL))
+	float dx = max[0] - min[0];
+	float dy = max[1] - min[1];
+	float dz = max[2] - min[2];
+	self->center[0] = 0.5f*(min[0] + max[0]);
+	self->center[1] = 0.5f*(min[1] + max[1]);
+	self->center[2] = 0.5f*(min[2] + max[2]);
+	self->radius    = 0.5f*sqrtf(dx*dx + dy*dy + dz*dz);
+}
+
+static void
+popcorn_part_boundGltf(popcorn_part_t* self,
+                       const cc_mat4f_t* world)
+{
+	ASSERT(self);
+	ASSERT(world);
+
+	float    lo[3] = {  INFINITY,  INFINITY,  INFINITY };
+	float    hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+	uint32_t i;
+	int      c;
+	for(i = 0; i < self->vc; ++i)
 	{
-		LOGE("invalid buffers=%p,%p,%p",
-		     bib, bnb, bvb);
-		return NULL;
+		for(c = 0; c < 3; ++c)
+		{
+			float x = self->vb[3*i + c];
+			if(x < lo[c])
+			{
+				lo[c] = x;
+			}
+			if(x > hi[c])
+			{
+				hi[c] = x;
+			}
+		}
 	}
 
+	popcorn_part_bound(self, world, lo, hi);
+}
+
+static popcorn_part_t*
+popcorn_part_newMesh(const popcorn_meshPart_t* mp,
+                     size_t offset,
+                     const cc_mat4f_t* world)
+{
+	ASSERT(mp);
+	ASSERT(world);
+
 	popcorn_part_t* self;
 	self = (popcorn_part_t*)
-	       CALLOC(1, sizeof(popcorn_part_t));
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_PART,
+	                             1, sizeof(popcorn_part_t));
 	if(self == NULL)
 	{
 		LOGE("CALLOC failed");
 		return NULL;
 	}
 
-	self->ic = aib->count;
-	self->ib = vkk_buffer_new(engine,
-	                          VKK_UPDATE_MODE_STATIC,
-	                          VKK_BUFFER_USAGE_INDEX,
-	                          bvib->byteLength,
-	                          bib);
-	if(self->ib == NULL)
+	// the part is not resident until it is streamed
+	self->ic     = mp->ic;
+	self->vc     = mp->vc;
+	self->node   = mp->node;
+	self->mask   = popcorn_lod_mask(mp->lod, mp->lods);
+	self->offset = offset;
+
+	// bound the quantized box
+	float hi[3];
+	int   i;
+	for(i = 0; i < 3; ++i)
 	{
-		goto fail_ib;
+		hi[i] = mp->offset[i] + 65535.0f*mp->scale[i];
 	}
+	popcorn_part_bound(self, world, mp->offset, hi);
 
-	self->vbnb[0] = vkk_buffer_new(engine,
-	                               VKK_UPDATE_MODE_STATIC,
-	                               VKK_BUFFER_USAGE_VERTEX,
-	                               bvvb->byteLength,
-	                               bvb);
-	if(self->vbnb[0] == NULL)
-	{
-		goto fail_vb;
-	}
+	return self;
+}
 
-	self->vbnb[1] = vkk_buffer_new(engine,
-	                               VKK_UPDATE_MODE_STATIC,
-	                               VKK_BUFFER_USAGE_VERTEX,
-	                               bvnb->byteLength,
-	                               bnb);
-	if(self->vbnb[1] == NULL)
-	{
-		goto fail_nb;
-	}
+static int popcorn_part_streamed(popcorn_part_t* self)
+{
+	ASSERT(self);
 
-	// success
-	return self;
+	return (self->offset || self->vb) ? 1 : 0;
+}
 
-	// failure
-	fail_nb:
-		vkk_buffer_delete(&self->vbnb[0]);
-	fail_vb:
-		vkk_buffer_delete(&self->ib);
-	fail_ib:
-		FREE(self);
-	return NULL;
+static void popcorn_part_drop(popcorn_part_t* self)
+{
+	ASSERT(self);
+
+	// the part is no longer streamed or drawn
+	popcorn_memory_free(self->vb);
+	self->offset = 0;
+	self->ib     = NULL;
+	self->vb     = NULL;
+	self->nb     = NULL;
+}
+
+static size_t popcorn_part_size(popcorn_part_t* self)
+{
+	ASSERT(self);
+
+	// vertex, normal and node id buffers and indices
+	return 28*((size_t) self->vc) + 2*((size_t) self->ic);
+}
+
+static int
+popcorn_part_visible(popcorn_part_t* self,
+                     const cc_mat4f_t* mvm,
+                     float tx, float ty)
+{
+	ASSERT(self);
+	ASSERT(mvm);
+
+	cc_vec4f_t p =
+	{
+		.x = self->center[0],
+		.y = self->center[1],
+		.z = self->center[2],
+		.w = 1.0f,
+	};
+	cc_mat4f_mulv(mvm, &p);
+
+	// test the sphere against the side planes of the
+	// view which looks down -z
+	float r = self->radius;
+	float d = -p.z;
+	if((d + r < 0.0f) ||
+	   (fabsf(p.x) > tx*d + r*sqrtf(1.0f + tx*tx)) ||
+	   (fabsf(p.y) > ty*d + r*sqrtf(1.0f + ty*ty)))
+	{
+		return 0;
+	}
+	return 1;
 }
 
-static void popcorn_part_delete(popcorn_part_t** _self)
+static void
+popcorn_part_delete(popcorn_arena_t* arena,
+                    popcorn_part_t** _self)
 {
+	ASSERT(arena);
 	ASSERT(_self);
 
 	popcorn_part_t* self = *_self;
 	if(self)
 	{
-		vkk_buffer_delete(&self->vbnb[1]);
-		vkk_buffer_delete(&self->vbnb[0]);
-		vkk_buffer_delete(&self->ib);
-		FREE(self);
+		popcorn_arena_free(arena, &self->alloc);
+		popcorn_memory_free(self->vb);
+		popcorn_memory_free(self);
 		*_self = NULL;
 	}
 }
 
 static int
 popcorn_cockpit_parseNode(popcorn_cockpit_t* self,
+                          popcorn_gltf_t* loader,
                           gltf_file_t* file,
-                          gltf_node_t* node)
+                          uint32_t id, int32_t parent,
+                          uint32_t depth)
 {
 	ASSERT(self);
+	ASSERT(loader);
 	ASSERT(file);
-	ASSERT(node);
 
-	gltf_mesh_t* mesh;
-	mesh = gltf_file_getMesh(file, node->mesh);
-	if(mesh == NULL)
+	gltf_node_t* node = gltf_file_getNode(file, id);
+	if((node == NULL) || (depth >= POPCORN_GLTF_DEPTH))
+	{
+		LOGE("invalid node=%u, depth=%u", id, depth);
+		return 0;
+	}
+
+	// nodes are added in preorder
+	cc_mat4f_t local;
+	popcorn_gltf_local(node, &local);
+
+	int idx = popcorn_scene_add(self->scene, parent, &local);
+	if(idx < 0)
 	{
 		return 0;
 	}
 
 	popcorn_part_t* part;
 
-	cc_listIter_t* iter;
-	iter = cc_list_head(mesh->primitives);
+	cc_listIter_t* iter = NULL;
+	if(node->has_mesh)
+	{
+		gltf_mesh_t* mesh;
+		mesh = gltf_file_getMesh(file, node->mesh);
+		if(mesh == NULL)
+		{
+			return 0;
+		}
+
+		iter = cc_list_head(mesh->primitives);
+	}
+
 	while(iter)
 	{
 		gltf_primitive_t* primitive;
 		primitive = (gltf_primitive_t*) cc_list_peekIter(iter);
 
-		// require indexed triangles
-		if((primitive->has_indices == 0) ||
-		   (primitive->mode != GLTF_PRIMITIVE_MODE_TRIANGLES))
+		// points and lines are skipped with a warning
+		if(popcorn_gltf_isTriangles(primitive) == 0)
 		{
-			// ignore
 			iter = cc_list_next(iter);
 			continue;
 		}
 
-		part = popcorn_part_new(self->engine, file, primitive);
+		part = popcorn_part_newGltf((uint32_t) idx, loader,
+		                            file, primitive);
 		if(part == NULL)
 		{
 			return 0;
@@ -264,21 +422,38 @@ popcorn_cockpit_parseNode(popcorn_cockpit_t* self,
 		iter = cc_list_next(iter);
 	}
 
+	iter = cc_list_head(node->children);
+	while(iter)
+	{
+		uint32_t* child = (uint32_t*) cc_list_peekIter(iter);
+		if(popcorn_cockpit_parseNode(self, loader,
+		                             file, *child,
+		                             (int32_t) idx,
+		                             depth + 1) == 0)
+		{
+			return 0;
+		}
+
+		iter = cc_list_next(iter);
+	}
+
 	// success
 	return 1;
 
 	// failure
 	fail_append:
-		popcorn_part_delete(&part);
+		popcorn_part_delete(self->arena, &part);
 	return 0;
 }
 
 static int
 popcorn_cockpit_parseScene(popcorn_cockpit_t* self,
+                           popcorn_gltf_t* loader,
                            gltf_file_t* file,
                            gltf_scene_t* scene)
 {
 	ASSERT(self);
+	ASSERT(loader);
 	ASSERT(file);
 	ASSERT(scene);
 
@@ -286,21 +461,10 @@ popcorn_cockpit_parseScene(popcorn_cockpit_t* self,
 	while(iter)
 	{
 		uint32_t* nd = (uint32_t*) cc_list_peekIter(iter);
-
-		gltf_node_t* node = gltf_file_getNode(file, *nd);
-		if(node == NULL)
-		{
-			return 0;
-		}
-
-		// ignore nodes w/o a mesh
-		if(node->has_mesh == 0)
-		{
-			iter = cc_list_next(iter);
-			continue;
-		}
-
-		if(popcorn_cockpit_parseNode(self, file, node) == 0)
+		if(popcorn_cockpit_parseNode(self, loader,
+		                             file, *nd,
+		                             POPCORN_SCENE_ROOT,
+		                             0) == 0)
 		{
 			return 0;
 		}
@@ -313,9 +477,11 @@ popcorn_cockpit_parseScene(popcorn_cockpit_t* self,
 
 static int
 popcorn_cockpit_parseFile(popcorn_cockpit_t* self,
+                          popcorn_gltf_t* loader,
                           gltf_file_t* file)
 {
 	ASSERT(self);
+	ASSERT(loader);
 	ASSERT(file);
 
 	gltf_scene_t* scene;
@@ -325,25 +491,617 @@ popcorn_cockpit_parseFile(popcorn_cockpit_t* self,
 		return 0;
 	}
 
-	return popcorn_cockpit_parseScene(self, file, scene);
+	return popcorn_cockpit_parseScene(self, loader, file,
+	                                  scene);
+}
+
+static int
+popcorn_cockpit_loadGltf(popcorn_cockpit_t* self,
+                         popcorn_startup_t* startup,
+                         FILE* f, size_t size)
+{
+	ASSERT(self);
+	ASSERT(startup);
+	ASSERT(f);
+
+	// the fallback is not mapped since libgltf reads the
+	// whole model into the heap
+	gltf_file_t* file = gltf_file_openf(f, size);
+	if(file == NULL)
+	{
+		return 0;
+	}
+	popcorn_startup_mark(startup, "cockpit.gltf_file_openf");
+
+	popcorn_gltf_t* loader = popcorn_gltf_new();
+	if(loader == NULL)
+	{
+		goto fail_loader;
+	}
+
+	// parts are timed as a single phase since large
+	// models would overflow the startup table
+	if(popcorn_cockpit_parseFile(self, loader, file) == 0)
+	{
+		goto fail_parse;
+	}
+
+	// the rest pose places the part bounds for residency
+	popcorn_scene_update(self->scene);
+
+	cc_listIter_t* iter = cc_list_head(self->parts);
+	while(iter)
+	{
+		popcorn_part_t* part;
+		part = (popcorn_part_t*) cc_list_peekIter(iter);
+		popcorn_part_boundGltf(part,
+		                       popcorn_scene_world(self->scene,
+		                                           part->node));
+
+		iter = cc_list_next(iter);
+	}
+	popcorn_startup_mark(startup, "cockpit.parts");
+
+	popcorn_gltf_delete(&loader);
+	gltf_file_close(&file);
+
+	// success
+	return 1;
+
+	// failure
+	fail_parse:
+		popcorn_gltf_delete(&loader);
+	fail_loader:
+		gltf_file_close(&file);
+	return 0;
 }
 
+static int
+popcorn_cockpit_loadMesh(popcorn_cockpit_t* self,
+                         popcorn_startup_t* startup,
+                         const void* buf, size_t size)
+{
+	ASSERT(self);
+	ASSERT(startup);
+	ASSERT(buf);
+
+	// the mesh is inflated directly from the pak mapping
+	popcorn_mesh_t* mesh = popcorn_mesh_new(buf, size);
+	if(mesh == NULL)
+	{
+		return 0;
+	}
+
+	// the node table is stored in preorder
+	uint32_t i;
+	for(i = 0; i < mesh->nodes; ++i)
+	{
+		popcorn_meshNode_t* node = &mesh->node[i];
+
+		cc_mat4f_t local;
+		memcpy(&local, node->local, sizeof(cc_mat4f_t));
+		if(popcorn_scene_add(self->scene, node->parent,
+		                     &local) < 0)
+		{
+			goto fail_node;
+		}
+	}
+
+	// the rest pose places the part bounds for LOD
+	// selection and residency
+	popcorn_scene_update(self->scene);
+
+	// only the part headers are read since parts are
+	// decoded when they are first needed
+	popcorn_part_t* part;
+	for(i = 0; i < mesh->count; ++i)
+	{
+		size_t offset = mesh->offset;
+		if(popcorn_mesh_skip(mesh) == 0)
+		{
+			goto fail_skip;
+		}
+
+		popcorn_meshPart_t* mp = &mesh->part;
+
+		const cc_mat4f_t* world;
+		world = popcorn_scene_world(self->scene, mp->node);
+		part  = popcorn_part_newMesh(mp, offset, world);
+		if(part == NULL)
+		{
+			goto fail_part;
+		}
+
+		float max[3];
+		int   c;
+		for(c = 0; c < 3; ++c)
+		{
+			max[c] = mp->offset[c] + 65535.0f*mp->scale[c];
+		}
+		popcorn_lod_add(&self->lod, mp->lod, mp->lods,
+		                mp->error, world, mp->offset, max);
+
+		if(cc_list_append(self->parts, NULL,
+		                  (const void*) part) == NULL)
+		{
+			goto fail_append;
+		}
+	}
+	popcorn_startup_mark(startup, "cockpit.parts");
+
+	self->mesh = mesh;
+
+	// success
+	return 1;
+
+	// failure
+	fail_append:
+		popcorn_part_delete(self->arena, &part);
+	fail_part:
+	fail_skip:
+	fail_node:
+		popcorn_mesh_delete(&mesh);
+	return 0;
+}
+
+static int
+popcorn_cockpit_loadInstruments(popcorn_cockpit_t* self,
+                                popcorn_startup_t* startup)
+{
+	ASSERT(self);
+	ASSERT(startup);
+
+	uint16_t ib[POPCORN_INSTRUMENT_IC];
+	float    vb[3*POPCORN_INSTRUMENT_VC];
+	float    nb[3*POPCORN_INSTRUMENT_VC];
+
+	// instruments are root nodes in their rest pose
+	popcorn_part_t* part;
+	int             i;
+	for(i = 0; i < POPCORN_INSTRUMENT_COUNT; ++i)
+	{
+		popcorn_instrumentType_e type;
+		type = (popcorn_instrumentType_e) i;
+
+		float      value[2] = { 0.0f, 0.0f };
+		cc_mat4f_t local;
+		popcorn_instrument_local(type, value, &local);
+
+		int node = popcorn_scene_add(self->scene,
+		                             POPCORN_SCENE_ROOT,
+		                             &local);
+		if(node < 0)
+		{
+			return 0;
+		}
+
+		popcorn_instrument_init(&self->instrument[i], type,
+		                        (uint32_t) node);
+		popcorn_instrument_box(type, ib, vb, nb);
+
+		part = popcorn_part_new(self->arena, (uint32_t) node,
+		                        popcorn_lod_mask(0, 1),
+		                        POPCORN_INSTRUMENT_IC, ib,
+		                        POPCORN_INSTRUMENT_VC, vb, nb);
+		if(part == NULL)
+		{
+			return 0;
+		}
+
+		if(cc_list_append(self->parts, NULL,
+		                  (const void*) part) == NULL)
+		{
+			goto fail_append;
+		}
+	}
+	popcorn_startup_mark(startup, "cockpit.instruments");
+
+	// success
+	return 1;
+
+	// failure
+	fail_append:
+		popcorn_part_delete(self->arena, &part);
+	return 0;
+}
+
+static void
+popcorn_cockpit_view(cc_mat4f_t* mvm, float rx, float ry)
+{
+	ASSERT(mvm);
+
+	cc_mat4f_lookat(mvm, 1,
+	                0.0f, 0.0f, 0.0f,
+	                0.0f, 1.0f, 0.0f,
+	                0.0f, 0.0f, 1.0f);
+	cc_mat4f_rotate(mvm, 0, -rx, 0.0f, 0.0f, 1.0f);
+	cc_mat4f_rotate(mvm, 0, ry, 1.0f, 0.0f, 0.0f);
+}
+
+static int
+popcorn_cockpit_load(popcorn_cockpit_t* self,
+                     popcorn_part_t* part)
+{
+	ASSERT(self);
+	ASSERT(part);
+
+	// glTF parts are copied from the host and mesh parts
+	// are decoded into the reserved mesh scratch
+	const uint16_t* ib = part->ib;
+	const float*    vb = part->vb;
+	const float*    nb = part->nb;
+	if(part->offset)
+	{
+		popcorn_mesh_t* mesh = self->mesh;
+		if((popcorn_mesh_seek(mesh, part->offset) == 0) ||
+		   (popcorn_mesh_next(mesh) == 0))
+		{
+			return 0;
+		}
+
+		popcorn_meshPart_t* mp = &mesh->part;
+		if((mp->ic != part->ic) || (mp->vc != part->vc))
+		{
+			LOGE("invalid ic=%u, vc=%u", mp->ic, mp->vc);
+			return 0;
+		}
+
+		ib = mesh->ib;
+		vb = mesh->vb;
+		nb = mesh->nb;
+	}
+
+	// the arena copies the part into its staging pages
+	// which are uploaded by popcorn_arena_flush
+	part->alloc = popcorn_arena_alloc(self->arena, part->node,
+	                                  part->mask, part->ic, ib,
+	                                  part->vc, vb, nb);
+	if(part->alloc == NULL)
+	{
+		return 0;
+	}
+
+	self->resident += popcorn_part_size(part);
+	++self->loads;
+
+	return 1;
+}
+
+static void
+popcorn_cockpit_evict(popcorn_cockpit_t* self,
+                      popcorn_part_t* part)
+{
+	ASSERT(self);
+	ASSERT(part);
+
+	popcorn_arena_free(self->arena, &part->alloc);
+	self->resident -= popcorn_part_size(part);
+	++self->evictions;
+}
+
+static popcorn_part_t*
+popcorn_cockpit_lru(popcorn_cockpit_t* self, uint32_t mask)
+{
+	ASSERT(self);
+
+	// the least recently needed resident part of the
+	// mask (or of any mask when 0) which is not needed
+	// by the current frame
+	popcorn_part_t* lru = NULL;
+
+	cc_listIter_t* iter = cc_list_head(self->parts);
+	while(iter)
+	{
+		popcorn_part_t* part;
+		part = (popcorn_part_t*) cc_list_peekIter(iter);
+		if(popcorn_part_streamed(part) && part->alloc &&
+		   ((mask == 0) || (part->mask == mask)) &&
+		   (part->frame != self->frame) &&
+		   ((lru == NULL) || (part->frame < lru->frame)))
+		{
+			lru = part;
+		}
+
+		iter = cc_list_next(iter);
+	}
+
+	return lru;
+}
+
+static int
+popcorn_cockpit_fit(popcorn_cockpit_t* self,
+                    popcorn_part_t* part)
+{
+	ASSERT(self);
+	ASSERT(part);
+
+	// parts of the same levels are evicted until the part
+	// fits in the pages reserved for its levels
+	while(popcorn_arena_fit(self->arena, part->mask,
+	                        part->vc, part->ic) == 0)
+	{
+		popcorn_part_t* lru;
+		lru = popcorn_cockpit_lru(self, part->mask);
+		if(lru == NULL)
+		{
+			return 0;
+		}
+		popcorn_cockpit_evict(self, lru);
+	}
+
+	return 1;
+}
+
+static int popcorn_cockpit_reserve(popcorn_cockpit_t* self)
+{
+	ASSERT(self);
+
+	// the arena pages, allocation records and mesh scratch
+	// used by streaming are created at startup so that the
+	// steady state frames never allocate
+	// see popcorn_memory_steady
+	uint64_t vc[1 << POPCORN_LOD_MAX];
+	uint64_t ic[1 << POPCORN_LOD_MAX];
+	uint32_t max_vc[1 << POPCORN_LOD_MAX];
+	uint32_t max_ic[1 << POPCORN_LOD_MAX];
+	uint32_t count[1 << POPCORN_LOD_MAX];
+	memset(vc,     0, sizeof(vc));
+	memset(ic,     0, sizeof(ic));
+	memset(max_vc, 0, sizeof(max_vc));
+	memset(max_ic, 0, sizeof(max_ic));
+	memset(count,  0, sizeof(count));
+
+	cc_listIter_t* iter = cc_list_head(self->parts);
+	while(iter)
+	{
+		popcorn_part_t* part;
+		part = (popcorn_part_t*) cc_list_peekIter(iter);
+		iter = cc_list_next(iter);
+
+		if(popcorn_part_streamed(part) == 0)
+		{
+			continue;
+		}
+
+		// include the worst case alignment padding
+		uint32_t m = part->mask;
+		vc[m] += part->vc + POPCORN_ARENA_ALIGN_VERTICES;
+		ic[m] += part->ic + POPCORN_ARENA_ALIGN_INDICES;
+		if(part->vc > max_vc[m])
+		{
+			max_vc[m] = part->vc;
+		}
+		if(part->ic > max_ic[m])
+		{
+			max_ic[m] = part->ic;
+		}
+		++count[m];
+	}
+
+	// the resident parts of the levels of a mask never
+	// exceed the budget
+	uint32_t part_vc = 0;
+	uint32_t part_ic = 0;
+	uint32_t m;
+	for(m = 0; m < (1 << POPCORN_LOD_MAX); ++m)
+	{
+		if(count[m] == 0)
+		{
+			continue;
+		}
+
+		uint64_t size = 28*vc[m] + 2*ic[m];
+		if(size > POPCORN_COCKPIT_BUDGET)
+		{
+			vc[m] = (vc[m]*POPCORN_COCKPIT_BUDGET)/size;
+			ic[m] = (ic[m]*POPCORN_COCKPIT_BUDGET)/size;
+		}
+
+		if(vc[m] < max_vc[m])
+		{
+			vc[m] = max_vc[m];
+		}
+		if(ic[m] < max_ic[m])
+		{
+			ic[m] = max_ic[m];
+		}
+
+		if(popcorn_arena_reserve(self->arena, m,
+		                         (uint32_t) vc[m],
+		                         (uint32_t) ic[m],
+		                         count[m]) == 0)
+		{
+			return 0;
+		}
+
+		if(max_vc[m] > part_vc)
+		{
+			part_vc = max_vc[m];
+		}
+		if(max_ic[m] > part_ic)
+		{
+			part_ic = max_ic[m];
+		}
+	}
+
+	if(self->mesh)
+	{
+		return popcorn_mesh_reserve(self->mesh, part_ic,
+		                            part_vc);
+	}
+
+	return 1;
+}
+
+static void
+popcorn_cockpit_stream(popcorn_cockpit_t* self,
+                       uint32_t level,
+                       float fovy, float aspect,
+                       float rx, float ry)
+{
+	ASSERT(self);
+
+	// parts are needed by the current level when they
+	// intersect the current or predicted head direction
+	// where the prediction extrapolates the head motion
+	// of the last frame
+	cc_mat4f_t mvm;
+	cc_mat4f_t pmvm;
+	popcorn_cockpit_view(&mvm, rx, ry);
+	popcorn_cockpit_view(&pmvm,
+	                     rx + POPCORN_COCKPIT_PREDICT*(rx - self->rx),
+	                     ry + POPCORN_COCKPIT_PREDICT*(ry - self->ry));
+	self->rx = rx;
+	self->ry = ry;
+
+	float ty = POPCORN_COCKPIT_GUARD*
+	           tanf(0.5f*fovy*((float) M_PI)/180.0f);
+	float tx = aspect*ty;
+
+	// the first frame loads every visible part and later
+	// frames are limited to spread the decode cost
+	uint32_t frame    = ++self->frame;
+	uint32_t streamed = 0;
+	self->pending     = 0;
+
+	// mark the parts needed by this frame before loading
+	// so a load never evicts a part needed by this frame
+	cc_listIter_t* iter = cc_list_head(self->parts);
+	while(iter)
+	{
+		popcorn_part_t* part;
+		part = (popcorn_part_t*) cc_list_peekIter(iter);
+		if(popcorn_part_streamed(part) &&
+		   (part->mask & (1 << level)) &&
+		   (popcorn_part_visible(part, &mvm,  tx, ty) ||
+		    popcorn_part_visible(part, &pmvm, tx, ty)))
+		{
+			part->frame = frame;
+		}
+
+		iter = cc_list_next(iter);
+	}
+
+	iter = cc_list_head(self->parts);
+	while(iter)
+	{
+		popcorn_part_t* part;
+		part = (popcorn_part_t*) cc_list_peekIter(iter);
+		iter = cc_list_next(iter);
+
+		if((part->frame != frame) || part->alloc)
+		{
+			continue;
+		}
+
+		if((frame > 1) && (streamed >= POPCORN_COCKPIT_STREAM))
+		{
+			++self->pending;
+			continue;
+		}
+
+		// parts which do not fit in the reserved pages are
+		// deferred rather than growing the arena
+		if(popcorn_cockpit_fit(self, part) == 0)
+		{
+			++self->deferred;
+			continue;
+		}
+
+		// parts which fail to load are dropped
+		double t0 = cc_timestamp();
+		if(popcorn_cockpit_load(self, part) == 0)
+		{
+			LOGE("invalid part node=%u", part->node);
+			popcorn_part_drop(part);
+			continue;
+		}
+		streamed += part->vc;
+
+		double dt = cc_timestamp() - t0;
+		if(self->loads == 1)
+		{
+			self->upload_t0 = t0;
+		}
+		if(dt > self->upload_max)
+		{
+			self->upload_max = dt;
+		}
+		self->upload_dt += dt;
+	}
+
+	// evict the least recently needed parts over the
+	// budget but never the parts needed by this frame
+	while(self->resident > POPCORN_COCKPIT_BUDGET)
+	{
+		popcorn_part_t* lru = popcorn_cockpit_lru(self, 0);
+		if(lru == NULL)
+		{
+			break;
+		}
+		popcorn_cockpit_evict(self, lru);
+	}
+
+	// upload the pages changed by loads and evictions
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(self->engine);
+	double t0 = cc_timestamp();
+	popcorn_arena_flush(self->arena, rend);
+	self->upload_dt += cc_timestamp() - t0;
+}
+
+static void popcorn_cockpit_report(popcorn_cockpit_t* self)
+{
+	ASSERT(self);
+
+	int idx = 0;
+
+	cc_listIter_t* iter = cc_list_head(self->parts);
+	while(iter)
+	{
+		popcorn_part_t* part;
+		part = (popcorn_part_t*) cc_list_peekIter(iter);
+
+		LOGI("part=%i, node=%u, mask=0x%X, ic=%u, vc=%u, offset=%u, resident=%i",
+		     idx, part->node, part->mask, part->ic, part->vc,
+		     (uint32_t) part->offset, part->alloc ? 1 : 0);
+
+		++idx;
+		iter = cc_list_next(iter);
+	}
+
+	LOGI("cockpit nodes=%u, parts=%i",
+	     self->scene->count, idx);
+
+	uint32_t i;
+	for(i = 0; i < self->lod.count; ++i)
+	{
+		LOGI("lod=%u, error=%f", i, self->lod.error[i]);
+	}
+	popcorn_arena_report(self->arena);
+}
 
 /***********************************************************
 * public                                                   *
 ***********************************************************/
 
 popcorn_cockpit_t*
-popcorn_cockpit_new(vkk_engine_t* engine)
+popcorn_cockpit_new(vkk_engine_t* engine,
+                    popcorn_view_t* view,
+                    popcorn_shader_t* shader,
+                    popcorn_startup_t* startup)
 {
 	ASSERT(engine);
+	ASSERT(shader);
+	ASSERT(startup);
 
 	vkk_renderer_t* rend;
 	rend = vkk_engine_defaultRenderer(engine);
 
 	popcorn_cockpit_t* self;
 	self = (popcorn_cockpit_t*)
-	       CALLOC(1, sizeof(popcorn_cockpit_t));
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_COCKPIT,
+	                             1, sizeof(popcorn_cockpit_t));
 	if(self == NULL)
 	{
 		LOGE("CALLOC failed");
@@ -369,18 +1127,21 @@ popcorn_cockpit_new(vkk_engine_t* engine)
 	{
 		goto fail_usf0;
 	}
+	popcorn_startup_mark(startup, "cockpit.usf");
 
 	vkk_uniformSetFactory_t* usf_array[] =
 	{
 		self->usf0,
+		view->usf1,
 	};
 
 	self->pl = vkk_pipelineLayout_new(engine,
-	                                  1, usf_array);
+	                                  2, usf_array);
 	if(self->pl == NULL)
 	{
 		goto fail_pl;
 	}
+	popcorn_startup_mark(startup, "cockpit.pl");
 
 	vkk_vertexBufferInfo_t vbi[] =
 	{
@@ -396,15 +1157,31 @@ popcorn_cockpit_new(vkk_engine_t* engine)
 			.components = 3,
 			.format     = VKK_VERTEX_FORMAT_FLOAT
 		},
+		// layout(location=2) in uint node;
+		{
+			.location   = 2,
+			.components = 1,
+			.format     = VKK_VERTEX_FORMAT_UINT
+		},
 	};
 
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(shader, "cockpit.vert", 0);
+	fs = popcorn_shader_lookup(shader, "cockpit.frag",
+	                           POPCORN_SHADER_FEATURE_LIGHTING);
+	if((vs == NULL) || (fs == NULL))
+	{
+		goto fail_gp;
+	}
+
 	vkk_graphicsPipelineInfo_t gpi =
 	{
 		.renderer          = rend,
 		.pl                = self->pl,
-		.vs                = "shaders/cockpit_vert.spv",
-		.fs                = "shaders/cockpit_frag.spv",
-		.vb_count          = 2,
+		.vs                = vs,
+		.fs                = fs,
+		.vb_count          = 3,
 		.vbi               = vbi,
 		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
 		.primitive_restart = 0,
@@ -414,16 +1191,18 @@ popcorn_cockpit_new(vkk_engine_t* engine)
 		.blend_mode        = VKK_BLEND_MODE_DISABLED
 	};
 
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
 	self->gp = vkk_graphicsPipeline_new(engine, &gpi);
 	if(self->gp == NULL)
 	{
 		goto fail_gp;
 	}
+	popcorn_startup_mark(startup, "cockpit.gp");
 
 	self->ub00_mvp = vkk_buffer_new(engine,
 	                                VKK_UPDATE_MODE_ASYNCHRONOUS,
 	                                VKK_BUFFER_USAGE_UNIFORM,
-	                                sizeof(cc_mat4f_t),
+	                                sizeof(popcorn_cockpitUniform_t),
 	                                NULL);
 	if(self->ub00_mvp == NULL)
 	{
@@ -447,12 +1226,26 @@ popcorn_cockpit_new(vkk_engine_t* engine)
 	{
 		goto fail_us0;
 	}
+	popcorn_startup_mark(startup, "cockpit.buffers");
+
+	self->arena = popcorn_arena_new(engine);
+	if(self->arena == NULL)
+	{
+		goto fail_arena;
+	}
 
 	self->parts = cc_list_new();
 	if(self->parts == NULL)
 	{
 		goto fail_parts;
 	}
+	popcorn_lod_init(&self->lod);
+
+	self->scene = popcorn_scene_new();
+	if(self->scene == NULL)
+	{
+		goto fail_scene;
+	}
 
 	char fname[256];
 	snprintf(fname, 256, "%s/resource.pak",
@@ -464,51 +1257,97 @@ popcorn_cockpit_new(vkk_engine_t* engine)
 	{
 		goto fail_open;
 	}
+	popcorn_startup_mark(startup, "cockpit.pak_file_open");
+
+	// prefer the compressed mesh and fall back to glTF
+	// for paks built without popcorn_meshc
+	// the mapping is kept to stream the mesh parts
+	int loaded;
+	self->map = popcorn_pakmap_new(pak, "models/bat-rider.pcm");
+	if(self->map)
+	{
+		popcorn_startup_mark(startup, "cockpit.pakmap");
+		loaded = popcorn_cockpit_loadMesh(self, startup,
+		                                  self->map->data,
+		                                  self->map->size);
+	}
+	else
+	{
+		size_t size;
+		size = pak_file_seek(pak, "models/bat-rider.glb");
+		if(size == 0)
+		{
+			LOGE("pak_file_seek failed");
+			goto fail_seek;
+		}
+		popcorn_startup_mark(startup, "cockpit.pak_file_seek");
+		loaded = popcorn_cockpit_loadGltf(self, startup,
+		                                  pak->f, size);
+	}
 
-	size_t size;
-	size = pak_file_seek(pak, "models/bat-rider.glb");
-	if(size == 0)
+	if((loaded == 0) ||
+	   (popcorn_cockpit_loadInstruments(self, startup) == 0))
 	{
-		LOGE("pak_file_seek failed");
-		goto fail_seek;
+		goto fail_load;
 	}
 
-	gltf_file_t* file = gltf_file_openf(pak->f, size);
-	if(file == NULL)
+	// the node matrices must fit in the uniform buffer
+	if(self->scene->count > POPCORN_COCKPIT_NODES)
 	{
-		goto fail_gltf;
+		LOGE("invalid nodes=%u", self->scene->count);
+		goto fail_nodes;
 	}
 
-	if(popcorn_cockpit_parseFile(self, file) == 0)
+	if(popcorn_cockpit_reserve(self) == 0)
 	{
-		goto fail_parse;
+		goto fail_reserve;
 	}
+	popcorn_startup_mark(startup, "cockpit.reserve");
+
+	self->mfd = popcorn_mfd_new(engine, view, shader, pak,
+	                            startup);
+	if(self->mfd == NULL)
+	{
+		goto fail_mfd;
+	}
+	popcorn_startup_mark(startup, "cockpit.mfd");
 
-	gltf_file_close(&file);
 	pak_file_close(&pak);
 
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_COCKPIT,
+	                        sizeof(popcorn_cockpitUniform_t));
+	popcorn_cockpit_report(self);
+
 	// success
 	return self;
 
 	// failure
-	fail_parse:
-		gltf_file_close(&file);
-	fail_gltf:
+	fail_mfd:
+	fail_reserve:
+	fail_nodes:
+	fail_load:
 	fail_seek:
 		pak_file_close(&pak);
 	fail_open:
 	{
+		popcorn_mesh_delete(&self->mesh);
+		popcorn_pakmap_delete(&self->map);
+
 		cc_listIter_t* iter = cc_list_head(self->parts);
 		while(iter)
 		{
 			popcorn_part_t* part;
 			part = (popcorn_part_t*)
 			       cc_list_remove(self->parts, &iter);
-			popcorn_part_delete(&part);
+			popcorn_part_delete(self->arena, &part);
 		}
-		cc_list_delete(&self->parts);
+		popcorn_scene_delete(&self->scene);
 	}
+	fail_scene:
+		cc_list_delete(&self->parts);
 	fail_parts:
+		popcorn_arena_delete(&self->arena);
+	fail_arena:
 		vkk_uniformSet_delete(&self->us0);
 	fail_us0:
 		vkk_buffer_delete(&self->ub00_mvp);
@@ -519,7 +1358,7 @@ popcorn_cockpit_new(vkk_engine_t* engine)
 	fail_pl:
 		vkk_uniformSetFactory_delete(&self->usf0);
 	fail_usf0:
-		FREE(self);
+		popcorn_memory_free(self);
 	return NULL;
 }
 
@@ -530,31 +1369,50 @@ void popcorn_cockpit_delete(popcorn_cockpit_t** _self)
 	popcorn_cockpit_t* self = *_self;
 	if(self)
 	{
+		LOGI("lod level=%u, switches=%u",
+		     self->lod.level, self->lod.switches);
+		LOGI("cockpit loads=%u, evictions=%u, deferred=%u, resident=%u",
+		     self->loads, self->evictions, self->deferred,
+		     (uint32_t) self->resident);
+
 		cc_listIter_t* iter = cc_list_head(self->parts);
 		while(iter)
 		{
 			popcorn_part_t* part;
 			part = (popcorn_part_t*)
 			       cc_list_remove(self->parts, &iter);
-			popcorn_part_delete(&part);
+			popcorn_part_delete(self->arena, &part);
 		}
 
+		popcorn_mfd_delete(&self->mfd);
+		popcorn_mesh_delete(&self->mesh);
+		popcorn_pakmap_delete(&self->map);
+		popcorn_scene_delete(&self->scene);
 		cc_list_delete(&self->parts);
+		popcorn_arena_delete(&self->arena);
 		vkk_uniformSet_delete(&self->us0);
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_COCKPIT,
+		                       sizeof(popcorn_cockpitUniform_t));
 		vkk_buffer_delete(&self->ub00_mvp);
 		vkk_graphicsPipeline_delete(&self->gp);
 		vkk_pipelineLayout_delete(&self->pl);
 		vkk_uniformSetFactory_delete(&self->usf0);
-		FREE(self);
+		popcorn_memory_free(self);
 		*_self = NULL;
 	}
 }
 
 void popcorn_cockpit_draw(popcorn_cockpit_t* self,
+                          popcorn_queue_t* queue,
+                          popcorn_view_t* view,
+                          const popcorn_flightState_t* state,
                           float fovy, float aspect,
                           float rx, float ry)
 {
 	ASSERT(self);
+	ASSERT(queue);
+	ASSERT(view);
+	ASSERT(state);
 
 	vkk_engine_t* engine = self->engine;
 
@@ -564,42 +1422,93 @@ void popcorn_cockpit_draw(popcorn_cockpit_t* self,
 	float      near = 0.001f;
 	float      far  = 1000.0f;
 	cc_mat4f_t pm;
-	cc_mat4f_t mvp;
 	cc_mat4f_t mvm;
 	cc_mat4f_perspective(&pm, 1,
 	                     fovy, aspect,
 	                     near, far);
-	cc_mat4f_lookat(&mvm, 1,
-	                0.0f, 0.0f, 0.0f,
-	                0.0f, 1.0f, 0.0f,
-	                0.0f, 0.0f, 1.0f);
-	cc_mat4f_rotate(&mvm, 0, -rx, 0.0f, 0.0f, 1.0f);
-	cc_mat4f_rotate(&mvm, 0, ry, 1.0f, 0.0f, 0.0f);
-	cc_mat4f_mulm_copy(&pm, &mvm, &mvp);
+	popcorn_cockpit_view(&mvm, rx, ry);
+
+	popcorn_cockpitUniform_t* uniform = &self->uniform;
 
-	vkk_uniformSet_t* us_array[] =
+	uint32_t v;
+	for(v = 0; v < view->count; ++v)
 	{
-		self->us0,
-	};
+		popcorn_view_mvp(view, v, &pm, &mvm, &uniform->mvp[v]);
+	}
 
-	vkk_renderer_clearDepth(rend);
-	vkk_renderer_bindGraphicsPipeline(rend, self->gp);
+	// only changed instruments dirty the scene
+	int i;
+	for(i = 0; i < POPCORN_INSTRUMENT_COUNT; ++i)
+	{
+		popcorn_instrument_t* inst = &self->instrument[i];
+
+		cc_mat4f_t local;
+		if(popcorn_instrument_update(inst, state, &local))
+		{
+			popcorn_scene_setLocal(self->scene, inst->node,
+			                       &local);
+		}
+	}
+
+	// only the dirty subtrees are recomputed but the
+	// node matrices are uploaded every frame since the
+	// uniform buffer is updated asynchronously
+	popcorn_scene_update(self->scene);
+	memcpy(uniform->mvm, self->scene->world,
+	       self->scene->count*sizeof(cc_mat4f_t));
+
+	// the views share the uniform upload and the view
+	// uniform set selects the mvp
 	vkk_renderer_updateBuffer(rend, self->ub00_mvp,
-	                          sizeof(cc_mat4f_t),
-	                          (const void*) &mvp);
-	vkk_renderer_bindUniformSets(rend, 1, us_array);
+	                          sizeof(popcorn_cockpitUniform_t),
+	                          (const void*) uniform);
+
+	// the screen samples the last display image
+	popcorn_mfd_draw(self->mfd, queue, view, uniform->mvp);
+
+	// one draw per arena page of the level
+	uint32_t level;
+	level = popcorn_lod_select(&self->lod, &mvm, fovy,
+	                           (float) view->h);
+	popcorn_cockpit_stream(self, level, fovy, aspect, rx, ry);
+	popcorn_arena_enqueue(self->arena, queue,
+	                      POPCORN_QUEUE_LAYER_COCKPIT,
+	                      self->gp, self->us0, level);
+}
 
-	cc_listIter_t* iter = cc_list_head(self->parts);
-	while(iter)
-	{
-		popcorn_part_t* part;
-		part = (popcorn_part_t*)
-		       cc_list_peekIter(iter);
+void popcorn_cockpit_update(popcorn_cockpit_t* self,
+                            const popcorn_flightState_t* state,
+                            float bearing, float tilt,
+                            double t)
+{
+	ASSERT(self);
+	ASSERT(state);
+
+	// the display is drawn outside of the default
+	// renderer pass at its own rate
+	popcorn_mfd_update(self->mfd, state, bearing, tilt, t);
+}
 
-		vkk_renderer_drawIndexed(rend, part->ic, 2,
-		                         VKK_INDEX_TYPE_USHORT,
-		                         part->ib, part->vbnb);
+int popcorn_cockpit_pending(popcorn_cockpit_t* self)
+{
+	ASSERT(self);
 
-		iter = cc_list_next(iter);
+	if(self->pending || popcorn_mfd_pending(self->mfd))
+	{
+		return 1;
 	}
+	return 0;
+}
+
+void popcorn_cockpit_startup(popcorn_cockpit_t* self,
+                             popcorn_startup_t* startup)
+{
+	ASSERT(self);
+	ASSERT(startup);
+
+	// the total includes the arena flushes and the max is
+	// the longest decode and copy of a single part
+	popcorn_startup_aggregate(startup, "cockpit.uploads",
+	                          self->upload_t0, self->loads,
+	                          self->upload_dt, self->upload_max);
 }
@@ -25,12 +25,73 @@
 
 #include "libcc/cc_list.h"
 #include "libvkk/vkk.h"
+#include "libcc/math/cc_mat4f.h"
+#include "popcorn_arena.h"
+#include "popcorn_instrument.h"
+#include "popcorn_lod.h"
+#include "popcorn_mesh.h"
+#include "popcorn_mfd.h"
+#include "popcorn_pakmap.h"
+#include "popcorn_queue.h"
+#include "popcorn_scene.h"
+#include "popcorn_shader.h"
+#include "popcorn_sim.h"
+#include "popcorn_startup.h"
+#include "popcorn_view.h"
 
+// maximum scene nodes
+// the uniform buffer is limited to 16KB
+// see uniformMvp in cockpit.vert
+#define POPCORN_COCKPIT_NODES 254
+
+// GPU budget of the streamed mesh parts in bytes
+// build with -DPOPCORN_COCKPIT_BUDGET=<bytes> to override
+#ifndef POPCORN_COCKPIT_BUDGET
+#define POPCORN_COCKPIT_BUDGET (16*1024*1024)
+#endif
+
+// vertices streamed per frame after the first frame
+#define POPCORN_COCKPIT_STREAM 65536
+
+// the view is widened by the guard band and the head
+// direction is predicted this many frames ahead
+#define POPCORN_COCKPIT_GUARD   1.25f
+#define POPCORN_COCKPIT_PREDICT 8.0f
+
+// mvp of each view followed by the node matrices
 typedef struct
 {
-	uint32_t      ic;
-	vkk_buffer_t* ib;
-	vkk_buffer_t* vbnb[2];
+	cc_mat4f_t mvp[POPCORN_VIEW_MAX];
+	cc_mat4f_t mvm[POPCORN_COCKPIT_NODES];
+} popcorn_cockpitUniform_t;
+
+// parts are suballocated from the arena
+// mesh parts are streamed from their offset in the mesh,
+// glTF parts are streamed from a host copy and both are
+// resident while alloc is set where the instruments
+// are pinned
+typedef struct
+{
+	uint32_t              ic;
+	uint32_t              vc;
+	uint32_t              node;
+	uint32_t              mask;
+	popcorn_arenaAlloc_t* alloc;
+
+	// offset of the part header in the mesh
+	size_t offset;
+
+	// host copy of a glTF part
+	uint16_t* ib;
+	float*    vb;
+	float*    nb;
+
+	// bounding sphere in the rest pose
+	float center[3];
+	float radius;
+
+	// last frame the part was needed
+	uint32_t frame;
 } popcorn_part_t;
 
 typedef struct popcorn_cockpit_s
@@ -41,15 +102,66 @@ typedef struct popcorn_cockpit_s
 	vkk_graphicsPipeline_t*  gp;
 	vkk_buffer_t*            ub00_mvp;
 	vkk_uniformSet_t*        us0;
+	popcorn_arena_t*         arena;
 	cc_list_t*               parts;
+	popcorn_scene_t*         scene;
+
+	// the mapping of the mesh remains open to stream
+	// parts on demand
+	popcorn_pakmap_t* map;
+	popcorn_mesh_t*   mesh;
+
+	// residency of the streamed parts
+	// parts are deferred when the reserved arena pages of
+	// their levels are full of parts needed by the frame
+	uint32_t frame;
+	size_t   resident;
+	uint32_t pending;
+	uint32_t loads;
+	uint32_t evictions;
+	uint32_t deferred;
+	float    rx;
+	float    ry;
+
+	// upload time of the streamed parts which is reported
+	// as one startup phase since the parts are uploaded
+	// by the first frames
+	double upload_t0;
+	double upload_dt;
+	double upload_max;
+
+	// animated instruments
+	popcorn_instrument_t instrument[POPCORN_INSTRUMENT_COUNT];
+
+	// level of detail of the mesh parts
+	popcorn_lod_t lod;
+
+	// multi-function display
+	popcorn_mfd_t* mfd;
+
+	// uploaded once per frame
+	popcorn_cockpitUniform_t uniform;
 } popcorn_cockpit_t;
 
-popcorn_cockpit_t* popcorn_cockpit_new(vkk_engine_t* engine);
+popcorn_cockpit_t* popcorn_cockpit_new(vkk_engine_t* engine,
+                                       popcorn_view_t* view,
+                                       popcorn_shader_t* shader,
+                                       popcorn_startup_t* startup);
 void               popcorn_cockpit_delete(popcorn_cockpit_t** _self);
+void               popcorn_cockpit_update(popcorn_cockpit_t* self,
+                                          const popcorn_flightState_t* state,
+                                          float bearing, float tilt,
+                                          double t);
 void               popcorn_cockpit_draw(popcorn_cockpit_t* self,
+                                        popcorn_queue_t* queue,
+                                        popcorn_view_t* view,
+                                        const popcorn_flightState_t* state,
                                         float fovy,
                                         float aspect,
                                         float rx,
                                         float ry);
+int                popcorn_cockpit_pending(popcorn_cockpit_t* self);
+void               popcorn_cockpit_startup(popcorn_cockpit_t* self,
+                                           popcorn_startup_t* startup);
 
 #endif
@@ -0,0 +1,761 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_collision.h"
+#include "popcorn_memory.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static uint32_t
+popcorn_collision_hash(int32_t ix, int32_t iy, int32_t iz)
+{
+	// Optimized Spatial Hashing for Collision Detection
+	// of Deformable Objects, Teschner et al.
+	uint32_t h = (((uint32_t) ix)*73856093) ^
+	             (((uint32_t) iy)*19349663) ^
+	             (((uint32_t) iz)*83492791);
+	return h & (POPCORN_COLLISION_BUCKETS - 1);
+}
+
+static int32_t
+popcorn_collision_cell(popcorn_collision_t* self, float x)
+{
+	ASSERT(self);
+
+	return (int32_t) floorf(x/self->cell_size);
+}
+
+static int
+popcorn_collision_addEntry(popcorn_collision_t* self,
+                           int32_t ix, int32_t iy, int32_t iz,
+                           uint32_t tri)
+{
+	ASSERT(self);
+
+	if(self->entry_count == self->entry_max)
+	{
+		uint32_t entry_max = 2*self->entry_max;
+		if(entry_max == 0)
+		{
+			entry_max = 256;
+		}
+
+		popcorn_cellEntry_t* entries;
+		entries = (popcorn_cellEntry_t*)
+		          popcorn_memory_realloc(POPCORN_MEMORY_TAG_COLLISION,
+		                                 self->entries,
+		                                 entry_max*sizeof(popcorn_cellEntry_t));
+		if(entries == NULL)
+		{
+			LOGE("REALLOC failed");
+			return 0;
+		}
+
+		self->entry_max = entry_max;
+		self->entries   = entries;
+	}
+
+	uint32_t h = popcorn_collision_hash(ix, iy, iz);
+
+	popcorn_cellEntry_t* e = &self->entries[self->entry_count];
+	e->ix   = ix;
+	e->iy   = iy;
+	e->iz   = iz;
+	e->tri  = tri;
+	e->next = self->buckets[h];
+
+	self->buckets[h] = (int32_t) self->entry_count;
+	++self->entry_count;
+
+	return 1;
+}
+
+static void
+popcorn_collision_removeEntries(popcorn_collision_t* self,
+                                uint32_t entry_count)
+{
+	ASSERT(self);
+
+	// entries are pushed on the bucket heads so they must be
+	// popped in reverse order to restore the bucket chains
+	while(self->entry_count > entry_count)
+	{
+		--self->entry_count;
+
+		popcorn_cellEntry_t* e = &self->entries[self->entry_count];
+
+		uint32_t h = popcorn_collision_hash(e->ix, e->iy, e->iz);
+		ASSERT(self->buckets[h] == (int32_t) self->entry_count);
+
+		self->buckets[h] = e->next;
+	}
+}
+
+static int
+popcorn_collision_addTriangle(popcorn_collision_t* self,
+                              uint32_t id,
+                              const cc_vec3f_t* p0,
+                              const cc_vec3f_t* p1,
+                              const cc_vec3f_t* p2)
+{
+	ASSERT(self);
+	ASSERT(p0);
+	ASSERT(p1);
+	ASSERT(p2);
+
+	// compute the normal and discard degenerate triangles
+	cc_vec3f_t e1;
+	cc_vec3f_t e2;
+	cc_vec3f_t n;
+	cc_vec3f_subv_copy(p1, p0, &e1);
+	cc_vec3f_subv_copy(p2, p0, &e2);
+	cc_vec3f_cross_copy(&e1, &e2, &n);
+	if(cc_vec3f_mag(&n) < 1.0e-12f)
+	{
+		return 1;
+	}
+	cc_vec3f_normalize(&n);
+
+	if(self->tri_count == self->tri_max)
+	{
+		uint32_t tri_max = 2*self->tri_max;
+		if(tri_max == 0)
+		{
+			tri_max = 64;
+		}
+
+		popcorn_triangle_t* tris;
+		tris = (popcorn_triangle_t*)
+		       popcorn_memory_realloc(POPCORN_MEMORY_TAG_COLLISION,
+		                              self->tris,
+		                              tri_max*sizeof(popcorn_triangle_t));
+		if(tris == NULL)
+		{
+			LOGE("REALLOC failed");
+			return 0;
+		}
+
+		self->tri_max = tri_max;
+		self->tris    = tris;
+	}
+
+	uint32_t            tri = self->tri_count;
+	popcorn_triangle_t* t   = &self->tris[tri];
+	cc_vec3f_copy(p0, &t->p0);
+	cc_vec3f_copy(p1, &t->p1);
+	cc_vec3f_copy(p2, &t->p2);
+	cc_vec3f_copy(&n, &t->n);
+	t->id    = id;
+	t->stamp = 0;
+
+	// insert the triangle in every cell overlapped by its bounds
+	int32_t x0 = popcorn_collision_cell(self, fminf(p0->x, fminf(p1->x, p2->x)));
+	int32_t y0 = popcorn_collision_cell(self, fminf(p0->y, fminf(p1->y, p2->y)));
+	int32_t z0 = popcorn_collision_cell(self, fminf(p0->z, fminf(p1->z, p2->z)));
+	int32_t x1 = popcorn_collision_cell(self, fmaxf(p0->x, fmaxf(p1->x, p2->x)));
+	int32_t y1 = popcorn_collision_cell(self, fmaxf(p0->y, fmaxf(p1->y, p2->y)));
+	int32_t z1 = popcorn_collision_cell(self, fmaxf(p0->z, fmaxf(p1->z, p2->z)));
+
+	uint32_t entry_count = self->entry_count;
+
+	int32_t ix;
+	int32_t iy;
+	int32_t iz;
+	for(iz = z0; iz <= z1; ++iz)
+	{
+		for(iy = y0; iy <= y1; ++iy)
+		{
+			for(ix = x0; ix <= x1; ++ix)
+			{
+				if(popcorn_collision_addEntry(self, ix, iy, iz,
+				                              tri) == 0)
+				{
+					// remove the partially inserted triangle
+					popcorn_collision_removeEntries(self,
+					                                entry_count);
+					return 0;
+				}
+			}
+		}
+	}
+
+	++self->tri_count;
+
+	return 1;
+}
+
+static int
+popcorn_collision_lowestRoot(float a, float b, float c,
+                             float max, float* _root)
+{
+	ASSERT(_root);
+
+	if(fabsf(a) < 1.0e-12f)
+	{
+		return 0;
+	}
+
+	float det = b*b - 4.0f*a*c;
+	if(det < 0.0f)
+	{
+		return 0;
+	}
+
+	float sqrtd = sqrtf(det);
+	float r1    = (-b - sqrtd)/(2.0f*a);
+	float r2    = (-b + sqrtd)/(2.0f*a);
+	if(r1 > r2)
+	{
+		float tmp = r2;
+		r2 = r1;
+		r1 = tmp;
+	}
+
+	if((r1 > 0.0f) && (r1 < max))
+	{
+		*_root = r1;
+		return 1;
+	}
+
+	if((r2 > 0.0f) && (r2 < max))
+	{
+		*_root = r2;
+		return 1;
+	}
+
+	return 0;
+}
+
+static int
+popcorn_collision_insideTriangle(const popcorn_triangle_t* tri,
+                                 const cc_vec3f_t* p)
+{
+	ASSERT(tri);
+	ASSERT(p);
+
+	// barycentric test
+	cc_vec3f_t v0;
+	cc_vec3f_t v1;
+	cc_vec3f_t v2;
+	cc_vec3f_subv_copy(&tri->p1, &tri->p0, &v0);
+	cc_vec3f_subv_copy(&tri->p2, &tri->p0, &v1);
+	cc_vec3f_subv_copy(p, &tri->p0, &v2);
+
+	float d00   = cc_vec3f_dot(&v0, &v0);
+	float d01   = cc_vec3f_dot(&v0, &v1);
+	float d11   = cc_vec3f_dot(&v1, &v1);
+	float d20   = cc_vec3f_dot(&v2, &v0);
+	float d21   = cc_vec3f_dot(&v2, &v1);
+	float denom = d00*d11 - d01*d01;
+	if(denom == 0.0f)
+	{
+		return 0;
+	}
+
+	float v = (d11*d20 - d01*d21)/denom;
+	float w = (d00*d21 - d01*d20)/denom;
+	return (v >= 0.0f) && (w >= 0.0f) && (v + w <= 1.0f);
+}
+
+static void
+popcorn_collision_closestPoint(const popcorn_triangle_t* tri,
+                               const cc_vec3f_t* p,
+                               cc_vec3f_t* q)
+{
+	ASSERT(tri);
+	ASSERT(p);
+	ASSERT(q);
+
+	// Real-Time Collision Detection, Ericson, 5.1.5
+	const cc_vec3f_t* a = &tri->p0;
+	const cc_vec3f_t* b = &tri->p1;
+	const cc_vec3f_t* c = &tri->p2;
+
+	cc_vec3f_t ab;
+	cc_vec3f_t ac;
+	cc_vec3f_t ap;
+	cc_vec3f_subv_copy(b, a, &ab);
+	cc_vec3f_subv_copy(c, a, &ac);
+	cc_vec3f_subv_copy(p, a, &ap);
+
+	float d1 = cc_vec3f_dot(&ab, &ap);
+	float d2 = cc_vec3f_dot(&ac, &ap);
+	if((d1 <= 0.0f) && (d2 <= 0.0f))
+	{
+		cc_vec3f_copy(a, q);
+		return;
+	}
+
+	cc_vec3f_t bp;
+	cc_vec3f_subv_copy(p, b, &bp);
+	float d3 = cc_vec3f_dot(&ab, &bp);
+	float d4 = cc_vec3f_dot(&ac, &bp);
+	if((d3 >= 0.0f) && (d4 <= d3))
+	{
+		cc_vec3f_copy(b, q);
+		return;
+	}
+
+	float vc = d1*d4 - d3*d2;
+	if((vc <= 0.0f) && (d1 >= 0.0f) && (d3 <= 0.0f))
+	{
+		float v = d1/(d1 - d3);
+		cc_vec3f_muls_copy(&ab, v, q);
+		cc_vec3f_addv(q, a);
+		return;
+	}
+
+	cc_vec3f_t cp;
+	cc_vec3f_subv_copy(p, c, &cp);
+	float d5 = cc_vec3f_dot(&ab, &cp);
+	float d6 = cc_vec3f_dot(&ac, &cp);
+	if((d6 >= 0.0f) && (d5 <= d6))
+	{
+		cc_vec3f_copy(c, q);
+		return;
+	}
+
+	float vb = d5*d2 - d1*d6;
+	if((vb <= 0.0f) && (d2 >= 0.0f) && (d6 <= 0.0f))
+	{
+		float w = d2/(d2 - d6);
+		cc_vec3f_muls_copy(&ac, w, q);
+		cc_vec3f_addv(q, a);
+		return;
+	}
+
+	float va = d3*d6 - d5*d4;
+	if((va <= 0.0f) && ((d4 - d3) >= 0.0f) && ((d5 - d6) >= 0.0f))
+	{
+		cc_vec3f_t bc;
+		cc_vec3f_subv_copy(c, b, &bc);
+		float w = (d4 - d3)/((d4 - d3) + (d5 - d6));
+		cc_vec3f_muls_copy(&bc, w, q);
+		cc_vec3f_addv(q, b);
+		return;
+	}
+
+	float denom = 1.0f/(va + vb + vc);
+	float v     = vb*denom;
+	float w     = vc*denom;
+	cc_vec3f_t abv;
+	cc_vec3f_t acw;
+	cc_vec3f_muls_copy(&ab, v, &abv);
+	cc_vec3f_muls_copy(&ac, w, &acw);
+	cc_vec3f_addv_copy(a, &abv, q);
+	cc_vec3f_addv(q, &acw);
+}
+
+static int
+popcorn_collision_sweepVertex(const cc_vec3f_t* base,
+                              const cc_vec3f_t* vel,
+                              float radius,
+                              const cc_vec3f_t* p,
+                              float* _t,
+                              cc_vec3f_t* point)
+{
+	ASSERT(base);
+	ASSERT(vel);
+	ASSERT(p);
+	ASSERT(_t);
+	ASSERT(point);
+
+	cc_vec3f_t d;
+	cc_vec3f_subv_copy(base, p, &d);
+
+	float a = cc_vec3f_dot(vel, vel);
+	float b = 2.0f*cc_vec3f_dot(vel, &d);
+	float c = cc_vec3f_dot(&d, &d) - radius*radius;
+
+	float t;
+	if(popcorn_collision_lowestRoot(a, b, c, *_t, &t))
+	{
+		*_t = t;
+		cc_vec3f_copy(p, point);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int
+popcorn_collision_sweepEdge(const cc_vec3f_t* base,
+                            const cc_vec3f_t* vel,
+                            float radius,
+                            const cc_vec3f_t* p1,
+                            const cc_vec3f_t* p2,
+                            float* _t,
+                            cc_vec3f_t* point)
+{
+	ASSERT(base);
+	ASSERT(vel);
+	ASSERT(p1);
+	ASSERT(p2);
+	ASSERT(_t);
+	ASSERT(point);
+
+	// Improved Collision detection and Response, Fauerby
+	cc_vec3f_t edge;
+	cc_vec3f_t btv;
+	cc_vec3f_subv_copy(p2, p1, &edge);
+	cc_vec3f_subv_copy(p1, base, &btv);
+
+	float edgeSq     = cc_vec3f_dot(&edge, &edge);
+	float edgeDotVel = cc_vec3f_dot(&edge, vel);
+	float edgeDotBtv = cc_vec3f_dot(&edge, &btv);
+	float velSq      = cc_vec3f_dot(vel, vel);
+
+	float a = edgeSq*(-velSq) + edgeDotVel*edgeDotVel;
+	float b = edgeSq*(2.0f*cc_vec3f_dot(vel, &btv)) -
+	          2.0f*edgeDotVel*edgeDotBtv;
+	float c = edgeSq*(radius*radius - cc_vec3f_dot(&btv, &btv)) +
+	          edgeDotBtv*edgeDotBtv;
+
+	float t;
+	if(popcorn_collision_lowestRoot(a, b, c, *_t, &t))
+	{
+		// check if the intersection is within the segment
+		float f = (edgeDotVel*t - edgeDotBtv)/edgeSq;
+		if((f >= 0.0f) && (f <= 1.0f))
+		{
+			*_t = t;
+			cc_vec3f_muls_copy(&edge, f, point);
+			cc_vec3f_addv(point, p1);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int
+popcorn_collision_sweepTriangle(const popcorn_triangle_t* tri,
+                                const cc_vec3f_t* base,
+                                const cc_vec3f_t* vel,
+                                float radius,
+                                popcorn_contact_t* contact)
+{
+	ASSERT(tri);
+	ASSERT(base);
+	ASSERT(vel);
+	ASSERT(contact);
+
+	// triangles are double sided so orient the
+	// normal towards the sphere
+	cc_vec3f_t n;
+	cc_vec3f_t d;
+	cc_vec3f_copy(&tri->n, &n);
+	cc_vec3f_subv_copy(base, &tri->p0, &d);
+	float dist = cc_vec3f_dot(&n, &d);
+	if(dist < 0.0f)
+	{
+		cc_vec3f_muls(&n, -1.0f);
+		dist = -dist;
+	}
+
+	// the sphere is already embedded in the triangle
+	if(dist < radius)
+	{
+		cc_vec3f_t q;
+		popcorn_collision_closestPoint(tri, base, &q);
+		cc_vec3f_subv_copy(base, &q, &d);
+		if(cc_vec3f_dot(&d, &d) < radius*radius)
+		{
+			contact->t = 0.0f;
+			cc_vec3f_copy(&q, &contact->point);
+			cc_vec3f_copy(&n, &contact->normal);
+			return 1;
+		}
+	}
+
+	// moving away from or parallel to the plane
+	float ndotv = cc_vec3f_dot(&n, vel);
+	if(ndotv >= 0.0f)
+	{
+		return 0;
+	}
+
+	// time when the sphere touches the plane
+	float t0 = (radius - dist)/ndotv;
+	if(t0 < 0.0f)
+	{
+		t0 = 0.0f;
+	}
+	if(t0 > contact->t)
+	{
+		return 0;
+	}
+
+	// check if the plane contact lies inside the triangle
+	cc_vec3f_t p;
+	cc_vec3f_t nr;
+	cc_vec3f_muls_copy(vel, t0, &p);
+	cc_vec3f_addv(&p, base);
+	cc_vec3f_muls_copy(&n, radius, &nr);
+	cc_vec3f_subv(&p, &nr);
+	if(popcorn_collision_insideTriangle(tri, &p))
+	{
+		contact->t = t0;
+		cc_vec3f_copy(&p, &contact->point);
+		cc_vec3f_copy(&n, &contact->normal);
+		return 1;
+	}
+
+	// otherwise the sphere may touch a vertex or edge
+	float      t = contact->t;
+	cc_vec3f_t point;
+	int        hit = 0;
+	hit |= popcorn_collision_sweepVertex(base, vel, radius,
+	                                     &tri->p0, &t, &point);
+	hit |= popcorn_collision_sweepVertex(base, vel, radius,
+	                                     &tri->p1, &t, &point);
+	hit |= popcorn_collision_sweepVertex(base, vel, radius,
+	                                     &tri->p2, &t, &point);
+	hit |= popcorn_collision_sweepEdge(base, vel, radius,
+	                                   &tri->p0, &tri->p1,
+	                                   &t, &point);
+	hit |= popcorn_collision_sweepEdge(base, vel, radius,
+	                                   &tri->p1, &tri->p2,
+	                                   &t, &point);
+	hit |= popcorn_collision_sweepEdge(base, vel, radius,
+	                                   &tri->p2, &tri->p0,
+	                                   &t, &point);
+	if(hit == 0)
+	{
+		return 0;
+	}
+
+	// the contact normal points from the contact
+	// point to the sphere center
+	cc_vec3f_t center;
+	cc_vec3f_muls_copy(vel, t, &center);
+	cc_vec3f_addv(&center, base);
+	cc_vec3f_subv_copy(&center, &point, &n);
+	cc_vec3f_normalize(&n);
+
+	contact->t = t;
+	cc_vec3f_copy(&point, &contact->point);
+	cc_vec3f_copy(&n, &contact->normal);
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_collision_t* popcorn_collision_new(float cell_size)
+{
+	ASSERT(cell_size > 0.0f);
+
+	popcorn_collision_t* self;
+	self = (popcorn_collision_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_COLLISION,
+	                             1, sizeof(popcorn_collision_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->cell_size = cell_size;
+
+	int i;
+	for(i = 0; i < POPCORN_COLLISION_BUCKETS; ++i)
+	{
+		self->buckets[i] = -1;
+	}
+
+	return self;
+}
+
+void popcorn_collision_delete(popcorn_collision_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_collision_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->entries);
+		popcorn_memory_free(self->tris);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_collision_addMesh(popcorn_collision_t* self,
+                              uint32_t id,
+                              const cc_mat4f_t* mm,
+                              uint32_t vc,
+                              uint32_t stride,
+                              const float* xyz,
+                              uint32_t ic,
+                              const uint16_t* indices)
+{
+	// mm and indices are optional
+	ASSERT(self);
+	ASSERT(stride >= 3);
+	ASSERT(xyz);
+
+	// non-indexed meshes are triangle lists
+	uint32_t count = indices ? ic : vc;
+
+	uint32_t i;
+	uint32_t j;
+	for(i = 0; i + 2 < count; i += 3)
+	{
+		cc_vec3f_t p[3];
+		for(j = 0; j < 3; ++j)
+		{
+			uint32_t idx = indices ? indices[i + j] : i + j;
+			if(idx >= vc)
+			{
+				LOGE("invalid idx=%u, vc=%u", idx, vc);
+				return 0;
+			}
+
+			const float* v = &xyz[stride*idx];
+			if(mm)
+			{
+				// instance transform
+				p[j].x = mm->m00*v[0] + mm->m01*v[1] +
+				         mm->m02*v[2] + mm->m03;
+				p[j].y = mm->m10*v[0] + mm->m11*v[1] +
+				         mm->m12*v[2] + mm->m13;
+				p[j].z = mm->m20*v[0] + mm->m21*v[1] +
+				         mm->m22*v[2] + mm->m23;
+			}
+			else
+			{
+				cc_vec3f_load(&p[j], v[0], v[1], v[2]);
+			}
+		}
+
+		if(popcorn_collision_addTriangle(self, id, &p[0],
+		                                 &p[1], &p[2]) == 0)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int popcorn_collision_sweep(popcorn_collision_t* self,
+                            const cc_vec3f_t* p0,
+                            const cc_vec3f_t* p1,
+                            float radius,
+                            popcorn_contact_t* contact)
+{
+	ASSERT(self);
+	ASSERT(p0);
+	ASSERT(p1);
+	ASSERT(contact);
+
+	// the query stamp marks triangles which have already
+	// been tested when a triangle spans several cells
+	++self->stamp;
+	if(self->stamp == 0)
+	{
+		uint32_t i;
+		for(i = 0; i < self->tri_count; ++i)
+		{
+			self->tris[i].stamp = 0;
+		}
+		self->stamp = 1;
+	}
+
+	cc_vec3f_t vel;
+	cc_vec3f_subv_copy(p1, p0, &vel);
+
+	// only visit the cells overlapped by the swept sphere
+	// so the query cost is independent of the world size
+	int32_t x0 = popcorn_collision_cell(self, fminf(p0->x, p1->x) - radius);
+	int32_t y0 = popcorn_collision_cell(self, fminf(p0->y, p1->y) - radius);
+	int32_t z0 = popcorn_collision_cell(self, fminf(p0->z, p1->z) - radius);
+	int32_t x1 = popcorn_collision_cell(self, fmaxf(p0->x, p1->x) + radius);
+	int32_t y1 = popcorn_collision_cell(self, fmaxf(p0->y, p1->y) + radius);
+	int32_t z1 = popcorn_collision_cell(self, fmaxf(p0->z, p1->z) + radius);
+
+	popcorn_contact_t c;
+	memset(&c, 0, sizeof(popcorn_contact_t));
+	c.t = 1.0f;
+
+	int     hit = 0;
+	int32_t ix;
+	int32_t iy;
+	int32_t iz;
+	for(iz = z0; iz <= z1; ++iz)
+	{
+		for(iy = y0; iy <= y1; ++iy)
+		{
+			for(ix = x0; ix <= x1; ++ix)
+			{
+				uint32_t h = popcorn_collision_hash(ix, iy, iz);
+				int32_t  e = self->buckets[h];
+				while(e >= 0)
+				{
+					popcorn_cellEntry_t* entry = &self->entries[e];
+					e = entry->next;
+
+					if((entry->ix != ix) ||
+					   (entry->iy != iy) ||
+					   (entry->iz != iz))
+					{
+						continue;
+					}
+
+					popcorn_triangle_t* tri = &self->tris[entry->tri];
+					if(tri->stamp == self->stamp)
+					{
+						continue;
+					}
+					tri->stamp = self->stamp;
+
+					if(popcorn_collision_sweepTriangle(tri, p0, &vel,
+					                                   radius, &c))
+					{
+						c.id = tri->id;
+						hit  = 1;
+					}
+				}
+			}
+		}
+	}
+
+	if(hit == 0)
+	{
+		return 0;
+	}
+
+	cc_vec3f_muls_copy(&vel, c.t, &c.center);
+	cc_vec3f_addv(&c.center, p0);
+	memcpy(contact, &c, sizeof(popcorn_contact_t));
+	return 1;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_collision_H
+#define popcorn_collision_H
+
+#include <stdint.h>
+
+#include "libcc/math/cc_mat4f.h"
+#include "libcc/math/cc_vec3f.h"
+
+// number of buckets in the spatial hash
+// must be a power of two
+#define POPCORN_COLLISION_BUCKETS 4096
+
+typedef struct
+{
+	cc_vec3f_t p0;
+	cc_vec3f_t p1;
+	cc_vec3f_t p2;
+	cc_vec3f_t n;
+
+	// instance id passed to addMesh
+	uint32_t id;
+
+	// query stamp to avoid testing a triangle
+	// more than once when it spans several cells
+	uint32_t stamp;
+} popcorn_triangle_t;
+
+typedef struct
+{
+	// cell coordinates are stored to resolve
+	// hash collisions between distant cells
+	int32_t  ix;
+	int32_t  iy;
+	int32_t  iz;
+	uint32_t tri;
+	int32_t  next;
+} popcorn_cellEntry_t;
+
+typedef struct
+{
+	// time of impact in [0,1] along the sweep
+	float t;
+
+	// sphere center at the time of impact
+	cc_vec3f_t center;
+
+	// contact point on the triangle
+	cc_vec3f_t point;
+
+	// triangle normal facing the sphere
+	cc_vec3f_t normal;
+
+	// instance id passed to addMesh
+	uint32_t id;
+} popcorn_contact_t;
+
+typedef struct popcorn_collision_s
+{
+	float cell_size;
+
+	uint32_t stamp;
+
+	uint32_t            tri_count;
+	uint32_t            tri_max;
+	popcorn_triangle_t* tris;
+
+	uint32_t             entry_count;
+	uint32_t             entry_max;
+	popcorn_cellEntry_t* entries;
+
+	int32_t buckets[POPCORN_COLLISION_BUCKETS];
+} popcorn_collision_t;
+
+popcorn_collision_t* popcorn_collision_new(float cell_size);
+void                 popcorn_collision_delete(popcorn_collision_t** _self);
+int                  popcorn_collision_addMesh(popcorn_collision_t* self,
+                                               uint32_t id,
+                                               const cc_mat4f_t* mm,
+                                               uint32_t vc,
+                                               uint32_t stride,
+                                               const float* xyz,
+                                               uint32_t ic,
+                                               const uint16_t* indices);
+int                  popcorn_collision_sweep(popcorn_collision_t* self,
+                                             const cc_vec3f_t* p0,
+                                             const cc_vec3f_t* p1,
+                                             float radius,
+                                             popcorn_contact_t* contact);
+
+#endif
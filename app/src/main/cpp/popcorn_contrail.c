@@ -0,0 +1,596 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libcc/cc_timestamp.h"
+#include "popcorn_contrail.h"
+#include "popcorn_frametime.h"
+#include "popcorn_memory.h"
+
+// emitter offsets in aircraft units
+#define POPCORN_CONTRAIL_WING 0.03f
+#define POPCORN_CONTRAIL_TAIL 0.02f
+
+// initial billboard half size which grows with age
+#define POPCORN_CONTRAIL_SIZE 0.002f
+
+// exhaust speed per second
+#define POPCORN_CONTRAIL_JET 0.2f
+
+// steps are clamped so a stall does not emit a burst
+#define POPCORN_CONTRAIL_DT 0.1f
+
+// emitters
+#define POPCORN_CONTRAIL_EMITTER_LEFT    0
+#define POPCORN_CONTRAIL_EMITTER_RIGHT   1
+#define POPCORN_CONTRAIL_EMITTER_EXHAUST 2
+
+// one vec4 per corner of each billboard
+#define POPCORN_CONTRAIL_VERTICES 6
+#define POPCORN_CONTRAIL_STRIDE   (4*POPCORN_CONTRAIL_VERTICES)
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static float popcorn_contrail_random(popcorn_contrail_t* self)
+{
+	ASSERT(self);
+
+	// LCG in [-1, 1]
+	self->seed = 1664525u*self->seed + 1013904223u;
+	return ((float) (self->seed >> 8))/8388608.0f - 1.0f;
+}
+
+static void
+popcorn_contrail_store(float* dst, float x, float y,
+                       float z, float w)
+{
+	ASSERT(dst);
+
+	int i;
+	for(i = 0; i < POPCORN_CONTRAIL_VERTICES; ++i)
+	{
+		dst[4*i + 0] = x;
+		dst[4*i + 1] = y;
+		dst[4*i + 2] = z;
+		dst[4*i + 3] = w;
+	}
+}
+
+static void
+popcorn_contrail_emit(popcorn_contrail_t* self,
+                      uint32_t emitter, float rate, float dt,
+                      const cc_vec3f_t* position,
+                      const cc_vec3f_t* offset,
+                      const cc_vec3f_t* velocity,
+                      float jitter, float life)
+{
+	ASSERT(self);
+	ASSERT(position);
+	ASSERT(offset);
+	ASSERT(velocity);
+
+	float n = self->remainder[emitter] + rate*dt;
+	if(n < 1.0f)
+	{
+		self->remainder[emitter] = n;
+		return;
+	}
+
+	// particles are spread along the path of the step
+	// so a slow frame does not leave gaps in the trail
+	uint32_t count = (uint32_t) n;
+	self->remainder[emitter] = n - (float) count;
+
+	cc_vec3f_t delta;
+	cc_vec3f_subv_copy(position, &self->position, &delta);
+
+	uint32_t i;
+	for(i = 0; i < count; ++i)
+	{
+		float s = ((float) (i + 1))/((float) count);
+		float p[3] =
+		{
+			self->position.x + s*delta.x + offset->x,
+			self->position.y + s*delta.y + offset->y,
+			self->position.z + s*delta.z + offset->z,
+		};
+		float v[3] =
+		{
+			velocity->x + jitter*popcorn_contrail_random(self),
+			velocity->y + jitter*popcorn_contrail_random(self),
+			velocity->z + jitter*popcorn_contrail_random(self),
+		};
+		popcorn_particle_emit(self->particle, p, v, life);
+		++self->emitted;
+	}
+}
+
+static void
+popcorn_contrail_rebase(popcorn_contrail_t* self,
+                        const cc_vec3f_t* offset)
+{
+	ASSERT(self);
+	ASSERT(offset);
+
+	float o[3] = { offset->x, offset->y, offset->z };
+	popcorn_particle_translate(self->particle, o);
+	cc_vec3f_addv(&self->position, offset);
+}
+
+static void
+popcorn_contrail_expand(popcorn_contrail_t* self)
+{
+	ASSERT(self);
+
+	popcorn_particle_t* particle = self->particle;
+
+	uint32_t i;
+	for(i = 0; i < particle->count; ++i)
+	{
+		popcorn_contrail_store(&self->center[POPCORN_CONTRAIL_STRIDE*i],
+		                       particle->px[i], particle->py[i],
+		                       particle->pz[i],
+		                       particle->age[i]/particle->life[i]);
+	}
+}
+
+static int
+popcorn_contrail_newPipeline(popcorn_contrail_t* self,
+                             popcorn_shader_t* shader,
+                             popcorn_startup_t* startup)
+{
+	ASSERT(self);
+	ASSERT(shader);
+	ASSERT(startup);
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(self->engine);
+
+	vkk_vertexBufferInfo_t vbi =
+	{
+		// layout(location=0) in vec4 center;
+		.location   = 0,
+		.components = 4,
+		.format     = VKK_VERTEX_FORMAT_FLOAT
+	};
+
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(shader, "particle.vert", 0);
+	fs = popcorn_shader_lookup(shader, "particle.frag", 0);
+	if((vs == NULL) || (fs == NULL))
+	{
+		return 0;
+	}
+
+	// particles are depth tested against the world
+	// but do not occlude each other
+	vkk_graphicsPipelineInfo_t gpi =
+	{
+		.renderer          = rend,
+		.pl                = self->pl,
+		.vs                = vs,
+		.fs                = fs,
+		.vb_count          = 1,
+		.vbi               = &vbi,
+		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
+		.primitive_restart = 0,
+		.cull_back         = 0,
+		.depth_test        = 1,
+		.depth_write       = 0,
+		.blend_mode        = VKK_BLEND_MODE_TRANSPARENCY
+	};
+
+	popcorn_startup_mark(startup, "contrail.pl");
+
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
+	self->gp = vkk_graphicsPipeline_new(self->engine, &gpi);
+	if(self->gp == NULL)
+	{
+		return 0;
+	}
+	popcorn_startup_mark(startup, "contrail.gp");
+
+	return 1;
+}
+
+static vkk_buffer_t*
+popcorn_contrail_newVertexBuffer(popcorn_contrail_t* self,
+                                 float** _data)
+{
+	ASSERT(self);
+	ASSERT(_data);
+
+	size_t count = POPCORN_CONTRAIL_STRIDE*((size_t) self->budget);
+
+	float* data;
+	data = (float*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_PARTICLE,
+	                             count, sizeof(float));
+	if(data == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	vkk_buffer_t* vb;
+	vb = vkk_buffer_new(self->engine,
+	                    VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                    VKK_BUFFER_USAGE_VERTEX,
+	                    count*sizeof(float), NULL);
+	if(vb == NULL)
+	{
+		popcorn_memory_free(data);
+		return NULL;
+	}
+
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_PARTICLE,
+	                        count*sizeof(float));
+
+	*_data = data;
+	return vb;
+}
+
+static void
+popcorn_contrail_deleteVertexBuffer(popcorn_contrail_t* self,
+                                    vkk_buffer_t** _vb,
+                                    float** _data)
+{
+	ASSERT(self);
+	ASSERT(_vb);
+	ASSERT(_data);
+
+	if(*_vb)
+	{
+		size_t count = POPCORN_CONTRAIL_STRIDE*((size_t) self->budget);
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_PARTICLE,
+		                       count*sizeof(float));
+		vkk_buffer_delete(_vb);
+	}
+
+	popcorn_memory_free(*_data);
+	*_data = NULL;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_contrail_t* popcorn_contrail_new(vkk_engine_t* engine,
+                                         popcorn_view_t* view,
+                                         popcorn_shader_t* shader,
+                                         uint32_t budget,
+                                         popcorn_startup_t* startup)
+{
+	ASSERT(engine);
+	ASSERT(view);
+	ASSERT(shader);
+	ASSERT(startup);
+
+	popcorn_contrail_t* self;
+	self = (popcorn_contrail_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_PARTICLE,
+	                             1, sizeof(popcorn_contrail_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->engine = engine;
+	self->budget = budget;
+	self->t0     = cc_timestamp();
+	self->seed   = 1;
+
+	// contrails drift slowly downwards
+	// the world up axis is -z
+	self->force.g[0] = 0.0f;
+	self->force.g[1] = 0.0f;
+	self->force.g[2] = 0.002f;
+	self->force.drag = 0.5f;
+
+	vkk_uniformBinding_t ub_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformParticle
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.stage   = VKK_STAGE_VS,
+		},
+	};
+
+	self->usf0 = vkk_uniformSetFactory_new(engine,
+	                                       VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                       1, ub_array0);
+	if(self->usf0 == NULL)
+	{
+		goto fail_usf0;
+	}
+
+	vkk_uniformSetFactory_t* usf_array[] =
+	{
+		self->usf0,
+		view->usf1,
+	};
+
+	self->pl = vkk_pipelineLayout_new(engine,
+	                                  2, usf_array);
+	if(self->pl == NULL)
+	{
+		goto fail_pl;
+	}
+
+	if(popcorn_contrail_newPipeline(self, shader, startup) == 0)
+	{
+		goto fail_gp;
+	}
+
+	self->ub00 = vkk_buffer_new(engine,
+	                            VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                            VKK_BUFFER_USAGE_UNIFORM,
+	                            sizeof(popcorn_contrailUniform_t),
+	                            NULL);
+	if(self->ub00 == NULL)
+	{
+		goto fail_ub00;
+	}
+
+	vkk_uniformAttachment_t ua_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformParticle
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.buffer  = self->ub00
+		},
+	};
+
+	self->us0 = vkk_uniformSet_new(engine, 0, 1,
+	                               ua_array0,
+	                               self->usf0);
+	if(self->us0 == NULL)
+	{
+		goto fail_us0;
+	}
+
+	self->particle = popcorn_particle_new(budget);
+	if(self->particle == NULL)
+	{
+		goto fail_particle;
+	}
+
+	self->vb_center = popcorn_contrail_newVertexBuffer(self,
+	                                                   &self->center);
+	if(self->vb_center == NULL)
+	{
+		goto fail_vb_center;
+	}
+
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_PARTICLE,
+	                        sizeof(popcorn_contrailUniform_t));
+
+	// success
+	return self;
+
+	// failure
+	fail_vb_center:
+		popcorn_particle_delete(&self->particle);
+	fail_particle:
+		vkk_uniformSet_delete(&self->us0);
+	fail_us0:
+		vkk_buffer_delete(&self->ub00);
+	fail_ub00:
+		vkk_graphicsPipeline_delete(&self->gp);
+	fail_gp:
+		vkk_pipelineLayout_delete(&self->pl);
+	fail_pl:
+		vkk_uniformSetFactory_delete(&self->usf0);
+	fail_usf0:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_contrail_delete(popcorn_contrail_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_contrail_t* self = *_self;
+	if(self)
+	{
+		LOGI("budget=%u, emitted=%u, dropped=%u, peak=%u",
+		     self->budget, (uint32_t) self->emitted,
+		     self->particle->dropped, self->peak);
+
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_PARTICLE,
+		                       sizeof(popcorn_contrailUniform_t));
+		popcorn_contrail_deleteVertexBuffer(self, &self->vb_center,
+		                                    &self->center);
+		popcorn_particle_delete(&self->particle);
+		vkk_uniformSet_delete(&self->us0);
+		vkk_buffer_delete(&self->ub00);
+		vkk_graphicsPipeline_delete(&self->gp);
+		vkk_pipelineLayout_delete(&self->pl);
+		vkk_uniformSetFactory_delete(&self->usf0);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_contrail_active(popcorn_contrail_t* self)
+{
+	ASSERT(self);
+
+	return self->particle->count > 0;
+}
+
+void popcorn_contrail_update(popcorn_contrail_t* self,
+                             const popcorn_flightState_t* state,
+                             double t)
+{
+	ASSERT(self);
+	ASSERT(state);
+
+	float t1 = (float) (t - self->t0);
+	float dt = t1 - self->t;
+	if(dt > POPCORN_CONTRAIL_DT)
+	{
+		dt = POPCORN_CONTRAIL_DT;
+	}
+	else if(dt < 0.0f)
+	{
+		dt = 0.0f;
+	}
+	self->t = t1;
+
+	// move the particles to the sector of the aircraft
+	if(memcmp(self->sector, state->sector,
+	          sizeof(self->sector)) != 0)
+	{
+		cc_vec3f_t offset;
+		popcorn_flight_offset(self->sector, state->sector, &offset);
+		popcorn_contrail_rebase(self, &offset);
+		memcpy(self->sector, state->sector, sizeof(self->sector));
+	}
+
+	// the trail is not connected across a reset
+	if(self->resets != state->resets)
+	{
+		cc_vec3f_copy(&state->position, &self->position);
+		self->resets = state->resets;
+	}
+
+	popcorn_particle_update(self->particle, &self->force, dt);
+
+	// aircraft axes
+	// see popcorn_flight_step
+	cc_mat4f_t mnm;
+	cc_mat4f_lookat(&mnm, 1,
+	                0.0f, 0.0f, 0.0f,
+	                1.0f, 0.0f, 0.0f,
+	                0.0f, 0.0f, -1.0f);
+	cc_mat4f_rotateq(&mnm, 0, &state->attitude);
+
+	cc_vec3f_t right;
+	cc_vec3f_t forward;
+	cc_vec3f_load(&right, mnm.m00, mnm.m01, mnm.m02);
+	cc_vec3f_load(&forward, -mnm.m20, -mnm.m21, -mnm.m22);
+
+	// contrails are left at rest in the air
+	if(state->speed > POPCORN_CONTRAIL_SPEED)
+	{
+		float rate = POPCORN_CONTRAIL_RATE*
+		             state->speed/POPCORN_FLIGHT_SPEED_MAX;
+
+		cc_vec3f_t rest;
+		cc_vec3f_t offset;
+		cc_vec3f_load(&rest, 0.0f, 0.0f, 0.0f);
+		cc_vec3f_muls_copy(&right, -POPCORN_CONTRAIL_WING, &offset);
+		popcorn_contrail_emit(self, POPCORN_CONTRAIL_EMITTER_LEFT,
+		                      rate, dt, &state->position, &offset,
+		                      &rest, 0.005f, POPCORN_CONTRAIL_LIFE);
+		cc_vec3f_muls_copy(&right, POPCORN_CONTRAIL_WING, &offset);
+		popcorn_contrail_emit(self, POPCORN_CONTRAIL_EMITTER_RIGHT,
+		                      rate, dt, &state->position, &offset,
+		                      &rest, 0.005f, POPCORN_CONTRAIL_LIFE);
+	}
+
+	// exhaust is ejected behind the aircraft
+	float acceleration = state->acceleration;
+	if(acceleration > POPCORN_CONTRAIL_EXHAUST_X)
+	{
+		acceleration = POPCORN_CONTRAIL_EXHAUST_X;
+	}
+	if(acceleration > 0.0f)
+	{
+		cc_vec3f_t jet;
+		cc_vec3f_t offset;
+		cc_vec3f_muls_copy(&forward, -POPCORN_CONTRAIL_JET, &jet);
+		cc_vec3f_muls_copy(&forward, -POPCORN_CONTRAIL_TAIL, &offset);
+		popcorn_contrail_emit(self, POPCORN_CONTRAIL_EMITTER_EXHAUST,
+		                      POPCORN_CONTRAIL_EXHAUST*acceleration,
+		                      dt, &state->position, &offset,
+		                      &jet, 0.02f, POPCORN_CONTRAIL_SMOKE);
+	}
+
+	cc_vec3f_copy(&state->position, &self->position);
+
+	if(self->peak < self->particle->count)
+	{
+		self->peak = self->particle->count;
+	}
+}
+
+void popcorn_contrail_draw(popcorn_contrail_t* self,
+                           popcorn_queue_t* queue,
+                           popcorn_view_t* view,
+                           const cc_mat4f_t* mvm,
+                           const cc_mat4f_t* mvp)
+{
+	ASSERT(self);
+	ASSERT(queue);
+	ASSERT(view);
+	ASSERT(mvm);
+	ASSERT(mvp);
+
+	if(popcorn_contrail_active(self) == 0)
+	{
+		return;
+	}
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(self->engine);
+
+	// billboards face the view plane
+	popcorn_contrailUniform_t* u = &self->uniform;
+	memcpy(u->mvp, mvp, view->count*sizeof(cc_mat4f_t));
+	cc_vec4f_load(&u->right, mvm->m00, mvm->m01, mvm->m02, 0.0f);
+	cc_vec4f_load(&u->up, mvm->m10, mvm->m11, mvm->m12, 0.0f);
+	cc_vec4f_load(&u->size, POPCORN_CONTRAIL_SIZE,
+	              0.0f, 0.0f, 0.0f);
+	vkk_renderer_updateBuffer(rend, self->ub00,
+	                          sizeof(popcorn_contrailUniform_t),
+	                          (const void*) u);
+
+	// only the live particles are uploaded
+	uint32_t count = self->particle->count;
+	size_t   size  = POPCORN_CONTRAIL_STRIDE*sizeof(float)*count;
+	popcorn_contrail_expand(self);
+	vkk_renderer_updateBuffer(rend, self->vb_center, size,
+	                          (const void*) self->center);
+
+	vkk_buffer_t* vb_array[] =
+	{
+		self->vb_center,
+	};
+
+	popcorn_queue_draw(queue, POPCORN_QUEUE_LAYER_EFFECTS,
+	                   self->gp, self->us0, 0.0f,
+	                   POPCORN_CONTRAIL_VERTICES*count,
+	                   1, vb_array);
+}
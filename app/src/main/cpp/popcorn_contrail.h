@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_contrail_H
+#define popcorn_contrail_H
+
+#include "libcc/math/cc_mat4f.h"
+#include "libcc/math/cc_vec4f.h"
+#include "libvkk/vkk.h"
+#include "popcorn_flight.h"
+#include "popcorn_particle.h"
+#include "popcorn_queue.h"
+#include "popcorn_shader.h"
+#include "popcorn_startup.h"
+#include "popcorn_view.h"
+
+// wingtip contrails and exhaust
+// contrails are emitted while the speed exceeds
+// POPCORN_CONTRAIL_SPEED at a rate proportional to the
+// speed and the exhaust is emitted at a rate proportional
+// to the acceleration
+//
+// libvkk has no compute shaders or instanced draws so
+// each particle is drawn as 6 vertices of one buffer and
+// particle.vert selects the corner by gl_VertexIndex
+//
+// the particle pool is advanced by the SIMD update kernel
+// and the center and age of each live particle is uploaded
+// since the buffer update has no offset which rules out
+// keeping spawn records resident for a closed form shader
+
+// minimum speed of the contrails per tick
+#define POPCORN_CONTRAIL_SPEED (0.25f*POPCORN_FLIGHT_SPEED_MAX)
+
+// particles per second and lifetime of each emitter
+#define POPCORN_CONTRAIL_RATE      1500.0f
+#define POPCORN_CONTRAIL_LIFE      4.0f
+#define POPCORN_CONTRAIL_EXHAUST   200.0f
+#define POPCORN_CONTRAIL_EXHAUST_X 5.0f
+#define POPCORN_CONTRAIL_SMOKE     1.0f
+
+// see uniformParticle in particle.vert
+typedef struct
+{
+	cc_mat4f_t mvp[POPCORN_VIEW_MAX];
+	cc_vec4f_t right;
+	cc_vec4f_t up;
+	cc_vec4f_t size; // x is the initial half size
+} popcorn_contrailUniform_t;
+
+typedef struct
+{
+	vkk_engine_t*            engine;
+	vkk_uniformSetFactory_t* usf0;
+	vkk_pipelineLayout_t*    pl;
+	vkk_graphicsPipeline_t*  gp;
+	vkk_buffer_t*            ub00;
+	vkk_uniformSet_t*        us0;
+
+	popcorn_particleForce_t force;
+	uint32_t                budget;
+
+	// layout(location=0) in vec4 center;
+	popcorn_particle_t* particle;
+	float*              center;
+	vkk_buffer_t*       vb_center;
+
+	// emitter state
+	// particles are relative to the sector of the aircraft
+	double     t0;
+	float      t;
+	uint32_t   resets;
+	int32_t    sector[3];
+	cc_vec3f_t position;
+	float      remainder[3];
+	uint32_t   seed;
+
+	// statistics
+	uint64_t emitted;
+	uint32_t peak;
+
+	// uploaded once per frame while active
+	popcorn_contrailUniform_t uniform;
+} popcorn_contrail_t;
+
+popcorn_contrail_t* popcorn_contrail_new(vkk_engine_t* engine,
+                                         popcorn_view_t* view,
+                                         popcorn_shader_t* shader,
+                                         uint32_t budget,
+                                         popcorn_startup_t* startup);
+void                popcorn_contrail_delete(popcorn_contrail_t** _self);
+int                 popcorn_contrail_active(popcorn_contrail_t* self);
+void                popcorn_contrail_update(popcorn_contrail_t* self,
+                                            const popcorn_flightState_t* state,
+                                            double t);
+void                popcorn_contrail_draw(popcorn_contrail_t* self,
+                                          popcorn_queue_t* queue,
+                                          popcorn_view_t* view,
+                                          const cc_mat4f_t* mvm,
+                                          const cc_mat4f_t* mvp);
+
+#endif
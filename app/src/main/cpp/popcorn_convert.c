@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define POPCORN_CONVERT_NEON
+#endif
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_convert.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int
+popcorn_convert_params(int type, int normalized,
+                       float* _scale, float* _lo)
+{
+	ASSERT(_scale);
+	ASSERT(_lo);
+
+	// glTF normalization rules
+	// snorm: max(c/(2^(b-1) - 1), -1)
+	// unorm: c/(2^b - 1)
+	float scale = 1.0f;
+	float lo    = -1.0e38f;
+	if(type == POPCORN_CONVERT_FLOAT)
+	{
+		// normalized is invalid for floats
+	}
+	else if(normalized == 0)
+	{
+		// integers are converted as-is
+		// e.g. KHR_mesh_quantization
+	}
+	else if(type == POPCORN_CONVERT_BYTE)
+	{
+		scale = 1.0f/127.0f;
+		lo    = -1.0f;
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_BYTE)
+	{
+		scale = 1.0f/255.0f;
+	}
+	else if(type == POPCORN_CONVERT_SHORT)
+	{
+		scale = 1.0f/32767.0f;
+		lo    = -1.0f;
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_SHORT)
+	{
+		scale = 1.0f/65535.0f;
+	}
+
+	if((type != POPCORN_CONVERT_FLOAT)          &&
+	   (type != POPCORN_CONVERT_BYTE)           &&
+	   (type != POPCORN_CONVERT_UNSIGNED_BYTE)  &&
+	   (type != POPCORN_CONVERT_SHORT)          &&
+	   (type != POPCORN_CONVERT_UNSIGNED_SHORT))
+	{
+		LOGE("invalid type=0x%X", (uint32_t) type);
+		return 0;
+	}
+
+	*_scale = scale;
+	*_lo    = lo;
+	return 1;
+}
+
+static float
+popcorn_convert_load1(int type, const char* p, uint32_t c)
+{
+	ASSERT(p);
+
+	// memcpy avoids unaligned access
+	if(type == POPCORN_CONVERT_BYTE)
+	{
+		return (float) ((const int8_t*) p)[c];
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_BYTE)
+	{
+		return (float) ((const uint8_t*) p)[c];
+	}
+	else if(type == POPCORN_CONVERT_SHORT)
+	{
+		int16_t s;
+		memcpy(&s, p + 2*c, 2);
+		return (float) s;
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_SHORT)
+	{
+		uint16_t s;
+		memcpy(&s, p + 2*c, 2);
+		return (float) s;
+	}
+
+	float f;
+	memcpy(&f, p + 4*c, 4);
+	return f;
+}
+
+static void
+popcorn_convert_vec3fScalar(int type, float scale, float lo,
+                            const char* src, size_t stride,
+                            uint32_t first, uint32_t count,
+                            float* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	uint32_t i;
+	uint32_t c;
+	for(i = first; i < count; ++i)
+	{
+		const char* p = src + i*stride;
+		for(c = 0; c < 3; ++c)
+		{
+			float f = scale*popcorn_convert_load1(type, p, c);
+			dst[3*i + c] = (f < lo) ? lo : f;
+		}
+	}
+}
+
+#if defined(__SSE2__) || defined(POPCORN_CONVERT_NEON)
+
+// each vertex is gathered as a 4-wide vector whose last
+// lane overlaps the next vertex so the final vertex is
+// always converted by the scalar path to avoid reading
+// or writing past the end of the buffers
+
+#if defined(__SSE2__)
+typedef __m128 popcorn_convert_v4;
+#else
+typedef float32x4_t popcorn_convert_v4;
+#endif
+
+static inline popcorn_convert_v4
+popcorn_convert_loadF(const char* p)
+{
+	#if defined(__SSE2__)
+	return _mm_loadu_ps((const float*) p);
+	#else
+	return vld1q_f32((const float*) p);
+	#endif
+}
+
+static inline popcorn_convert_v4
+popcorn_convert_loadS(const char* p)
+{
+	#if defined(__SSE2__)
+	__m128i v = _mm_loadl_epi64((const __m128i*) p);
+	v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+	return _mm_cvtepi32_ps(v);
+	#else
+	return vcvtq_f32_s32(vmovl_s16(vld1_s16((const int16_t*) p)));
+	#endif
+}
+
+static inline popcorn_convert_v4
+popcorn_convert_loadUS(const char* p)
+{
+	#if defined(__SSE2__)
+	__m128i v = _mm_loadl_epi64((const __m128i*) p);
+	v = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+	return _mm_cvtepi32_ps(v);
+	#else
+	return vcvtq_f32_u32(vmovl_u16(vld1_u16((const uint16_t*) p)));
+	#endif
+}
+
+static inline popcorn_convert_v4
+popcorn_convert_loadB(const char* p)
+{
+	int32_t w;
+	memcpy(&w, p, 4);
+
+	#if defined(__SSE2__)
+	__m128i v = _mm_cvtsi32_si128(w);
+	v = _mm_unpacklo_epi8(v, v);
+	v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 24);
+	return _mm_cvtepi32_ps(v);
+	#else
+	int8x8_t v = vreinterpret_s8_s32(vdup_n_s32(w));
+	return vcvtq_f32_s32(vmovl_s16(vget_low_s16(vmovl_s8(v))));
+	#endif
+}
+
+static inline popcorn_convert_v4
+popcorn_convert_loadUB(const char* p)
+{
+	int32_t w;
+	memcpy(&w, p, 4);
+
+	#if defined(__SSE2__)
+	__m128i z = _mm_setzero_si128();
+	__m128i v = _mm_cvtsi32_si128(w);
+	v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, z), z);
+	return _mm_cvtepi32_ps(v);
+	#else
+	uint8x8_t v = vreinterpret_u8_s32(vdup_n_s32(w));
+	return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(v))));
+	#endif
+}
+
+static inline void
+popcorn_convert_store(float* dst, popcorn_convert_v4 v,
+                      float scale, float lo)
+{
+	#if defined(__SSE2__)
+	v = _mm_max_ps(_mm_mul_ps(v, _mm_set1_ps(scale)),
+	               _mm_set1_ps(lo));
+	_mm_storeu_ps(dst, v);
+	#else
+	v = vmaxq_f32(vmulq_n_f32(v, scale), vdupq_n_f32(lo));
+	vst1q_f32(dst, v);
+	#endif
+}
+
+static uint32_t
+popcorn_convert_vec3fSimd(int type, float scale, float lo,
+                          const char* src, size_t stride,
+                          uint32_t count, float* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	uint32_t i;
+	uint32_t n = count - 1;
+	if(type == POPCORN_CONVERT_FLOAT)
+	{
+		for(i = 0; i < n; ++i)
+		{
+			popcorn_convert_store(&dst[3*i],
+			                      popcorn_convert_loadF(src + i*stride),
+			                      scale, lo);
+		}
+	}
+	else if(type == POPCORN_CONVERT_SHORT)
+	{
+		for(i = 0; i < n; ++i)
+		{
+			popcorn_convert_store(&dst[3*i],
+			                      popcorn_convert_loadS(src + i*stride),
+			                      scale, lo);
+		}
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_SHORT)
+	{
+		for(i = 0; i < n; ++i)
+		{
+			popcorn_convert_store(&dst[3*i],
+			                      popcorn_convert_loadUS(src + i*stride),
+			                      scale, lo);
+		}
+	}
+	else if(type == POPCORN_CONVERT_BYTE)
+	{
+		for(i = 0; i < n; ++i)
+		{
+			popcorn_convert_store(&dst[3*i],
+			                      popcorn_convert_loadB(src + i*stride),
+			                      scale, lo);
+		}
+	}
+	else
+	{
+		for(i = 0; i < n; ++i)
+		{
+			popcorn_convert_store(&dst[3*i],
+			                      popcorn_convert_loadUB(src + i*stride),
+			                      scale, lo);
+		}
+	}
+
+	return n;
+}
+
+#endif
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+size_t popcorn_convert_size(int type)
+{
+	if((type == POPCORN_CONVERT_BYTE) ||
+	   (type == POPCORN_CONVERT_UNSIGNED_BYTE))
+	{
+		return 1;
+	}
+	else if((type == POPCORN_CONVERT_SHORT) ||
+	        (type == POPCORN_CONVERT_UNSIGNED_SHORT))
+	{
+		return 2;
+	}
+	else if((type == POPCORN_CONVERT_UNSIGNED_INT) ||
+	        (type == POPCORN_CONVERT_FLOAT))
+	{
+		return 4;
+	}
+
+	return 0;
+}
+
+int popcorn_convert_indices(int type, const void* src,
+                            uint32_t count, uint32_t* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	const uint8_t* s8  = (const uint8_t*) src;
+	const char*    s16 = (const char*) src;
+
+	uint32_t i = 0;
+	if(type == POPCORN_CONVERT_UNSIGNED_BYTE)
+	{
+		#if defined(__SSE2__)
+		__m128i z = _mm_setzero_si128();
+		for(; i + 16 <= count; i += 16)
+		{
+			__m128i v  = _mm_loadu_si128((const __m128i*) &s8[i]);
+			__m128i lo = _mm_unpacklo_epi8(v, z);
+			__m128i hi = _mm_unpackhi_epi8(v, z);
+			_mm_storeu_si128((__m128i*) &dst[i],
+			                 _mm_unpacklo_epi16(lo, z));
+			_mm_storeu_si128((__m128i*) &dst[i + 4],
+			                 _mm_unpackhi_epi16(lo, z));
+			_mm_storeu_si128((__m128i*) &dst[i + 8],
+			                 _mm_unpacklo_epi16(hi, z));
+			_mm_storeu_si128((__m128i*) &dst[i + 12],
+			                 _mm_unpackhi_epi16(hi, z));
+		}
+		#elif defined(POPCORN_CONVERT_NEON)
+		for(; i + 16 <= count; i += 16)
+		{
+			uint8x16_t v  = vld1q_u8(&s8[i]);
+			uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+			uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+			vst1q_u32(&dst[i],      vmovl_u16(vget_low_u16(lo)));
+			vst1q_u32(&dst[i + 4],  vmovl_u16(vget_high_u16(lo)));
+			vst1q_u32(&dst[i + 8],  vmovl_u16(vget_low_u16(hi)));
+			vst1q_u32(&dst[i + 12], vmovl_u16(vget_high_u16(hi)));
+		}
+		#endif
+
+		for(; i < count; ++i)
+		{
+			dst[i] = s8[i];
+		}
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_SHORT)
+	{
+		#if defined(__SSE2__)
+		__m128i z = _mm_setzero_si128();
+		for(; i + 8 <= count; i += 8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*) &s16[2*i]);
+			_mm_storeu_si128((__m128i*) &dst[i],
+			                 _mm_unpacklo_epi16(v, z));
+			_mm_storeu_si128((__m128i*) &dst[i + 4],
+			                 _mm_unpackhi_epi16(v, z));
+		}
+		#elif defined(POPCORN_CONVERT_NEON)
+		for(; i + 8 <= count; i += 8)
+		{
+			uint16x8_t v = vld1q_u16((const uint16_t*) &s16[2*i]);
+			vst1q_u32(&dst[i],     vmovl_u16(vget_low_u16(v)));
+			vst1q_u32(&dst[i + 4], vmovl_u16(vget_high_u16(v)));
+		}
+		#endif
+
+		for(; i < count; ++i)
+		{
+			uint16_t s;
+			memcpy(&s, &s16[2*i], 2);
+			dst[i] = s;
+		}
+	}
+	else if(type == POPCORN_CONVERT_UNSIGNED_INT)
+	{
+		memcpy(dst, src, 4*((size_t) count));
+	}
+	else
+	{
+		LOGE("invalid type=0x%X", (uint32_t) type);
+		return 0;
+	}
+
+	return 1;
+}
+
+int popcorn_convert_narrow(const uint32_t* src, uint32_t count,
+                           uint32_t limit, uint16_t* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	if((limit == 0) || (limit > 65536))
+	{
+		LOGE("invalid limit=%u", limit);
+		return 0;
+	}
+
+	uint32_t i   = 0;
+	uint32_t bad = 0;
+
+	#if defined(__SSE2__)
+	// SSE2 lacks unsigned compares and packus_epi32 so
+	// the values are biased into the signed range
+	__m128i b32  = _mm_set1_epi32((int) 0x80000000);
+	__m128i b16  = _mm_set1_epi32(32768);
+	__m128i max  = _mm_xor_si128(_mm_set1_epi32((int) (limit - 1)),
+	                             b32);
+	__m128i flag = _mm_setzero_si128();
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*) &src[i]);
+		__m128i b = _mm_loadu_si128((const __m128i*) &src[i + 4]);
+		flag = _mm_or_si128(flag,
+		                    _mm_cmpgt_epi32(_mm_xor_si128(a, b32), max));
+		flag = _mm_or_si128(flag,
+		                    _mm_cmpgt_epi32(_mm_xor_si128(b, b32), max));
+		__m128i v = _mm_packs_epi32(_mm_sub_epi32(a, b16),
+		                            _mm_sub_epi32(b, b16));
+		_mm_storeu_si128((__m128i*) &dst[i],
+		                 _mm_add_epi16(v, _mm_set1_epi16(-32768)));
+	}
+	bad = (uint32_t) _mm_movemask_epi8(flag);
+	#elif defined(POPCORN_CONVERT_NEON)
+	uint32x4_t max  = vdupq_n_u32(limit - 1);
+	uint32x4_t flag = vdupq_n_u32(0);
+	for(; i + 8 <= count; i += 8)
+	{
+		uint32x4_t a = vld1q_u32(&src[i]);
+		uint32x4_t b = vld1q_u32(&src[i + 4]);
+		flag = vorrq_u32(flag, vcgtq_u32(a, max));
+		flag = vorrq_u32(flag, vcgtq_u32(b, max));
+		vst1q_u16(&dst[i], vcombine_u16(vmovn_u32(a), vmovn_u32(b)));
+	}
+	bad = vmaxvq_u32(flag);
+	#endif
+
+	for(; i < count; ++i)
+	{
+		if(src[i] >= limit)
+		{
+			bad = 1;
+		}
+		dst[i] = (uint16_t) src[i];
+	}
+
+	if(bad)
+	{
+		LOGE("invalid index limit=%u", limit);
+		return 0;
+	}
+
+	return 1;
+}
+
+int popcorn_convert_vec3f(int type, int normalized,
+                          const void* src, size_t stride,
+                          uint32_t count, float* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	float scale;
+	float lo;
+	if(popcorn_convert_params(type, normalized,
+	                          &scale, &lo) == 0)
+	{
+		return 0;
+	}
+
+	uint32_t first = 0;
+	#if defined(__SSE2__) || defined(POPCORN_CONVERT_NEON)
+	first = popcorn_convert_vec3fSimd(type, scale, lo,
+	                                  (const char*) src,
+	                                  stride, count, dst);
+	#endif
+
+	popcorn_convert_vec3fScalar(type, scale, lo,
+	                            (const char*) src, stride,
+	                            first, count, dst);
+	return 1;
+}
+
+int popcorn_convert_indicesRef(int type, const void* src,
+                               uint32_t count, uint32_t* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	size_t size = popcorn_convert_size(type);
+	if((type != POPCORN_CONVERT_UNSIGNED_BYTE)  &&
+	   (type != POPCORN_CONVERT_UNSIGNED_SHORT) &&
+	   (type != POPCORN_CONVERT_UNSIGNED_INT))
+	{
+		LOGE("invalid type=0x%X", (uint32_t) type);
+		return 0;
+	}
+
+	const char* p = (const char*) src;
+
+	uint32_t i;
+	for(i = 0; i < count; ++i)
+	{
+		uint32_t v = 0;
+		memcpy(&v, p + i*size, size);
+		dst[i] = v;
+	}
+
+	return 1;
+}
+
+int popcorn_convert_narrowRef(const uint32_t* src, uint32_t count,
+                              uint32_t limit, uint16_t* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	if((limit == 0) || (limit > 65536))
+	{
+		LOGE("invalid limit=%u", limit);
+		return 0;
+	}
+
+	uint32_t i;
+	for(i = 0; i < count; ++i)
+	{
+		if(src[i] >= limit)
+		{
+			LOGE("invalid index=%u, limit=%u", src[i], limit);
+			return 0;
+		}
+		dst[i] = (uint16_t) src[i];
+	}
+
+	return 1;
+}
+
+int popcorn_convert_vec3fRef(int type, int normalized,
+                             const void* src, size_t stride,
+                             uint32_t count, float* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	float scale;
+	float lo;
+	if(popcorn_convert_params(type, normalized,
+	                          &scale, &lo) == 0)
+	{
+		return 0;
+	}
+
+	popcorn_convert_vec3fScalar(type, scale, lo,
+	                            (const char*) src, stride,
+	                            0, count, dst);
+	return 1;
+}
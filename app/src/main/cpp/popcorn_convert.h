@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_convert_H
+#define popcorn_convert_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// conversion kernels from glTF component types
+// to the runtime vertex formats
+// types match the glTF componentType
+#define POPCORN_CONVERT_BYTE           0x1400
+#define POPCORN_CONVERT_UNSIGNED_BYTE  0x1401
+#define POPCORN_CONVERT_SHORT          0x1402
+#define POPCORN_CONVERT_UNSIGNED_SHORT 0x1403
+#define POPCORN_CONVERT_UNSIGNED_INT   0x1405
+#define POPCORN_CONVERT_FLOAT          0x1406
+
+size_t popcorn_convert_size(int type);
+
+// widen uint8/uint16/uint32 indices to uint32
+int popcorn_convert_indices(int type, const void* src,
+                            uint32_t count, uint32_t* dst);
+
+// narrow to uint16 and fail if an index exceeds the
+// vertex count limit which must be at most 65536
+int popcorn_convert_narrow(const uint32_t* src, uint32_t count,
+                           uint32_t limit, uint16_t* dst);
+
+// gather strided vec3 attributes to packed floats
+// normalized integers are converted per the glTF rules
+int popcorn_convert_vec3f(int type, int normalized,
+                          const void* src, size_t stride,
+                          uint32_t count, float* dst);
+
+// scalar reference kernels
+int popcorn_convert_indicesRef(int type, const void* src,
+                               uint32_t count, uint32_t* dst);
+int popcorn_convert_narrowRef(const uint32_t* src, uint32_t count,
+                              uint32_t limit, uint16_t* dst);
+int popcorn_convert_vec3fRef(int type, int normalized,
+                             const void* src, size_t stride,
+                             uint32_t count, float* dst);
+
+#endif
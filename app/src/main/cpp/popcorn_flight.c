@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/math/cc_mat4f.h"
+#include "libcc/cc_log.h"
+#include "popcorn_flight.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int popcorn_flight_rebase(popcorn_flightState_t* state)
+{
+	ASSERT(state);
+
+	float* p[] =
+	{
+		&state->position.x,
+		&state->position.y,
+		&state->position.z,
+	};
+
+	int rebase = 0;
+	int i;
+	for(i = 0; i < 3; ++i)
+	{
+		if(fabsf(*p[i]) > POPCORN_FLIGHT_REBASE)
+		{
+			// move to the sector containing the position
+			float   c     = floorf(*p[i]/POPCORN_FLIGHT_CELL + 0.5f);
+			int32_t cells = (int32_t) c;
+			state->sector[i] += cells;
+			*p[i] -= POPCORN_FLIGHT_CELL*c;
+			rebase = 1;
+		}
+	}
+
+	return rebase;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+void popcorn_flight_reset(popcorn_flightState_t* state)
+{
+	ASSERT(state);
+
+	state->speed        = 0.0f;
+	state->acceleration = 0.0f;
+	state->sector[0]    = 0;
+	state->sector[1]    = 0;
+	state->sector[2]    = 0;
+	cc_vec3f_load(&state->position, 0.0f, 0.0f, 0.0f);
+	cc_quaternion_identity(&state->attitude);
+	++state->resets;
+}
+
+uint32_t popcorn_flight_step(popcorn_flightState_t* state,
+                             const popcorn_inputState_t* in,
+                             popcorn_collision_t* collision,
+                             double t)
+{
+	ASSERT(state);
+	ASSERT(in);
+	ASSERT(collision);
+
+	uint32_t flags = 0;
+
+	// apply the input which occurred before the tick
+	if(in->reset)
+	{
+		popcorn_flight_reset(state);
+		flags |= POPCORN_FLIGHT_FLAG_RESET;
+	}
+	state->acceleration += in->acceleration;
+
+	state->roll  = in->axis[POPCORN_INPUT_AXIS_ROLL];
+	state->pitch = in->axis[POPCORN_INPUT_AXIS_PITCH];
+	state->rx    = in->axis[POPCORN_INPUT_AXIS_HEAD_X];
+	state->ry    = in->axis[POPCORN_INPUT_AXIS_HEAD_Y];
+	state->yaw1  = in->axis[POPCORN_INPUT_AXIS_YAW1];
+	state->yaw2  = in->axis[POPCORN_INPUT_AXIS_YAW2];
+
+	// compute the attitude change
+	float rate  = 45.0f/60.0f;
+	float yaw   = rate*(state->yaw1 - state->yaw2);
+	float pitch = -rate*state->pitch;
+	float roll  = -rate*state->roll;
+	cc_quaternion_t q;
+	cc_quaternion_loadeuler(&q, roll, pitch, yaw);
+
+	// update attitude
+	// post multiply the current attitude
+	// Flight Simulators and Quaternions
+	// https://flylib.com/books/en/2.208.1.130/1/
+	cc_quaternion_rotateq(&q, &state->attitude);
+	cc_quaternion_copy(&q, &state->attitude);
+
+	// remap orientation
+	// see the principle axes of an aircraft
+	// https://en.wikipedia.org/wiki/Euler_angles
+	cc_mat4f_t mnm; // model-normal-matrix
+	cc_mat4f_lookat(&mnm, 1,
+	                0.0f, 0.0f, 0.0f,
+	                1.0f, 0.0f, 0.0f,
+	                0.0f, 0.0f, -1.0f);
+	cc_mat4f_rotateq(&mnm, 0, &state->attitude);
+
+	// compute direction
+	cc_vec3f_t direction;
+	cc_vec3f_load(&direction, -mnm.m20, -mnm.m21, -mnm.m22);
+
+	// update speed
+	state->speed += 0.0001f*state->acceleration;
+	if(state->speed < 0.0f)
+	{
+		state->speed = 0.0f;
+	}
+	else if(state->speed > POPCORN_FLIGHT_SPEED_MAX)
+	{
+		state->speed = POPCORN_FLIGHT_SPEED_MAX;
+	}
+
+	// update position
+	cc_vec3f_t velocity;
+	cc_vec3f_t position;
+	cc_vec3f_muls_copy(&direction, state->speed, &velocity);
+	cc_vec3f_addv_copy(&state->position, &velocity, &position);
+
+	// the collision meshes are not rebased so the sweep
+	// is tested in world coordinates where the meshes are
+	// near the world origin
+	int32_t    zero[3] = { 0, 0, 0 };
+	cc_vec3f_t origin;
+	cc_vec3f_t p0;
+	cc_vec3f_t p1;
+	popcorn_flight_offset(state->sector, zero, &origin);
+	cc_vec3f_addv_copy(&state->position, &origin, &p0);
+	cc_vec3f_addv_copy(&position, &origin, &p1);
+	if(popcorn_collision_sweep(collision, &p0, &p1,
+	                           POPCORN_FLIGHT_RADIUS,
+	                           &state->contact))
+	{
+		// reset on collision
+		++state->contacts;
+		popcorn_flight_reset(state);
+		flags |= POPCORN_FLIGHT_FLAG_CONTACT |
+		         POPCORN_FLIGHT_FLAG_RESET;
+	}
+	else
+	{
+		cc_vec3f_copy(&position, &state->position);
+		if(popcorn_flight_rebase(state))
+		{
+			flags |= POPCORN_FLIGHT_FLAG_REBASE;
+		}
+	}
+
+	state->t = t;
+	++state->tick;
+
+	return flags;
+}
+
+void popcorn_flight_world(const popcorn_flightState_t* state,
+                          double* world)
+{
+	ASSERT(state);
+	ASSERT(world);
+
+	world[0] = ((double) POPCORN_FLIGHT_CELL)*state->sector[0] +
+	           (double) state->position.x;
+	world[1] = ((double) POPCORN_FLIGHT_CELL)*state->sector[1] +
+	           (double) state->position.y;
+	world[2] = ((double) POPCORN_FLIGHT_CELL)*state->sector[2] +
+	           (double) state->position.z;
+}
+
+void popcorn_flight_offset(const int32_t* from,
+                           const int32_t* to,
+                           cc_vec3f_t* offset)
+{
+	ASSERT(from);
+	ASSERT(to);
+	ASSERT(offset);
+
+	// origin of the from sector relative to the to sector
+	// the difference is exact in integers
+	offset->x = POPCORN_FLIGHT_CELL*((float) (from[0] - to[0]));
+	offset->y = POPCORN_FLIGHT_CELL*((float) (from[1] - to[1]));
+	offset->z = POPCORN_FLIGHT_CELL*((float) (from[2] - to[2]));
+}
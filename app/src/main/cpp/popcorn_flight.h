@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_flight_H
+#define popcorn_flight_H
+
+#include <stdint.h>
+
+#include "libcc/math/cc_quaternion.h"
+#include "libcc/math/cc_vec3f.h"
+#include "popcorn_collision.h"
+#include "popcorn_input.h"
+
+// flight model
+// the flight model has no thread, renderer or recorder
+// dependencies so it may be stepped headless
+// see popcorn_sim for the realtime thread and
+// popcorn_simrun for the batch runner
+
+// collision radius of the aircraft
+#define POPCORN_FLIGHT_RADIUS 0.01f
+
+// maximum speed per tick
+#define POPCORN_FLIGHT_SPEED_MAX 0.005f
+
+// floating origin
+// the world is divided into sector cells and the position
+// is relative to the center of the sector so the float
+// position stays small at any distance from the origin
+// world = POPCORN_FLIGHT_CELL*sector + position
+#define POPCORN_FLIGHT_CELL 1.0f
+
+// the aircraft is rebased to the sector containing it
+// once it leaves its cell by a margin so flying along a
+// cell boundary does not rebase every tick
+#define POPCORN_FLIGHT_REBASE (0.75f*POPCORN_FLIGHT_CELL)
+
+typedef struct
+{
+	// simulation time at the end of the tick
+	double   t;
+	uint32_t tick;
+
+	// incremented when the state is reset to
+	// prevent interpolating across a reset
+	uint32_t resets;
+
+	// controls
+	float yaw1;
+	float yaw2;
+	float pitch;
+	float roll;
+	float rx;
+	float ry;
+
+	// attitude
+	cc_quaternion_t attitude;
+
+	// position
+	float      acceleration;
+	float      speed;
+	int32_t    sector[3];
+	cc_vec3f_t position;
+
+	// most recent collision
+	uint32_t          contacts;
+	popcorn_contact_t contact;
+} popcorn_flightState_t;
+
+// events which occurred during a step
+#define POPCORN_FLIGHT_FLAG_RESET   0x1
+#define POPCORN_FLIGHT_FLAG_CONTACT 0x2
+#define POPCORN_FLIGHT_FLAG_REBASE  0x4
+
+void     popcorn_flight_reset(popcorn_flightState_t* state);
+uint32_t popcorn_flight_step(popcorn_flightState_t* state,
+                             const popcorn_inputState_t* in,
+                             popcorn_collision_t* collision,
+                             double t);
+void     popcorn_flight_world(const popcorn_flightState_t* state,
+                              double* world);
+void     popcorn_flight_offset(const int32_t* from,
+                               const int32_t* to,
+                               cc_vec3f_t* offset);
+
+#endif
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_frametime.h"
+#include "popcorn_memory.h"
+
+static const char* POPCORN_FRAMETIME_CAUSE_NAME[] =
+{
+	"upload",
+	"pipeline",
+	"events",
+	"alloc",
+	"unknown",
+};
+
+// causes marked since the last frame
+static atomic_uint
+popcorn_frametime_pending[POPCORN_FRAMETIME_CAUSE_COUNT];
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static uint32_t popcorn_frametime_bin(float ms)
+{
+	if(ms <= 0.0f)
+	{
+		return 0;
+	}
+
+	float b = ms/POPCORN_FRAMETIME_BIN_MS;
+	if(b >= (float) (POPCORN_FRAMETIME_BINS - 1))
+	{
+		return POPCORN_FRAMETIME_BINS - 1;
+	}
+
+	return (uint32_t) b;
+}
+
+static float
+popcorn_frametime_percentile(const uint32_t* hist,
+                             uint32_t count, float p)
+{
+	ASSERT(hist);
+
+	if(count == 0)
+	{
+		return 0.0f;
+	}
+
+	// center of the first bin which reaches the percentile
+	uint32_t target = (uint32_t) (p*((float) count));
+	uint32_t sum    = 0;
+	uint32_t b;
+	for(b = 0; b < POPCORN_FRAMETIME_BINS; ++b)
+	{
+		sum += hist[b];
+		if(sum > target)
+		{
+			break;
+		}
+	}
+
+	if(b >= POPCORN_FRAMETIME_BINS)
+	{
+		b = POPCORN_FRAMETIME_BINS - 1;
+	}
+
+	return (((float) b) + 0.5f)*POPCORN_FRAMETIME_BIN_MS;
+}
+
+static uint32_t popcorn_frametime_causes(void)
+{
+	uint32_t causes = 0;
+	uint32_t count;
+	int      i;
+	for(i = 0; i < POPCORN_FRAMETIME_CAUSE_COUNT; ++i)
+	{
+		count = atomic_exchange(&popcorn_frametime_pending[i], 0);
+
+		// a few events per frame are expected
+		if((i == POPCORN_FRAMETIME_CAUSE_EVENTS) &&
+		   (count < POPCORN_FRAMETIME_BURST))
+		{
+			continue;
+		}
+
+		if(count)
+		{
+			causes |= 1 << i;
+		}
+	}
+
+	return causes;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_frametime_t* popcorn_frametime_new(void)
+{
+	popcorn_frametime_t* self;
+	self = (popcorn_frametime_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_frametime_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	return self;
+}
+
+void popcorn_frametime_delete(popcorn_frametime_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_frametime_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_frametime_mark(popcorn_frametimeCause_e cause)
+{
+	ASSERT(cause < POPCORN_FRAMETIME_CAUSE_COUNT);
+
+	atomic_fetch_add(&popcorn_frametime_pending[cause], 1);
+}
+
+int popcorn_frametime_frame(popcorn_frametime_t* self,
+                            float ms)
+{
+	ASSERT(self);
+
+	uint32_t causes = popcorn_frametime_causes();
+
+	// the frame is compared with the median of the
+	// previous frames so a hitch does not mask itself
+	int hitch = 0;
+	if((self->frames >= POPCORN_FRAMETIME_WARMUP) &&
+	   (ms > POPCORN_FRAMETIME_HITCH*self->median))
+	{
+		hitch = 1;
+	}
+
+	// replace the oldest frame in the window
+	uint32_t head = self->head;
+	if(self->frames >= POPCORN_FRAMETIME_WINDOW)
+	{
+		--self->window[popcorn_frametime_bin(self->ms[head])];
+	}
+	self->ms[head]      = ms;
+	self->hitched[head] = (uint8_t) hitch;
+	self->head          = (head + 1)%POPCORN_FRAMETIME_WINDOW;
+
+	uint32_t bin = popcorn_frametime_bin(ms);
+	++self->window[bin];
+	++self->session[bin];
+	self->total += (double) ms;
+	if(ms > self->max)
+	{
+		self->max = ms;
+	}
+	++self->frames;
+
+	uint32_t n = self->frames;
+	if(n > POPCORN_FRAMETIME_WINDOW)
+	{
+		n = POPCORN_FRAMETIME_WINDOW;
+	}
+	self->median = popcorn_frametime_percentile(self->window,
+	                                            n, 0.5f);
+
+	if(hitch == 0)
+	{
+		return 0;
+	}
+
+	popcorn_frametimeHitch_t* h;
+	h = &self->hitch[self->hitch_count%POPCORN_FRAMETIME_HITCHES];
+	h->frame  = self->frames - 1;
+	h->ms     = ms;
+	h->median = self->median;
+	h->causes = causes;
+	++self->hitch_count;
+
+	if(causes == 0)
+	{
+		++self->hitch_cause[POPCORN_FRAMETIME_CAUSE_COUNT];
+	}
+
+	int i;
+	for(i = 0; i < POPCORN_FRAMETIME_CAUSE_COUNT; ++i)
+	{
+		if(causes & (1 << i))
+		{
+			++self->hitch_cause[i];
+		}
+	}
+
+	LOGW("hitch frame=%u, ms=%.2f, median=%.2f, causes=0x%X",
+	     h->frame, ms, h->median, causes);
+
+	return 1;
+}
+
+float popcorn_frametime_recent(popcorn_frametime_t* self,
+                               uint32_t i, int* hitch)
+{
+	ASSERT(self);
+	ASSERT(hitch);
+
+	// i=0 is the most recent frame
+	*hitch = 0;
+	if((i >= POPCORN_FRAMETIME_WINDOW) || (i >= self->frames))
+	{
+		return 0.0f;
+	}
+
+	uint32_t idx = (self->head + POPCORN_FRAMETIME_WINDOW - 1 - i)%
+	               POPCORN_FRAMETIME_WINDOW;
+	*hitch = self->hitched[idx];
+	return self->ms[idx];
+}
+
+int popcorn_frametime_report(popcorn_frametime_t* self,
+                             const char* fname)
+{
+	ASSERT(self);
+	ASSERT(fname);
+
+	float mean = 0.0f;
+	if(self->frames)
+	{
+		mean = (float) (self->total/((double) self->frames));
+	}
+
+	float p50 = popcorn_frametime_percentile(self->session,
+	                                         self->frames, 0.5f);
+	float p90 = popcorn_frametime_percentile(self->session,
+	                                         self->frames, 0.9f);
+	float p99 = popcorn_frametime_percentile(self->session,
+	                                         self->frames, 0.99f);
+
+	LOGI("frames=%u, mean=%.2f, p50=%.2f, p90=%.2f, p99=%.2f, max=%.2f",
+	     self->frames, mean, p50, p90, p99, self->max);
+
+	int i;
+	LOGI("hitches=%u", self->hitch_count);
+	for(i = 0; i <= POPCORN_FRAMETIME_CAUSE_COUNT; ++i)
+	{
+		LOGI("%-10s %8u", POPCORN_FRAMETIME_CAUSE_NAME[i],
+		     self->hitch_cause[i]);
+	}
+
+	FILE* f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("invalid %s", fname);
+		return 0;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"frames\": %u,\n", self->frames);
+	fprintf(f, "\t\"mean_ms\": %.3f,\n", mean);
+	fprintf(f, "\t\"p50_ms\": %.3f,\n", p50);
+	fprintf(f, "\t\"p90_ms\": %.3f,\n", p90);
+	fprintf(f, "\t\"p99_ms\": %.3f,\n", p99);
+	fprintf(f, "\t\"max_ms\": %.3f,\n", self->max);
+	fprintf(f, "\t\"hitches\": %u,\n", self->hitch_count);
+	fprintf(f, "\t\"causes\":\n\t{\n");
+	for(i = 0; i <= POPCORN_FRAMETIME_CAUSE_COUNT; ++i)
+	{
+		fprintf(f, "\t\t\"%s\": %u%s\n",
+		        POPCORN_FRAMETIME_CAUSE_NAME[i],
+		        self->hitch_cause[i],
+		        (i < POPCORN_FRAMETIME_CAUSE_COUNT) ? "," : "");
+	}
+	fprintf(f, "\t},\n");
+
+	// the most recent hitches in order
+	uint32_t count = self->hitch_count;
+	uint32_t first = 0;
+	if(count > POPCORN_FRAMETIME_HITCHES)
+	{
+		first = count - POPCORN_FRAMETIME_HITCHES;
+	}
+
+	fprintf(f, "\t\"recent\":\n\t[\n");
+	uint32_t j;
+	for(j = first; j < count; ++j)
+	{
+		popcorn_frametimeHitch_t* h;
+		h = &self->hitch[j%POPCORN_FRAMETIME_HITCHES];
+		fprintf(f, "\t\t{ \"frame\": %u, \"ms\": %.3f, "
+		           "\"median_ms\": %.3f, \"causes\": [",
+		        h->frame, h->ms, h->median);
+
+		int sep = 0;
+		for(i = 0; i < POPCORN_FRAMETIME_CAUSE_COUNT; ++i)
+		{
+			if(h->causes & (1 << i))
+			{
+				fprintf(f, "%s\"%s\"", sep ? ", " : "",
+				        POPCORN_FRAMETIME_CAUSE_NAME[i]);
+				sep = 1;
+			}
+		}
+		fprintf(f, "] }%s\n", (j + 1 < count) ? "," : "");
+	}
+	fprintf(f, "\t]\n}\n");
+	fclose(f);
+
+	return 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_frametime_H
+#define popcorn_frametime_H
+
+#include <stdint.h>
+
+// frame time histogram and hitch detector
+// frame times are binned into a rolling histogram over the
+// last POPCORN_FRAMETIME_WINDOW frames (for the median) and
+// a session histogram (for the summary)
+#define POPCORN_FRAMETIME_WINDOW 256
+#define POPCORN_FRAMETIME_BINS   256
+#define POPCORN_FRAMETIME_BIN_MS 0.25f
+
+// a hitch is a frame slower than 2x the rolling median
+// once the window has enough frames
+#define POPCORN_FRAMETIME_HITCH  2.0f
+#define POPCORN_FRAMETIME_WARMUP 30
+#define POPCORN_FRAMETIME_HITCHES 64
+
+// events per frame which are considered a burst
+#define POPCORN_FRAMETIME_BURST 16
+
+// causes are marked from any thread during a frame and
+// are attributed to the next frame time
+typedef enum
+{
+	POPCORN_FRAMETIME_CAUSE_UPLOAD   = 0,
+	POPCORN_FRAMETIME_CAUSE_PIPELINE = 1,
+	POPCORN_FRAMETIME_CAUSE_EVENTS   = 2,
+	POPCORN_FRAMETIME_CAUSE_ALLOC    = 3,
+} popcorn_frametimeCause_e;
+
+#define POPCORN_FRAMETIME_CAUSE_COUNT 4
+
+typedef struct
+{
+	uint32_t frame;
+	float    ms;
+	float    median;
+	uint32_t causes;
+} popcorn_frametimeHitch_t;
+
+typedef struct popcorn_frametime_s
+{
+	uint32_t frames;
+
+	// rolling window
+	uint32_t head;
+	float    ms[POPCORN_FRAMETIME_WINDOW];
+	uint8_t  hitched[POPCORN_FRAMETIME_WINDOW];
+	uint32_t window[POPCORN_FRAMETIME_BINS];
+	float    median;
+
+	// session
+	uint32_t session[POPCORN_FRAMETIME_BINS];
+	float    max;
+	double   total;
+
+	// hitches
+	uint32_t                 hitch_count;
+	uint32_t                 hitch_cause[POPCORN_FRAMETIME_CAUSE_COUNT + 1];
+	popcorn_frametimeHitch_t hitch[POPCORN_FRAMETIME_HITCHES];
+} popcorn_frametime_t;
+
+popcorn_frametime_t* popcorn_frametime_new(void);
+void                 popcorn_frametime_delete(popcorn_frametime_t** _self);
+void                 popcorn_frametime_mark(popcorn_frametimeCause_e cause);
+int                  popcorn_frametime_frame(popcorn_frametime_t* self,
+                                             float ms);
+float                popcorn_frametime_recent(popcorn_frametime_t* self,
+                                              uint32_t i, int* hitch);
+int                  popcorn_frametime_report(popcorn_frametime_t* self,
+                                              const char* fname);
+
+#endif
@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_convert.h"
+#include "popcorn_gltf.h"
+#include "popcorn_memory.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int
+popcorn_gltf_resize(void** _buf, size_t* _size, size_t size)
+{
+	ASSERT(_buf);
+	ASSERT(_size);
+
+	if(*_size >= size)
+	{
+		return 1;
+	}
+
+	void* buf;
+	buf = popcorn_memory_realloc(POPCORN_MEMORY_TAG_MESH,
+	                             *_buf, size);
+	if(buf == NULL)
+	{
+		LOGE("REALLOC failed");
+		return 0;
+	}
+
+	*_buf  = buf;
+	*_size = size;
+
+	return 1;
+}
+
+static const char*
+popcorn_gltf_data(gltf_file_t* file, gltf_accessor_t* accessor,
+                  uint32_t components, size_t* _stride)
+{
+	ASSERT(file);
+	ASSERT(accessor);
+	ASSERT(_stride);
+
+	// sparse accessors are not supported
+	if(accessor->has_bufferView == 0)
+	{
+		LOGE("invalid bufferView");
+		return NULL;
+	}
+
+	size_t size = popcorn_convert_size(accessor->componentType);
+	if((size == 0) || (accessor->count == 0))
+	{
+		LOGE("invalid componentType=0x%X, count=%u",
+		     (uint32_t) accessor->componentType, accessor->count);
+		return NULL;
+	}
+
+	gltf_bufferView_t* bv;
+	bv = gltf_file_getBufferView(file, accessor->bufferView);
+	if(bv == NULL)
+	{
+		LOGE("invalid bufferView=%u", accessor->bufferView);
+		return NULL;
+	}
+
+	// elements are tightly packed w/o a byteStride
+	size_t elem   = components*size;
+	size_t stride = elem;
+	if(bv->has_byteStride)
+	{
+		stride = bv->byteStride;
+	}
+
+	size_t end = accessor->byteOffset +
+	             (accessor->count - 1)*stride + elem;
+	if((stride < elem) || (end > bv->byteLength))
+	{
+		LOGE("invalid stride=%u, end=%u, byteLength=%u",
+		     (uint32_t) stride, (uint32_t) end, bv->byteLength);
+		return NULL;
+	}
+
+	const char* buf = gltf_file_getBuffer(file, bv);
+	if(buf == NULL)
+	{
+		LOGE("invalid buffer=%u", bv->buffer);
+		return NULL;
+	}
+
+	*_stride = stride;
+	return buf + accessor->byteOffset;
+}
+
+static int
+popcorn_gltf_loadIndices(popcorn_gltf_t* self,
+                         gltf_file_t* file,
+                         gltf_primitive_t* primitive,
+                         uint32_t* _count)
+{
+	ASSERT(self);
+	ASSERT(file);
+	ASSERT(primitive);
+	ASSERT(_count);
+
+	// generate indices for non-indexed primitives
+	uint32_t i;
+	uint32_t count = self->vc;
+	if(primitive->has_indices == 0)
+	{
+		if(popcorn_gltf_resize((void**) &self->idx, &self->size_idx,
+		                       2*((size_t) count)) == 0)
+		{
+			return 0;
+		}
+
+		for(i = 0; i < count; ++i)
+		{
+			self->idx[i] = (uint16_t) i;
+		}
+
+		*_count = count;
+		return 1;
+	}
+
+	gltf_accessor_t* aib;
+	aib = gltf_file_getAccessor(file, primitive->indices);
+	if((aib == NULL) ||
+	   (aib->type != GLTF_ACCESSOR_TYPE_SCALAR))
+	{
+		LOGE("invalid indices=%u", primitive->indices);
+		return 0;
+	}
+
+	size_t      stride;
+	const char* src;
+	src = popcorn_gltf_data(file, aib, 1, &stride);
+	if(src == NULL)
+	{
+		return 0;
+	}
+
+	// index bufferViews must not define a byteStride
+	count = aib->count;
+	if(stride != popcorn_convert_size(aib->componentType))
+	{
+		LOGE("invalid stride=%u", (uint32_t) stride);
+		return 0;
+	}
+
+	if((popcorn_gltf_resize((void**) &self->tmp, &self->size_tmp,
+	                        4*((size_t) count)) == 0) ||
+	   (popcorn_gltf_resize((void**) &self->idx, &self->size_idx,
+	                        2*((size_t) count)) == 0))
+	{
+		return 0;
+	}
+
+	// widen then narrow to uint16 which also
+	// validates the indices against the vertex count
+	if((popcorn_convert_indices(aib->componentType, src,
+	                            count, self->tmp) == 0) ||
+	   (popcorn_convert_narrow(self->tmp, count, self->vc,
+	                           self->idx) == 0))
+	{
+		return 0;
+	}
+
+	*_count = count;
+	return 1;
+}
+
+static int
+popcorn_gltf_loadTriangles(popcorn_gltf_t* self,
+                           gltf_primitive_t* primitive,
+                           uint32_t count)
+{
+	ASSERT(self);
+	ASSERT(primitive);
+
+	// convert strips and fans to lists
+	uint32_t tc = count/3;
+	if(primitive->mode != GLTF_PRIMITIVE_MODE_TRIANGLES)
+	{
+		tc = (count < 3) ? 0 : count - 2;
+	}
+
+	if((tc == 0) ||
+	   ((primitive->mode == GLTF_PRIMITIVE_MODE_TRIANGLES) &&
+	    (count % 3)))
+	{
+		LOGE("invalid mode=%i, count=%u",
+		     (int) primitive->mode, count);
+		return 0;
+	}
+
+	if(popcorn_gltf_resize((void**) &self->ib, &self->size_ib,
+	                       6*((size_t) tc)) == 0)
+	{
+		return 0;
+	}
+
+	uint32_t  i;
+	uint16_t* src = self->idx;
+	uint16_t* dst = self->ib;
+	if(primitive->mode == GLTF_PRIMITIVE_MODE_TRIANGLES)
+	{
+		memcpy(dst, src, 6*((size_t) tc));
+	}
+	else if(primitive->mode == GLTF_PRIMITIVE_MODE_TRIANGLE_STRIP)
+	{
+		// odd triangles swap vertices to preserve the winding
+		for(i = 0; i < tc; ++i)
+		{
+			dst[3*i]     = src[i];
+			dst[3*i + 1] = src[i + 1 + (i & 1)];
+			dst[3*i + 2] = src[i + 2 - (i & 1)];
+		}
+	}
+	else
+	{
+		for(i = 0; i < tc; ++i)
+		{
+			dst[3*i]     = src[i + 1];
+			dst[3*i + 1] = src[i + 2];
+			dst[3*i + 2] = src[0];
+		}
+	}
+
+	self->ic = 3*tc;
+	return 1;
+}
+
+static int
+popcorn_gltf_loadVec3f(gltf_file_t* file,
+                       gltf_accessor_t* accessor,
+                       float* dst)
+{
+	ASSERT(file);
+	ASSERT(accessor);
+	ASSERT(dst);
+
+	if(accessor->type != GLTF_ACCESSOR_TYPE_VEC3)
+	{
+		LOGE("invalid type=0x%X", (uint32_t) accessor->type);
+		return 0;
+	}
+
+	size_t      stride;
+	const char* src;
+	src = popcorn_gltf_data(file, accessor, 3, &stride);
+	if(src == NULL)
+	{
+		return 0;
+	}
+
+	return popcorn_convert_vec3f(accessor->componentType,
+	                             accessor->normalized,
+	                             src, stride,
+	                             accessor->count, dst);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_gltf_t* popcorn_gltf_new(void)
+{
+	popcorn_gltf_t* self;
+	self = (popcorn_gltf_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                             1, sizeof(popcorn_gltf_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	return self;
+}
+
+void popcorn_gltf_delete(popcorn_gltf_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_gltf_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->idx);
+		popcorn_memory_free(self->tmp);
+		popcorn_memory_free(self->nb);
+		popcorn_memory_free(self->vb);
+		popcorn_memory_free(self->ib);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_gltf_isTriangles(gltf_primitive_t* primitive)
+{
+	ASSERT(primitive);
+
+	if((primitive->mode == GLTF_PRIMITIVE_MODE_TRIANGLES)      ||
+	   (primitive->mode == GLTF_PRIMITIVE_MODE_TRIANGLE_STRIP) ||
+	   (primitive->mode == GLTF_PRIMITIVE_MODE_TRIANGLE_FAN))
+	{
+		return 1;
+	}
+
+	LOGW("skipping mode=%i", (int) primitive->mode);
+	return 0;
+}
+
+int popcorn_gltf_load(popcorn_gltf_t* self,
+                      gltf_file_t* file,
+                      gltf_primitive_t* primitive)
+{
+	ASSERT(self);
+	ASSERT(file);
+	ASSERT(primitive);
+
+	gltf_accessor_t* anb = NULL;
+	gltf_accessor_t* avb = NULL;
+
+	// get accessors
+	cc_listIter_t* iter;
+	iter = cc_list_head(primitive->attributes);
+	while(iter)
+	{
+		gltf_attribute_t* attr;
+		attr = (gltf_attribute_t*) cc_list_peekIter(iter);
+
+		if(strcmp(attr->name, "POSITION") == 0)
+		{
+			avb = gltf_file_getAccessor(file, attr->accessor);
+		}
+		else if(strcmp(attr->name, "NORMAL") == 0)
+		{
+			anb = gltf_file_getAccessor(file, attr->accessor);
+		}
+
+		iter = cc_list_next(iter);
+	}
+	if((anb == NULL) || (avb == NULL))
+	{
+		LOGE("invalid accessors=%p,%p", anb, avb);
+		return 0;
+	}
+
+	// the runtime uses uint16 indices
+	uint32_t vc = avb->count;
+	if((vc == 0) || (vc > 65536) || (anb->count != vc))
+	{
+		LOGE("invalid count=%u,%u", avb->count, anb->count);
+		return 0;
+	}
+	self->vc = vc;
+
+	if((popcorn_gltf_resize((void**) &self->vb, &self->size_vb,
+	                        12*((size_t) vc)) == 0) ||
+	   (popcorn_gltf_resize((void**) &self->nb, &self->size_nb,
+	                        12*((size_t) vc)) == 0))
+	{
+		return 0;
+	}
+
+	if((popcorn_gltf_loadVec3f(file, avb, self->vb) == 0) ||
+	   (popcorn_gltf_loadVec3f(file, anb, self->nb) == 0))
+	{
+		return 0;
+	}
+
+	uint32_t count;
+	if((popcorn_gltf_loadIndices(self, file, primitive,
+	                             &count) == 0) ||
+	   (popcorn_gltf_loadTriangles(self, primitive,
+	                               count) == 0))
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+void popcorn_gltf_local(gltf_node_t* node, cc_mat4f_t* local)
+{
+	ASSERT(node);
+	ASSERT(local);
+
+	// glTF matrices are column-major like cc_mat4f_t
+	if(node->has_matrix)
+	{
+		memcpy(local, node->matrix, sizeof(cc_mat4f_t));
+		return;
+	}
+
+	// local = T*R*S
+	cc_quaternion_t q =
+	{
+		.v =
+		{
+			.x = node->rotation[0],
+			.y = node->rotation[1],
+			.z = node->rotation[2],
+		},
+		.s = node->rotation[3],
+	};
+	cc_mat4f_translate(local, 1, node->translation[0],
+	                   node->translation[1],
+	                   node->translation[2]);
+	cc_mat4f_rotateq(local, 0, &q);
+	cc_mat4f_scale(local, 0, node->scale[0],
+	               node->scale[1], node->scale[2]);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_gltf_H
+#define popcorn_gltf_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libcc/math/cc_mat4f.h"
+#include "libgltf/gltf.h"
+
+// maximum node hierarchy depth which also guards
+// against cycles in invalid files
+#define POPCORN_GLTF_DEPTH 32
+
+// glTF primitive loader
+// accepts strided/interleaved bufferViews, uint8/uint16/uint32
+// indices, normalized integer attributes and triangle
+// strips/fans which are converted to uint16 triangle lists
+// with float3 positions and normals
+typedef struct
+{
+	// converted primitive
+	uint32_t  ic;
+	uint32_t  vc;
+	uint16_t* ib;
+	float*    vb;
+	float*    nb;
+
+	// scratch buffers are reused across primitives
+	size_t    size_ib;
+	size_t    size_vb;
+	size_t    size_nb;
+	size_t    size_tmp;
+	size_t    size_idx;
+	uint32_t* tmp;
+	uint16_t* idx;
+} popcorn_gltf_t;
+
+popcorn_gltf_t* popcorn_gltf_new(void);
+void            popcorn_gltf_delete(popcorn_gltf_t** _self);
+int             popcorn_gltf_isTriangles(gltf_primitive_t* primitive);
+int             popcorn_gltf_load(popcorn_gltf_t* self,
+                                  gltf_file_t* file,
+                                  gltf_primitive_t* primitive);
+void            popcorn_gltf_local(gltf_node_t* node,
+                                   cc_mat4f_t* local);
+
+#endif
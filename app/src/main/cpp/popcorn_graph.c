@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_frametime.h"
+#include "popcorn_graph.h"
+#include "popcorn_memory.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static void
+popcorn_graph_quad(popcorn_graph_t* self, uint32_t idx,
+                   float l, float t, float r, float b,
+                   const float* rgba)
+{
+	ASSERT(self);
+	ASSERT(idx < POPCORN_GRAPH_QUADS);
+	ASSERT(rgba);
+
+	float xy[] =
+	{
+		l, t, l, b, r, b,
+		l, t, r, b, r, t,
+	};
+
+	float* dst_xy   = &self->xy[12*idx];
+	float* dst_rgba = &self->rgba[24*idx];
+
+	int i;
+	for(i = 0; i < 12; ++i)
+	{
+		dst_xy[i] = xy[i];
+	}
+
+	for(i = 0; i < 24; ++i)
+	{
+		dst_rgba[i] = rgba[i%4];
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_graph_t* popcorn_graph_new(vkk_engine_t* engine,
+                                   popcorn_shader_t* shader,
+                                   popcorn_startup_t* startup)
+{
+	ASSERT(engine);
+	ASSERT(shader);
+	ASSERT(startup);
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(engine);
+
+	popcorn_graph_t* self;
+	self = (popcorn_graph_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_graph_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->engine = engine;
+
+	vkk_uniformBinding_t ub_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformMvp
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.stage   = VKK_STAGE_VS,
+		},
+	};
+
+	self->usf0 = vkk_uniformSetFactory_new(engine,
+	                                       VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                       1, ub_array0);
+	if(self->usf0 == NULL)
+	{
+		goto fail_usf0;
+	}
+
+	vkk_uniformSetFactory_t* usf_array[] =
+	{
+		self->usf0,
+	};
+
+	self->pl = vkk_pipelineLayout_new(engine,
+	                                  1, usf_array);
+	if(self->pl == NULL)
+	{
+		goto fail_pl;
+	}
+
+	vkk_vertexBufferInfo_t vbi[] =
+	{
+		// layout(location=0) in vec2 xy;
+		{
+			.location   = 0,
+			.components = 2,
+			.format     = VKK_VERTEX_FORMAT_FLOAT
+		},
+		// layout(location=1) in vec4 rgba;
+		{
+			.location   = 1,
+			.components = 4,
+			.format     = VKK_VERTEX_FORMAT_FLOAT
+		},
+	};
+
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(shader, "graph.vert", 0);
+	fs = popcorn_shader_lookup(shader, "graph.frag", 0);
+	if((vs == NULL) || (fs == NULL))
+	{
+		goto fail_gp;
+	}
+
+	vkk_graphicsPipelineInfo_t gpi =
+	{
+		.renderer          = rend,
+		.pl                = self->pl,
+		.vs                = vs,
+		.fs                = fs,
+		.vb_count          = 2,
+		.vbi               = vbi,
+		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
+		.primitive_restart = 0,
+		.cull_back         = 0,
+		.depth_test        = 0,
+		.depth_write       = 0,
+		.blend_mode        = VKK_BLEND_MODE_TRANSPARENCY
+	};
+
+	popcorn_startup_mark(startup, "graph.pl");
+
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
+	self->gp = vkk_graphicsPipeline_new(engine, &gpi);
+	if(self->gp == NULL)
+	{
+		goto fail_gp;
+	}
+	popcorn_startup_mark(startup, "graph.gp");
+
+	self->ub00_mvp = vkk_buffer_new(engine,
+	                                VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                VKK_BUFFER_USAGE_UNIFORM,
+	                                sizeof(cc_mat4f_t), NULL);
+	if(self->ub00_mvp == NULL)
+	{
+		goto fail_ub00;
+	}
+
+	self->vb_xy = vkk_buffer_new(engine,
+	                             VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                             VKK_BUFFER_USAGE_VERTEX,
+	                             sizeof(self->xy), NULL);
+	if(self->vb_xy == NULL)
+	{
+		goto fail_vb_xy;
+	}
+
+	self->vb_rgba = vkk_buffer_new(engine,
+	                               VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                               VKK_BUFFER_USAGE_VERTEX,
+	                               sizeof(self->rgba), NULL);
+	if(self->vb_rgba == NULL)
+	{
+		goto fail_vb_rgba;
+	}
+
+	vkk_uniformAttachment_t ua_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformMvp
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.buffer  = self->ub00_mvp
+		},
+	};
+
+	self->us0 = vkk_uniformSet_new(engine, 0, 1,
+	                               ua_array0,
+	                               self->usf0);
+	if(self->us0 == NULL)
+	{
+		goto fail_us0;
+	}
+
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_RENDERER,
+	                        sizeof(cc_mat4f_t));
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_RENDERER,
+	                        sizeof(self->xy));
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_RENDERER,
+	                        sizeof(self->rgba));
+
+	// success
+	return self;
+
+	// failure
+	fail_us0:
+		vkk_buffer_delete(&self->vb_rgba);
+	fail_vb_rgba:
+		vkk_buffer_delete(&self->vb_xy);
+	fail_vb_xy:
+		vkk_buffer_delete(&self->ub00_mvp);
+	fail_ub00:
+		vkk_graphicsPipeline_delete(&self->gp);
+	fail_gp:
+		vkk_pipelineLayout_delete(&self->pl);
+	fail_pl:
+		vkk_uniformSetFactory_delete(&self->usf0);
+	fail_usf0:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_graph_delete(popcorn_graph_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_graph_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_RENDERER,
+		                       sizeof(self->rgba));
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_RENDERER,
+		                       sizeof(self->xy));
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_RENDERER,
+		                       sizeof(cc_mat4f_t));
+		vkk_uniformSet_delete(&self->us0);
+		vkk_buffer_delete(&self->vb_rgba);
+		vkk_buffer_delete(&self->vb_xy);
+		vkk_buffer_delete(&self->ub00_mvp);
+		vkk_graphicsPipeline_delete(&self->gp);
+		vkk_pipelineLayout_delete(&self->pl);
+		vkk_uniformSetFactory_delete(&self->usf0);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_graph_draw(popcorn_graph_t* self,
+                        popcorn_frametime_t* frametime,
+                        float width, float height)
+{
+	ASSERT(self);
+	ASSERT(frametime);
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(self->engine);
+
+	// the graph covers the bottom quarter of the screen
+	// in pixel coordinates with the origin at the top left
+	cc_mat4f_t mvp;
+	cc_mat4f_orthographic(&mvp, 1, 0.0f, width, height, 0.0f,
+	                      -1.0f, 1.0f);
+
+	const float GREEN[] = { 0.0f, 1.0f, 0.0f, 0.6f };
+	const float RED[]   = { 1.0f, 0.0f, 0.0f, 0.8f };
+	const float WHITE[] = { 1.0f, 1.0f, 1.0f, 0.8f };
+
+	float    w  = width/((float) POPCORN_FRAMETIME_WINDOW);
+	float    gh = 0.25f*height;
+	float    s  = gh/POPCORN_GRAPH_MS;
+	uint32_t i;
+	for(i = 0; i < POPCORN_FRAMETIME_WINDOW; ++i)
+	{
+		// the most recent frame is on the right
+		int   hitch;
+		float ms = popcorn_frametime_recent(frametime, i, &hitch);
+		if(ms > POPCORN_GRAPH_MS)
+		{
+			ms = POPCORN_GRAPH_MS;
+		}
+
+		float r = width - w*((float) i);
+		popcorn_graph_quad(self, i, r - w, height - s*ms,
+		                   r, height, hitch ? RED : GREEN);
+	}
+
+	// hitch threshold
+	float threshold = POPCORN_FRAMETIME_HITCH*frametime->median;
+	if(threshold > POPCORN_GRAPH_MS)
+	{
+		threshold = POPCORN_GRAPH_MS;
+	}
+	float y = height - s*threshold;
+	popcorn_graph_quad(self, POPCORN_FRAMETIME_WINDOW,
+	                   0.0f, y - 1.0f, width, y + 1.0f, WHITE);
+
+	vkk_uniformSet_t* us_array[] =
+	{
+		self->us0,
+	};
+
+	vkk_buffer_t* vb_array[] =
+	{
+		self->vb_xy,
+		self->vb_rgba,
+	};
+
+	vkk_renderer_bindGraphicsPipeline(rend, self->gp);
+	vkk_renderer_updateBuffer(rend, self->ub00_mvp,
+	                          sizeof(cc_mat4f_t),
+	                          (const void*) &mvp);
+	vkk_renderer_updateBuffer(rend, self->vb_xy,
+	                          sizeof(self->xy),
+	                          (const void*) self->xy);
+	vkk_renderer_updateBuffer(rend, self->vb_rgba,
+	                          sizeof(self->rgba),
+	                          (const void*) self->rgba);
+	vkk_renderer_bindUniformSets(rend, 1, us_array);
+	vkk_renderer_draw(rend, POPCORN_GRAPH_VERTICES, 2, vb_array);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_graph_H
+#define popcorn_graph_H
+
+#include "libcc/math/cc_mat4f.h"
+#include "libvkk/vkk.h"
+#include "popcorn_frametime.h"
+#include "popcorn_shader.h"
+#include "popcorn_startup.h"
+
+// frame time graph overlay
+// one bar per frame of the frame time window plus the
+// hitch threshold line
+#define POPCORN_GRAPH_QUADS    (POPCORN_FRAMETIME_WINDOW + 1)
+#define POPCORN_GRAPH_VERTICES (6*POPCORN_GRAPH_QUADS)
+
+// frame time at the top of the graph
+#define POPCORN_GRAPH_MS 50.0f
+
+typedef struct
+{
+	vkk_engine_t*            engine;
+	vkk_uniformSetFactory_t* usf0;
+	vkk_pipelineLayout_t*    pl;
+	vkk_graphicsPipeline_t*  gp;
+	vkk_buffer_t*            ub00_mvp;
+	vkk_buffer_t*            vb_xy;
+	vkk_buffer_t*            vb_rgba;
+	vkk_uniformSet_t*        us0;
+
+	// updated once per frame while visible
+	float xy[2*POPCORN_GRAPH_VERTICES];
+	float rgba[4*POPCORN_GRAPH_VERTICES];
+} popcorn_graph_t;
+
+popcorn_graph_t* popcorn_graph_new(vkk_engine_t* engine,
+                                   popcorn_shader_t* shader,
+                                   popcorn_startup_t* startup);
+void             popcorn_graph_delete(popcorn_graph_t** _self);
+void             popcorn_graph_draw(popcorn_graph_t* self,
+                                    popcorn_frametime_t* frametime,
+                                    float width, float height);
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_input.h"
+#include "popcorn_memory.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+typedef union
+{
+	float    f;
+	uint32_t u;
+} popcorn_inputBits_t;
+
+static void
+popcorn_input_apply(popcorn_inputEdge_t* edge,
+                    popcorn_inputState_t* state)
+{
+	ASSERT(edge);
+	ASSERT(state);
+
+	if(edge->button == POPCORN_INPUT_BUTTON_BRAKE)
+	{
+		state->acceleration += edge->down ? -1.0f : 1.0f;
+	}
+	else if(edge->button == POPCORN_INPUT_BUTTON_THRUST)
+	{
+		state->acceleration += edge->down ? 1.0f : -1.0f;
+	}
+	else if((edge->button == POPCORN_INPUT_BUTTON_RESET) &&
+	        (edge->down == 0))
+	{
+		// edges before the reset are discarded
+		state->acceleration = 0.0f;
+		state->reset        = 1;
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_input_t* popcorn_input_new(void)
+{
+	popcorn_input_t* self;
+	self = (popcorn_input_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_INPUT,
+	                             1, sizeof(popcorn_input_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	popcorn_inputBits_t zero = { .f=0.0f };
+
+	int i;
+	for(i = 0; i < POPCORN_INPUT_AXIS_COUNT; ++i)
+	{
+		atomic_init(&self->axis[i], zero.u);
+	}
+	atomic_init(&self->axis_events, 0);
+	atomic_init(&self->head, 0);
+	atomic_init(&self->tail, 0);
+	atomic_init(&self->dropped, 0);
+
+	return self;
+}
+
+void popcorn_input_delete(popcorn_input_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_input_t* self = *_self;
+	if(self)
+	{
+		uint32_t dropped = atomic_load(&self->dropped);
+		if(dropped)
+		{
+			LOGW("dropped=%u", dropped);
+		}
+
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_input_axis(popcorn_input_t* self,
+                        popcorn_inputAxis_e axis,
+                        float value)
+{
+	ASSERT(self);
+	ASSERT(axis < POPCORN_INPUT_AXIS_COUNT);
+
+	popcorn_inputBits_t bits = { .f=value };
+	atomic_store_explicit(&self->axis[axis], bits.u,
+	                      memory_order_relaxed);
+	atomic_fetch_add_explicit(&self->axis_events, 1,
+	                          memory_order_relaxed);
+}
+
+int popcorn_input_button(popcorn_input_t* self,
+                         popcorn_inputButton_e button,
+                         int down, double ts)
+{
+	ASSERT(self);
+
+	// only the producer writes the head
+	uint32_t head;
+	uint32_t tail;
+	head = atomic_load_explicit(&self->head,
+	                            memory_order_relaxed);
+	tail = atomic_load_explicit(&self->tail,
+	                            memory_order_acquire);
+	if((head - tail) >= POPCORN_INPUT_RING)
+	{
+		atomic_fetch_add_explicit(&self->dropped, 1,
+		                          memory_order_relaxed);
+		return 0;
+	}
+
+	popcorn_inputEdge_t* edge;
+	edge = &self->ring[head & (POPCORN_INPUT_RING - 1)];
+	edge->ts     = ts;
+	edge->button = (uint32_t) button;
+	edge->down   = down ? 1 : 0;
+
+	// publish the edge
+	atomic_store_explicit(&self->head, head + 1,
+	                      memory_order_release);
+
+	return 1;
+}
+
+void popcorn_input_poll(popcorn_input_t* self,
+                        double t,
+                        popcorn_inputState_t* state)
+{
+	ASSERT(self);
+	ASSERT(state);
+
+	memset(state, 0, sizeof(popcorn_inputState_t));
+
+	// only the consumer writes the tail
+	uint32_t head;
+	uint32_t tail;
+	tail = atomic_load_explicit(&self->tail,
+	                            memory_order_relaxed);
+	head = atomic_load_explicit(&self->head,
+	                            memory_order_acquire);
+
+	// consume the edges which occurred before the tick
+	// the remaining edges are applied by a later tick
+	while(tail != head)
+	{
+		popcorn_inputEdge_t* edge;
+		edge = &self->ring[tail & (POPCORN_INPUT_RING - 1)];
+		if(edge->ts > t)
+		{
+			break;
+		}
+
+		popcorn_input_apply(edge, state);
+		++state->edges;
+		++tail;
+	}
+
+	atomic_store_explicit(&self->tail, tail,
+	                      memory_order_release);
+
+	int i;
+	for(i = 0; i < POPCORN_INPUT_AXIS_COUNT; ++i)
+	{
+		popcorn_inputBits_t bits;
+		bits.u = atomic_load_explicit(&self->axis[i],
+		                              memory_order_relaxed);
+		state->axis[i] = bits.f;
+	}
+
+	state->axis_events = atomic_exchange_explicit(&self->axis_events,
+	                                              0,
+	                                              memory_order_relaxed);
+}
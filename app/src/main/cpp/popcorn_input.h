@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_input_H
+#define popcorn_input_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// single-producer/single-consumer input queue
+// the platform event thread is the producer and the
+// simulation is the consumer
+
+// size of the button ring
+// must be a power of two
+#define POPCORN_INPUT_RING 256
+
+typedef enum
+{
+	POPCORN_INPUT_AXIS_ROLL   = 0,
+	POPCORN_INPUT_AXIS_PITCH  = 1,
+	POPCORN_INPUT_AXIS_HEAD_X = 2,
+	POPCORN_INPUT_AXIS_HEAD_Y = 3,
+	POPCORN_INPUT_AXIS_YAW1   = 4,
+	POPCORN_INPUT_AXIS_YAW2   = 5,
+} popcorn_inputAxis_e;
+
+#define POPCORN_INPUT_AXIS_COUNT 6
+
+typedef enum
+{
+	POPCORN_INPUT_BUTTON_BRAKE  = 0,
+	POPCORN_INPUT_BUTTON_THRUST = 1,
+	POPCORN_INPUT_BUTTON_RESET  = 2,
+} popcorn_inputButton_e;
+
+typedef struct
+{
+	double   ts;
+	uint32_t button;
+	uint32_t down;
+} popcorn_inputEdge_t;
+
+typedef struct
+{
+	// latest axis values at the poll time
+	float axis[POPCORN_INPUT_AXIS_COUNT];
+
+	// change in the acceleration counter
+	// since the reset (if any)
+	float acceleration;
+
+	// reset was pressed during the tick
+	int reset;
+
+	// number of events consumed by the poll
+	uint32_t edges;
+	uint32_t axis_events;
+} popcorn_inputState_t;
+
+typedef struct popcorn_input_s
+{
+	// axis events are coalesced by storing the latest
+	// value of each axis (float bits) so a high rate
+	// controller cannot overflow the ring
+	atomic_uint axis[POPCORN_INPUT_AXIS_COUNT];
+	atomic_uint axis_events;
+
+	// button edges are never coalesced
+	atomic_uint         head;
+	atomic_uint         tail;
+	atomic_uint         dropped;
+	popcorn_inputEdge_t ring[POPCORN_INPUT_RING];
+} popcorn_input_t;
+
+popcorn_input_t* popcorn_input_new(void);
+void             popcorn_input_delete(popcorn_input_t** _self);
+void             popcorn_input_axis(popcorn_input_t* self,
+                                    popcorn_inputAxis_e axis,
+                                    float value);
+int              popcorn_input_button(popcorn_input_t* self,
+                                      popcorn_inputButton_e button,
+                                      int down, double ts);
+void             popcorn_input_poll(popcorn_input_t* self,
+                                    double t,
+                                    popcorn_inputState_t* state);
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_instrument.h"
+
+// cockpit coordinates are x right, y forward and z up
+// with the pilot eye at the origin
+typedef struct
+{
+	float pivot[3];
+	float min[3];
+	float max[3];
+} popcorn_instrumentInfo_t;
+
+static const popcorn_instrumentInfo_t POPCORN_INSTRUMENT_INFO[] =
+{
+	// stick
+	{
+		.pivot = {  0.0f,  0.30f, -0.45f },
+		.min   = { -0.01f, -0.01f, 0.0f  },
+		.max   = {  0.01f,  0.01f, 0.20f },
+	},
+	// throttle
+	{
+		.pivot = { -0.20f,  0.30f,  -0.35f },
+		.min   = { -0.01f, -0.01f,  0.0f   },
+		.max   = {  0.01f,  0.01f,  0.12f  },
+	},
+	// speed needle
+	{
+		.pivot = {  0.15f,   0.45f,  -0.15f },
+		.min   = { -0.003f, -0.002f,  0.0f  },
+		.max   = {  0.003f,  0.0f,    0.04f },
+	},
+	// horizon bar
+	{
+		.pivot = { -0.15f,  0.45f,   -0.15f  },
+		.min   = { -0.04f, -0.002f,  -0.002f },
+		.max   = {  0.04f,  0.0f,     0.002f },
+	},
+};
+
+// driver gains
+#define POPCORN_INSTRUMENT_STICK_DEG    20.0f
+#define POPCORN_INSTRUMENT_THROTTLE_DEG 6.0f
+#define POPCORN_INSTRUMENT_THROTTLE_MAX 5.0f
+#define POPCORN_INSTRUMENT_SPEED_DEG    270.0f
+#define POPCORN_INSTRUMENT_HORIZON_Z    0.03f
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+void popcorn_instrument_init(popcorn_instrument_t* self,
+                             popcorn_instrumentType_e type,
+                             uint32_t node)
+{
+	ASSERT(self);
+
+	self->type     = type;
+	self->node     = node;
+	self->value[0] = 0.0f;
+	self->value[1] = 0.0f;
+}
+
+void popcorn_instrument_box(popcorn_instrumentType_e type,
+                            uint16_t* ib, float* vb,
+                            float* nb)
+{
+	ASSERT(ib);
+	ASSERT(vb);
+	ASSERT(nb);
+
+	const popcorn_instrumentInfo_t* info;
+	info = &POPCORN_INSTRUMENT_INFO[type];
+
+	// each face has its own vertices for flat normals
+	uint32_t f;
+	uint32_t v;
+	for(f = 0; f < 6; ++f)
+	{
+		uint32_t axis = f/2;
+		uint32_t u    = (axis + 1) % 3;
+		uint32_t w    = (axis + 2) % 3;
+		float    sign = (f & 1) ? 1.0f : -1.0f;
+
+		for(v = 0; v < 4; ++v)
+		{
+			// counter-clockwise when viewed from outside
+			uint32_t su = ((v == 1) || (v == 2));
+			uint32_t sw = (v >= 2);
+			if(sign < 0.0f)
+			{
+				su = 1 - su;
+			}
+
+			float* p = &vb[3*(4*f + v)];
+			float* n = &nb[3*(4*f + v)];
+			p[axis] = (sign > 0.0f) ? info->max[axis] : info->min[axis];
+			p[u]    = su ? info->max[u] : info->min[u];
+			p[w]    = sw ? info->max[w] : info->min[w];
+			n[axis] = sign;
+			n[u]    = 0.0f;
+			n[w]    = 0.0f;
+		}
+
+		ib[6*f]     = 4*f;
+		ib[6*f + 1] = 4*f + 1;
+		ib[6*f + 2] = 4*f + 2;
+		ib[6*f + 3] = 4*f;
+		ib[6*f + 4] = 4*f + 2;
+		ib[6*f + 5] = 4*f + 3;
+	}
+}
+
+void popcorn_instrument_local(popcorn_instrumentType_e type,
+                              const float* value,
+                              cc_mat4f_t* local)
+{
+	ASSERT(value);
+	ASSERT(local);
+
+	const popcorn_instrumentInfo_t* info;
+	info = &POPCORN_INSTRUMENT_INFO[type];
+
+	cc_mat4f_translate(local, 1, info->pivot[0],
+	                   info->pivot[1], info->pivot[2]);
+	if(type == POPCORN_INSTRUMENT_STICK)
+	{
+		// pitch tilts fore/aft and roll tilts left/right
+		cc_mat4f_rotate(local, 0,
+		                -POPCORN_INSTRUMENT_STICK_DEG*value[0],
+		                1.0f, 0.0f, 0.0f);
+		cc_mat4f_rotate(local, 0,
+		                POPCORN_INSTRUMENT_STICK_DEG*value[1],
+		                0.0f, 1.0f, 0.0f);
+	}
+	else if(type == POPCORN_INSTRUMENT_THROTTLE)
+	{
+		cc_mat4f_rotate(local, 0,
+		                -POPCORN_INSTRUMENT_THROTTLE_DEG*value[0],
+		                1.0f, 0.0f, 0.0f);
+	}
+	else if(type == POPCORN_INSTRUMENT_SPEED)
+	{
+		// the dial faces the pilot and sweeps clockwise
+		float s = value[0]/POPCORN_FLIGHT_SPEED_MAX;
+		cc_mat4f_rotate(local, 0,
+		                0.5f*POPCORN_INSTRUMENT_SPEED_DEG -
+		                POPCORN_INSTRUMENT_SPEED_DEG*s,
+		                0.0f, 1.0f, 0.0f);
+	}
+	else if(type == POPCORN_INSTRUMENT_HORIZON)
+	{
+		cc_mat4f_rotate(local, 0, value[0],
+		                0.0f, 1.0f, 0.0f);
+		cc_mat4f_translate(local, 0, 0.0f, 0.0f,
+		                   POPCORN_INSTRUMENT_HORIZON_Z*value[1]);
+	}
+}
+
+void popcorn_instrument_horizon(const cc_quaternion_t* attitude,
+                                float* value)
+{
+	ASSERT(attitude);
+	ASSERT(value);
+
+	// world up in aircraft coordinates (x forward,
+	// y right, z down) remapped to cockpit coordinates
+	cc_mat4f_t m;
+	cc_mat4f_rotateq(&m, 1, attitude);
+
+	float ux = -m.m12;
+	float uy = -m.m02;
+	float uz = m.m22;
+
+	// bank angle and pitch offset of the horizon
+	value[0] = atan2f(ux, uz)*(180.0f/M_PI);
+	value[1] = uy;
+}
+
+int popcorn_instrument_update(popcorn_instrument_t* self,
+                              const popcorn_flightState_t* state,
+                              cc_mat4f_t* local)
+{
+	ASSERT(self);
+	ASSERT(state);
+	ASSERT(local);
+
+	float value[2] = { 0.0f, 0.0f };
+	if(self->type == POPCORN_INSTRUMENT_STICK)
+	{
+		value[0] = state->pitch;
+		value[1] = state->roll;
+	}
+	else if(self->type == POPCORN_INSTRUMENT_THROTTLE)
+	{
+		value[0] = state->acceleration;
+		if(value[0] > POPCORN_INSTRUMENT_THROTTLE_MAX)
+		{
+			value[0] = POPCORN_INSTRUMENT_THROTTLE_MAX;
+		}
+		else if(value[0] < -POPCORN_INSTRUMENT_THROTTLE_MAX)
+		{
+			value[0] = -POPCORN_INSTRUMENT_THROTTLE_MAX;
+		}
+	}
+	else if(self->type == POPCORN_INSTRUMENT_SPEED)
+	{
+		value[0] = state->speed;
+	}
+	else if(self->type == POPCORN_INSTRUMENT_HORIZON)
+	{
+		popcorn_instrument_horizon(&state->attitude, value);
+	}
+
+	// only changed instruments dirty the scene
+	if((value[0] == self->value[0]) &&
+	   (value[1] == self->value[1]))
+	{
+		return 0;
+	}
+
+	self->value[0] = value[0];
+	self->value[1] = value[1];
+	popcorn_instrument_local(self->type, self->value, local);
+
+	return 1;
+}
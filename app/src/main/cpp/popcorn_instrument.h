@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_instrument_H
+#define popcorn_instrument_H
+
+#include <stdint.h>
+
+#include "libcc/math/cc_mat4f.h"
+#include "popcorn_flight.h"
+
+// animated cockpit instruments
+// each instrument is a procedural box part attached to
+// its own scene node whose local transform is driven by
+// the sim state
+typedef enum
+{
+	POPCORN_INSTRUMENT_STICK    = 0,
+	POPCORN_INSTRUMENT_THROTTLE = 1,
+	POPCORN_INSTRUMENT_SPEED    = 2,
+	POPCORN_INSTRUMENT_HORIZON  = 3,
+} popcorn_instrumentType_e;
+
+#define POPCORN_INSTRUMENT_COUNT 4
+
+// box geometry
+#define POPCORN_INSTRUMENT_IC 36
+#define POPCORN_INSTRUMENT_VC 24
+
+typedef struct
+{
+	popcorn_instrumentType_e type;
+	uint32_t                 node;
+
+	// driver inputs of the last update
+	float value[2];
+} popcorn_instrument_t;
+
+void popcorn_instrument_init(popcorn_instrument_t* self,
+                             popcorn_instrumentType_e type,
+                             uint32_t node);
+void popcorn_instrument_box(popcorn_instrumentType_e type,
+                            uint16_t* ib, float* vb,
+                            float* nb);
+void popcorn_instrument_local(popcorn_instrumentType_e type,
+                              const float* value,
+                              cc_mat4f_t* local);
+int  popcorn_instrument_update(popcorn_instrument_t* self,
+                               const popcorn_flightState_t* state,
+                               cc_mat4f_t* local);
+void popcorn_instrument_horizon(const cc_quaternion_t* attitude,
+                                float* value);
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/math/cc_vec4f.h"
+#include "libcc/cc_log.h"
+#include "popcorn_lod.h"
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+void popcorn_lod_init(popcorn_lod_t* self)
+{
+	ASSERT(self);
+
+	memset(self, 0, sizeof(popcorn_lod_t));
+	self->count = 1;
+
+	int c;
+	for(c = 0; c < 3; ++c)
+	{
+		self->min[c] = INFINITY;
+		self->max[c] = -INFINITY;
+	}
+}
+
+uint32_t popcorn_lod_mask(uint32_t lod, uint32_t lods)
+{
+	ASSERT(lod < lods);
+	ASSERT(lods <= POPCORN_LOD_MAX);
+
+	// the last level of a chain is also drawn by the
+	// coarser levels of the object
+	uint32_t all = (1 << POPCORN_LOD_MAX) - 1;
+	if(lod + 1 == lods)
+	{
+		return (all << lod) & all;
+	}
+	return 1 << lod;
+}
+
+void popcorn_lod_add(popcorn_lod_t* self,
+                     uint32_t lod, uint32_t lods,
+                     float error,
+                     const cc_mat4f_t* world,
+                     const float* min,
+                     const float* max)
+{
+	ASSERT(self);
+	ASSERT(world);
+	ASSERT(min);
+	ASSERT(max);
+
+	if(lods > self->count)
+	{
+		self->count = lods;
+	}
+
+	// the error of a level is the error of the coarsest
+	// part drawn by the level
+	uint32_t mask = popcorn_lod_mask(lod, lods);
+	uint32_t i;
+	for(i = 0; i < POPCORN_LOD_MAX; ++i)
+	{
+		if((mask & (1 << i)) && (error > self->error[i]))
+		{
+			self->error[i] = error;
+		}
+	}
+
+	// only the source level extends the bounds
+	if(lod)
+	{
+		return;
+	}
+
+	for(i = 0; i < 8; ++i)
+	{
+		cc_vec4f_t p =
+		{
+			.x = (i & 1) ? max[0] : min[0],
+			.y = (i & 2) ? max[1] : min[1],
+			.z = (i & 4) ? max[2] : min[2],
+			.w = 1.0f,
+		};
+		cc_mat4f_mulv(world, &p);
+
+		float q[3] = { p.x, p.y, p.z };
+		int   c;
+		for(c = 0; c < 3; ++c)
+		{
+			if(q[c] < self->min[c])
+			{
+				self->min[c] = q[c];
+			}
+			if(q[c] > self->max[c])
+			{
+				self->max[c] = q[c];
+			}
+		}
+	}
+}
+
+uint32_t popcorn_lod_select(popcorn_lod_t* self,
+                            const cc_mat4f_t* mvm,
+                            float fovy, float height)
+{
+	ASSERT(self);
+	ASSERT(mvm);
+
+	if((self->count <= 1) || (self->min[0] > self->max[0]))
+	{
+		return 0;
+	}
+
+	// bounding sphere in view space
+	float dx = self->max[0] - self->min[0];
+	float dy = self->max[1] - self->min[1];
+	float dz = self->max[2] - self->min[2];
+	float radius = 0.5f*sqrtf(dx*dx + dy*dy + dz*dz);
+	cc_vec4f_t center =
+	{
+		.x = 0.5f*(self->min[0] + self->max[0]),
+		.y = 0.5f*(self->min[1] + self->max[1]),
+		.z = 0.5f*(self->min[2] + self->max[2]),
+		.w = 1.0f,
+	};
+	cc_mat4f_mulv(mvm, &center);
+
+	// the viewer is inside the bounds
+	float distance = sqrtf(center.x*center.x +
+	                       center.y*center.y +
+	                       center.z*center.z);
+	if(distance <= radius)
+	{
+		self->pixels = height;
+		if(self->level)
+		{
+			++self->switches;
+		}
+		self->level = 0;
+		return 0;
+	}
+
+	// pixels per object unit at the nearest point
+	float t = tanf(0.5f*fovy*((float) M_PI)/180.0f);
+	float k = height/(2.0f*(distance - radius)*t);
+	self->pixels = k*radius;
+
+	float    lo    = (1.0f - POPCORN_LOD_HYSTERESIS)*POPCORN_LOD_PIXELS;
+	float    hi    = (1.0f + POPCORN_LOD_HYSTERESIS)*POPCORN_LOD_PIXELS;
+	uint32_t level = self->level;
+	if(level >= self->count)
+	{
+		level = self->count - 1;
+	}
+
+	// refine while the current level is too coarse and
+	// coarsen while the next level is well below a pixel
+	while((level > 0) && (k*self->error[level] > hi))
+	{
+		--level;
+	}
+
+	while((level + 1 < self->count) &&
+	      (k*self->error[level + 1] < lo))
+	{
+		++level;
+	}
+
+	if(level != self->level)
+	{
+		++self->switches;
+		self->level = level;
+	}
+
+	return level;
+}
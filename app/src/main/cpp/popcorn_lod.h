@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_lod_H
+#define popcorn_lod_H
+
+#include <stdint.h>
+
+#include "libcc/math/cc_mat4f.h"
+#include "popcorn_mesh.h"
+
+// LOD selection
+// the level of an object is the coarsest level whose
+// simplification error projects to less than a pixel at
+// the distance of the object bounds
+#define POPCORN_LOD_MAX    POPCORN_MESH_LODS
+#define POPCORN_LOD_PIXELS 1.0f
+
+// the level only changes once the projected error leaves
+// a band around the threshold so it does not flicker when
+// the distance is near a switch
+#define POPCORN_LOD_HYSTERESIS 0.25f
+
+typedef struct
+{
+	// levels and the maximum error of each level in
+	// object units
+	uint32_t count;
+	float    error[POPCORN_LOD_MAX];
+
+	// object bounds
+	float min[3];
+	float max[3];
+
+	// current level
+	uint32_t level;
+	uint32_t switches;
+
+	// projected radius at the last selection
+	float pixels;
+} popcorn_lod_t;
+
+void     popcorn_lod_init(popcorn_lod_t* self);
+uint32_t popcorn_lod_mask(uint32_t lod, uint32_t lods);
+void     popcorn_lod_add(popcorn_lod_t* self,
+                         uint32_t lod, uint32_t lods,
+                         float error,
+                         const cc_mat4f_t* world,
+                         const float* min,
+                         const float* max);
+uint32_t popcorn_lod_select(popcorn_lod_t* self,
+                            const cc_mat4f_t* mvm,
+                            float fovy, float height);
+
+#endif
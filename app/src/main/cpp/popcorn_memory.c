@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libcc/cc_memory.h"
+#include "popcorn_memory.h"
+
+// allocation header which preserves 16 byte alignment
+#define POPCORN_MEMORY_HEADER 16
+#define POPCORN_MEMORY_MAGIC  0x4D454D50 // "PMEM"
+
+typedef struct
+{
+	size_t   size;
+	uint32_t tag;
+	uint32_t magic;
+} popcorn_memoryHeader_t;
+
+typedef struct
+{
+	atomic_size_t host_count;
+	atomic_size_t host_live;
+	atomic_size_t host_peak;
+	atomic_size_t gpu_count;
+	atomic_size_t gpu_live;
+	atomic_size_t gpu_peak;
+} popcorn_memoryCounter_t;
+
+static const char* POPCORN_MEMORY_TAG_NAME[] =
+{
+	"renderer",
+	"cockpit",
+	"part",
+	"collision",
+	"input",
+	"sim",
+	"recorder",
+	"mesh",
+	"scene",
+	"arena",
+	"queue",
+	"particle",
+};
+
+static popcorn_memoryCounter_t
+popcorn_memory_counter[POPCORN_MEMORY_TAG_COUNT];
+static popcorn_memoryCounter_t popcorn_memory_total;
+
+// frame state
+static atomic_uint popcorn_memory_frameAllocs;
+static atomic_int  popcorn_memory_isSteady;
+static uint32_t    popcorn_memory_frames;
+static uint32_t    popcorn_memory_frameMax;
+static uint32_t    popcorn_memory_violations;
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static void
+popcorn_memory_peak(atomic_size_t* peak, size_t live)
+{
+	ASSERT(peak);
+
+	size_t old = atomic_load_explicit(peak, memory_order_relaxed);
+	while(live > old)
+	{
+		if(atomic_compare_exchange_weak_explicit(peak, &old, live,
+		                                         memory_order_relaxed,
+		                                         memory_order_relaxed))
+		{
+			break;
+		}
+	}
+}
+
+static void
+popcorn_memory_update(popcorn_memoryCounter_t* c,
+                      int gpu, size_t size, int alloc)
+{
+	ASSERT(c);
+
+	atomic_size_t* count = gpu ? &c->gpu_count : &c->host_count;
+	atomic_size_t* live  = gpu ? &c->gpu_live  : &c->host_live;
+	atomic_size_t* peak  = gpu ? &c->gpu_peak  : &c->host_peak;
+	if(alloc)
+	{
+		atomic_fetch_add_explicit(count, 1, memory_order_relaxed);
+		popcorn_memory_peak(peak,
+		                    atomic_fetch_add_explicit(live, size,
+		                                              memory_order_relaxed) +
+		                    size);
+	}
+	else
+	{
+		atomic_fetch_sub_explicit(count, 1, memory_order_relaxed);
+		atomic_fetch_sub_explicit(live, size, memory_order_relaxed);
+	}
+}
+
+static void
+popcorn_memory_add(popcorn_memoryTag_e tag, int gpu,
+                   size_t size)
+{
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+
+	popcorn_memory_update(&popcorn_memory_counter[tag],
+	                      gpu, size, 1);
+	popcorn_memory_update(&popcorn_memory_total,
+	                      gpu, size, 1);
+
+	atomic_fetch_add_explicit(&popcorn_memory_frameAllocs, 1,
+	                          memory_order_relaxed);
+	if(atomic_load_explicit(&popcorn_memory_isSteady,
+	                        memory_order_relaxed))
+	{
+		LOGE("steady-state allocation: tag=%s, gpu=%i, size=%u",
+		     POPCORN_MEMORY_TAG_NAME[tag], gpu, (uint32_t) size);
+		#ifdef POPCORN_MEMORY_ASSERT
+		abort();
+		#endif
+	}
+}
+
+static void
+popcorn_memory_sub(popcorn_memoryTag_e tag, int gpu,
+                   size_t size)
+{
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+
+	popcorn_memory_update(&popcorn_memory_counter[tag],
+	                      gpu, size, 0);
+	popcorn_memory_update(&popcorn_memory_total,
+	                      gpu, size, 0);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+void* popcorn_memory_calloc(popcorn_memoryTag_e tag,
+                            size_t count, size_t size)
+{
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+
+	size_t bytes = count*size;
+
+	char* buf = (char*) CALLOC(1, POPCORN_MEMORY_HEADER + bytes);
+	if(buf == NULL)
+	{
+		return NULL;
+	}
+
+	popcorn_memoryHeader_t* header = (popcorn_memoryHeader_t*) buf;
+	header->size  = bytes;
+	header->tag   = (uint32_t) tag;
+	header->magic = POPCORN_MEMORY_MAGIC;
+
+	popcorn_memory_add(tag, 0, bytes);
+
+	return (void*) (buf + POPCORN_MEMORY_HEADER);
+}
+
+void* popcorn_memory_realloc(popcorn_memoryTag_e tag,
+                             void* ptr, size_t size)
+{
+	// ptr may be NULL
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+
+	if(ptr == NULL)
+	{
+		return popcorn_memory_calloc(tag, 1, size);
+	}
+
+	char* buf = ((char*) ptr) - POPCORN_MEMORY_HEADER;
+
+	popcorn_memoryHeader_t* header = (popcorn_memoryHeader_t*) buf;
+	ASSERT(header->magic == POPCORN_MEMORY_MAGIC);
+	ASSERT(header->tag   == (uint32_t) tag);
+
+	size_t old = header->size;
+
+	buf = (char*) REALLOC(buf, POPCORN_MEMORY_HEADER + size);
+	if(buf == NULL)
+	{
+		return NULL;
+	}
+
+	header       = (popcorn_memoryHeader_t*) buf;
+	header->size = size;
+
+	popcorn_memory_sub(tag, 0, old);
+	popcorn_memory_add(tag, 0, size);
+
+	return (void*) (buf + POPCORN_MEMORY_HEADER);
+}
+
+void popcorn_memory_free(void* ptr)
+{
+	// ptr may be NULL
+	if(ptr == NULL)
+	{
+		return;
+	}
+
+	char* buf = ((char*) ptr) - POPCORN_MEMORY_HEADER;
+
+	popcorn_memoryHeader_t* header = (popcorn_memoryHeader_t*) buf;
+	ASSERT(header->magic == POPCORN_MEMORY_MAGIC);
+
+	popcorn_memory_sub((popcorn_memoryTag_e) header->tag,
+	                   0, header->size);
+	header->magic = 0;
+
+	FREE(buf);
+}
+
+void popcorn_memory_gpuAlloc(popcorn_memoryTag_e tag,
+                             size_t size)
+{
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+
+	popcorn_memory_add(tag, 1, size);
+}
+
+void popcorn_memory_gpuFree(popcorn_memoryTag_e tag,
+                            size_t size)
+{
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+
+	popcorn_memory_sub(tag, 1, size);
+}
+
+void popcorn_memory_steady(int steady)
+{
+	atomic_store(&popcorn_memory_isSteady, steady);
+}
+
+uint32_t popcorn_memory_frame(void)
+{
+	// called by the render thread at the end of each frame
+	uint32_t allocs;
+	allocs = atomic_exchange_explicit(&popcorn_memory_frameAllocs,
+	                                  0, memory_order_relaxed);
+
+	++popcorn_memory_frames;
+	if(allocs > popcorn_memory_frameMax)
+	{
+		popcorn_memory_frameMax = allocs;
+	}
+
+	if(allocs &&
+	   atomic_load_explicit(&popcorn_memory_isSteady,
+	                        memory_order_relaxed))
+	{
+		++popcorn_memory_violations;
+	}
+
+	return allocs;
+}
+
+void popcorn_memory_stats(popcorn_memoryTag_e tag,
+                          popcorn_memoryStats_t* stats)
+{
+	ASSERT(tag < POPCORN_MEMORY_TAG_COUNT);
+	ASSERT(stats);
+
+	popcorn_memoryCounter_t* c = &popcorn_memory_counter[tag];
+	stats->host_count = atomic_load(&c->host_count);
+	stats->host_live  = atomic_load(&c->host_live);
+	stats->host_peak  = atomic_load(&c->host_peak);
+	stats->gpu_count  = atomic_load(&c->gpu_count);
+	stats->gpu_live   = atomic_load(&c->gpu_live);
+	stats->gpu_peak   = atomic_load(&c->gpu_peak);
+}
+
+void popcorn_memory_report(void)
+{
+	LOGI("%-10s %8s %10s %10s %8s %10s %10s",
+	     "tag", "count", "live", "peak",
+	     "buffers", "gpu_live", "gpu_peak");
+
+	int i;
+	for(i = 0; i < POPCORN_MEMORY_TAG_COUNT; ++i)
+	{
+		popcorn_memoryStats_t s;
+		popcorn_memory_stats((popcorn_memoryTag_e) i, &s);
+		LOGI("%-10s %8u %10u %10u %8u %10u %10u",
+		     POPCORN_MEMORY_TAG_NAME[i],
+		     (uint32_t) s.host_count,
+		     (uint32_t) s.host_live,
+		     (uint32_t) s.host_peak,
+		     (uint32_t) s.gpu_count,
+		     (uint32_t) s.gpu_live,
+		     (uint32_t) s.gpu_peak);
+	}
+
+	popcorn_memoryCounter_t* c = &popcorn_memory_total;
+	LOGI("%-10s %8u %10u %10u %8u %10u %10u",
+	     "total",
+	     (uint32_t) atomic_load(&c->host_count),
+	     (uint32_t) atomic_load(&c->host_live),
+	     (uint32_t) atomic_load(&c->host_peak),
+	     (uint32_t) atomic_load(&c->gpu_count),
+	     (uint32_t) atomic_load(&c->gpu_live),
+	     (uint32_t) atomic_load(&c->gpu_peak));
+
+	LOGI("frames=%u, max_allocs_per_frame=%u, steady_violations=%u",
+	     popcorn_memory_frames, popcorn_memory_frameMax,
+	     popcorn_memory_violations);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_memory_H
+#define popcorn_memory_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// tagged memory accounting
+// build with -DPOPCORN_MEMORY_ASSERT to fail on any
+// allocation in the steady-state frame loop
+
+typedef enum
+{
+	POPCORN_MEMORY_TAG_RENDERER  = 0,
+	POPCORN_MEMORY_TAG_COCKPIT   = 1,
+	POPCORN_MEMORY_TAG_PART      = 2,
+	POPCORN_MEMORY_TAG_COLLISION = 3,
+	POPCORN_MEMORY_TAG_INPUT     = 4,
+	POPCORN_MEMORY_TAG_SIM       = 5,
+	POPCORN_MEMORY_TAG_RECORDER  = 6,
+	POPCORN_MEMORY_TAG_MESH      = 7,
+	POPCORN_MEMORY_TAG_SCENE     = 8,
+	POPCORN_MEMORY_TAG_ARENA     = 9,
+	POPCORN_MEMORY_TAG_QUEUE     = 10,
+	POPCORN_MEMORY_TAG_PARTICLE  = 11,
+} popcorn_memoryTag_e;
+
+#define POPCORN_MEMORY_TAG_COUNT 12
+
+typedef struct
+{
+	size_t host_count;
+	size_t host_live;
+	size_t host_peak;
+	size_t gpu_count;
+	size_t gpu_live;
+	size_t gpu_peak;
+} popcorn_memoryStats_t;
+
+// host allocations
+void* popcorn_memory_calloc(popcorn_memoryTag_e tag,
+                            size_t count, size_t size);
+void* popcorn_memory_realloc(popcorn_memoryTag_e tag,
+                             void* ptr, size_t size);
+void  popcorn_memory_free(void* ptr);
+
+// GPU buffers are created by vkk so the
+// caller reports their size
+void popcorn_memory_gpuAlloc(popcorn_memoryTag_e tag,
+                             size_t size);
+void popcorn_memory_gpuFree(popcorn_memoryTag_e tag,
+                            size_t size);
+
+// frame accounting
+void     popcorn_memory_steady(int steady);
+uint32_t popcorn_memory_frame(void);
+
+// reporting
+void popcorn_memory_stats(popcorn_memoryTag_e tag,
+                          popcorn_memoryStats_t* stats);
+void popcorn_memory_report(void);
+
+#endif
@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define POPCORN_MESH_NEON
+#endif
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_mesh.h"
+
+// octahedral normal quantization
+#define POPCORN_MESH_SNORM (1.0f/32767.0f)
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static size_t popcorn_mesh_align(size_t size)
+{
+	return (size + 15) & ~((size_t) 15);
+}
+
+static size_t popcorn_mesh_dstSize(uint32_t ic, uint32_t vc)
+{
+	// indices, positions and normals
+	return popcorn_mesh_align(2*((size_t) ic)) +
+	       2*popcorn_mesh_align(12*((size_t) vc));
+}
+
+static int
+popcorn_mesh_resize(void** _buf, size_t* _size, size_t size)
+{
+	ASSERT(_buf);
+	ASSERT(_size);
+
+	if(*_size >= size)
+	{
+		return 1;
+	}
+
+	void* buf;
+	buf = popcorn_memory_realloc(POPCORN_MEMORY_TAG_MESH,
+	                             *_buf, size);
+	if(buf == NULL)
+	{
+		LOGE("REALLOC failed");
+		return 0;
+	}
+
+	*_buf  = buf;
+	*_size = size;
+
+	return 1;
+}
+
+static const char* popcorn_mesh_header(popcorn_mesh_t* self)
+{
+	ASSERT(self);
+
+	popcorn_meshPart_t* part = &self->part;
+	if(self->offset + sizeof(popcorn_meshPart_t) > self->size)
+	{
+		LOGE("invalid offset=%u", (uint32_t) self->offset);
+		return NULL;
+	}
+	memcpy(part, self->buf + self->offset,
+	       sizeof(popcorn_meshPart_t));
+	self->offset += sizeof(popcorn_meshPart_t);
+
+	if(part->node >= self->nodes)
+	{
+		LOGE("invalid node=%u", part->node);
+		return NULL;
+	}
+
+	if((part->lods == 0) || (part->lods > POPCORN_MESH_LODS) ||
+	   (part->lod >= part->lods))
+	{
+		LOGE("invalid lod=%u, lods=%u", part->lod, part->lods);
+		return NULL;
+	}
+
+	if((part->vc == 0) || (part->vc > 65536))
+	{
+		LOGE("invalid vc=%u", part->vc);
+		return NULL;
+	}
+
+	// the compressed part follows the header
+	const char* src = self->buf + self->offset;
+	if(self->offset + part->size > self->size)
+	{
+		LOGE("invalid size=%u", part->size);
+		return NULL;
+	}
+	self->offset += part->size;
+
+	return src;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_mesh_t* popcorn_mesh_new(const void* buf, size_t size)
+{
+	ASSERT(buf);
+
+	popcorn_meshHeader_t header;
+	if(size < sizeof(popcorn_meshHeader_t))
+	{
+		LOGE("invalid size=%u", (uint32_t) size);
+		return NULL;
+	}
+	memcpy(&header, buf, sizeof(popcorn_meshHeader_t));
+
+	if((header.magic   != POPCORN_MESH_MAGIC) ||
+	   (header.version != POPCORN_MESH_VERSION))
+	{
+		LOGE("invalid magic=0x%X, version=%u",
+		     header.magic, header.version);
+		return NULL;
+	}
+
+	popcorn_mesh_t* self;
+	self = (popcorn_mesh_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                             1, sizeof(popcorn_mesh_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->buf    = (const char*) buf;
+	self->size   = size;
+	self->offset = sizeof(popcorn_meshHeader_t);
+	self->count  = header.count;
+	self->nodes  = header.nodes;
+
+	// copy the node table since the mapping
+	// may not be aligned
+	size_t size_node = header.nodes*sizeof(popcorn_meshNode_t);
+	if(self->offset + size_node > size)
+	{
+		LOGE("invalid nodes=%u", header.nodes);
+		goto fail_nodes;
+	}
+
+	if(header.nodes)
+	{
+		self->node = (popcorn_meshNode_t*)
+		             popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+		                                   header.nodes,
+		                                   sizeof(popcorn_meshNode_t));
+		if(self->node == NULL)
+		{
+			LOGE("CALLOC failed");
+			goto fail_nodes;
+		}
+		memcpy(self->node, self->buf + self->offset, size_node);
+		self->offset += size_node;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_nodes:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_mesh_delete(popcorn_mesh_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_mesh_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->dst);
+		popcorn_memory_free(self->raw);
+		popcorn_memory_free(self->node);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_mesh_next(popcorn_mesh_t* self)
+{
+	ASSERT(self);
+
+	popcorn_meshPart_t* part = &self->part;
+
+	// the compressed part is inflated in place
+	const char* src = popcorn_mesh_header(self);
+	if(src == NULL)
+	{
+		return 0;
+	}
+
+	// entropy decode
+	size_t size_raw = popcorn_mesh_rawSize(part->ic, part->vc);
+	if(popcorn_mesh_resize(&self->raw, &self->size_raw,
+	                       size_raw) == 0)
+	{
+		return 0;
+	}
+
+	uLongf len = (uLongf) size_raw;
+	if((uncompress((Bytef*) self->raw, &len,
+	               (const Bytef*) src,
+	               (uLong) part->size) != Z_OK) ||
+	   (len != (uLongf) size_raw))
+	{
+		LOGE("uncompress failed");
+		return 0;
+	}
+
+	// decode into the upload staging buffer
+	size_t size_ib  = popcorn_mesh_align(2*part->ic);
+	size_t size_vb  = popcorn_mesh_align(12*part->vc);
+	size_t size_dst = popcorn_mesh_dstSize(part->ic, part->vc);
+	if(popcorn_mesh_resize(&self->dst, &self->size_dst,
+	                       size_dst) == 0)
+	{
+		return 0;
+	}
+
+	const char* raw = (const char*) self->raw;
+	char*       dst = (char*) self->dst;
+	self->ib = (uint16_t*) dst;
+	self->vb = (float*) (dst + size_ib);
+	self->nb = (float*) (dst + size_ib + size_vb);
+
+	// corrupt deltas may decode to any index so the
+	// indices are validated like popcorn_convert_narrow
+	uint32_t top;
+	top = popcorn_mesh_decodeIndices((const uint16_t*) raw,
+	                                 self->ib, part->ic);
+	if((part->ic > 0) && (top >= part->vc))
+	{
+		LOGE("invalid index=%u, vc=%u", top, part->vc);
+		return 0;
+	}
+	raw += 2*part->ic;
+	popcorn_mesh_decodePositions((const uint16_t*) raw,
+	                             self->vb, part->vc,
+	                             part->offset, part->scale);
+	raw += 6*part->vc;
+	popcorn_mesh_decodeNormals((const int16_t*) raw,
+	                           self->nb, part->vc);
+
+	return 1;
+}
+
+int popcorn_mesh_reserve(popcorn_mesh_t* self,
+                         uint32_t ic, uint32_t vc)
+{
+	ASSERT(self);
+
+	// parts up to the reserved size are decoded
+	// without resizing the scratch buffers
+	return popcorn_mesh_resize(&self->raw, &self->size_raw,
+	                           popcorn_mesh_rawSize(ic, vc)) &&
+	       popcorn_mesh_resize(&self->dst, &self->size_dst,
+	                           popcorn_mesh_dstSize(ic, vc));
+}
+
+int popcorn_mesh_skip(popcorn_mesh_t* self)
+{
+	ASSERT(self);
+
+	return popcorn_mesh_header(self) ? 1 : 0;
+}
+
+int popcorn_mesh_seek(popcorn_mesh_t* self, size_t offset)
+{
+	ASSERT(self);
+
+	if((offset < sizeof(popcorn_meshHeader_t)) ||
+	   (offset >= self->size))
+	{
+		LOGE("invalid offset=%u", (uint32_t) offset);
+		return 0;
+	}
+
+	self->offset = offset;
+	return 1;
+}
+
+size_t popcorn_mesh_rawSize(uint32_t ic, uint32_t vc)
+{
+	return 2*ic + 6*vc + 4*vc;
+}
+
+uint32_t popcorn_mesh_decodeIndices(const uint16_t* src,
+                                    uint16_t* dst,
+                                    uint32_t ic)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	uint32_t i    = 0;
+	uint16_t prev = 0;
+	uint16_t top  = 0;
+
+	// unzigzag the deltas and prefix sum 8 indices at a time
+	#if defined(__SSE2__)
+	__m128i one  = _mm_set1_epi16(1);
+	__m128i zero = _mm_setzero_si128();
+	__m128i last = zero;
+
+	// SSE2 lacks an unsigned max so the indices are
+	// biased into the signed range
+	__m128i bias = _mm_set1_epi16(-32768);
+	__m128i vmax = bias;
+	for(; i + 8 <= ic; i += 8)
+	{
+		__m128i z = _mm_loadu_si128((const __m128i*) &src[i]);
+		__m128i d = _mm_xor_si128(_mm_srli_epi16(z, 1),
+		                          _mm_sub_epi16(zero,
+		                                        _mm_and_si128(z, one)));
+		d = _mm_add_epi16(d, _mm_slli_si128(d, 2));
+		d = _mm_add_epi16(d, _mm_slli_si128(d, 4));
+		d = _mm_add_epi16(d, _mm_slli_si128(d, 8));
+		d = _mm_add_epi16(d, last);
+		_mm_storeu_si128((__m128i*) &dst[i], d);
+		vmax = _mm_max_epi16(vmax, _mm_xor_si128(d, bias));
+
+		// broadcast the last index
+		last = _mm_shufflehi_epi16(d, _MM_SHUFFLE(3, 3, 3, 3));
+		last = _mm_unpackhi_epi64(last, last);
+	}
+	prev = (uint16_t) _mm_extract_epi16(last, 0);
+	vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 8));
+	vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 4));
+	vmax = _mm_max_epi16(vmax, _mm_srli_si128(vmax, 2));
+	top  = (uint16_t) (_mm_extract_epi16(vmax, 0) ^ 0x8000);
+	#elif defined(POPCORN_MESH_NEON)
+	uint16x8_t one  = vdupq_n_u16(1);
+	uint16x8_t zero = vdupq_n_u16(0);
+	uint16x8_t last = zero;
+	uint16x8_t vmax = zero;
+	for(; i + 8 <= ic; i += 8)
+	{
+		uint16x8_t z = vld1q_u16(&src[i]);
+		uint16x8_t d = veorq_u16(vshrq_n_u16(z, 1),
+		                         vsubq_u16(zero, vandq_u16(z, one)));
+		d = vaddq_u16(d, vextq_u16(zero, d, 7));
+		d = vaddq_u16(d, vextq_u16(zero, d, 6));
+		d = vaddq_u16(d, vextq_u16(zero, d, 4));
+		d = vaddq_u16(d, last);
+		vst1q_u16(&dst[i], d);
+		vmax = vmaxq_u16(vmax, d);
+
+		// broadcast the last index
+		last = vdupq_n_u16(vgetq_lane_u16(d, 7));
+	}
+	prev = vgetq_lane_u16(last, 0);
+	top  = vmaxvq_u16(vmax);
+	#endif
+
+	for(; i < ic; ++i)
+	{
+		uint16_t z = src[i];
+		prev   = (uint16_t) (prev + ((z >> 1) ^ (-(z & 1))));
+		dst[i] = prev;
+		if(prev > top)
+		{
+			top = prev;
+		}
+	}
+
+	return top;
+}
+
+void popcorn_mesh_decodePositions(const uint16_t* src,
+                                  float* dst, uint32_t vc,
+                                  const float* offset,
+                                  const float* scale)
+{
+	ASSERT(src);
+	ASSERT(dst);
+	ASSERT(offset);
+	ASSERT(scale);
+
+	uint32_t i = 0;
+	uint32_t n = 3*vc;
+
+	// dequantize 4 vertices (12 components) at a time
+	#if defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	__m128  o0   = _mm_setr_ps(offset[0], offset[1],
+	                           offset[2], offset[0]);
+	__m128  o1   = _mm_setr_ps(offset[1], offset[2],
+	                           offset[0], offset[1]);
+	__m128  o2   = _mm_setr_ps(offset[2], offset[0],
+	                           offset[1], offset[2]);
+	__m128  s0   = _mm_setr_ps(scale[0], scale[1],
+	                           scale[2], scale[0]);
+	__m128  s1   = _mm_setr_ps(scale[1], scale[2],
+	                           scale[0], scale[1]);
+	__m128  s2   = _mm_setr_ps(scale[2], scale[0],
+	                           scale[1], scale[2]);
+	for(; i + 12 <= n; i += 12)
+	{
+		__m128i a  = _mm_loadu_si128((const __m128i*) &src[i]);
+		__m128i b  = _mm_loadl_epi64((const __m128i*) &src[i + 8]);
+		__m128  f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(a, zero));
+		__m128  f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(a, zero));
+		__m128  f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(b, zero));
+		_mm_storeu_ps(&dst[i],     _mm_add_ps(o0, _mm_mul_ps(s0, f0)));
+		_mm_storeu_ps(&dst[i + 4], _mm_add_ps(o1, _mm_mul_ps(s1, f1)));
+		_mm_storeu_ps(&dst[i + 8], _mm_add_ps(o2, _mm_mul_ps(s2, f2)));
+	}
+	#elif defined(POPCORN_MESH_NEON)
+	float o[12] =
+	{
+		offset[0], offset[1], offset[2], offset[0],
+		offset[1], offset[2], offset[0], offset[1],
+		offset[2], offset[0], offset[1], offset[2],
+	};
+	float s[12] =
+	{
+		scale[0], scale[1], scale[2], scale[0],
+		scale[1], scale[2], scale[0], scale[1],
+		scale[2], scale[0], scale[1], scale[2],
+	};
+	float32x4_t o0 = vld1q_f32(&o[0]);
+	float32x4_t o1 = vld1q_f32(&o[4]);
+	float32x4_t o2 = vld1q_f32(&o[8]);
+	float32x4_t s0 = vld1q_f32(&s[0]);
+	float32x4_t s1 = vld1q_f32(&s[4]);
+	float32x4_t s2 = vld1q_f32(&s[8]);
+	for(; i + 12 <= n; i += 12)
+	{
+		uint16x8_t  a  = vld1q_u16(&src[i]);
+		uint16x4_t  b  = vld1_u16(&src[i + 8]);
+		float32x4_t f0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(a)));
+		float32x4_t f1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(a)));
+		float32x4_t f2 = vcvtq_f32_u32(vmovl_u16(b));
+		vst1q_f32(&dst[i],     vmlaq_f32(o0, s0, f0));
+		vst1q_f32(&dst[i + 4], vmlaq_f32(o1, s1, f1));
+		vst1q_f32(&dst[i + 8], vmlaq_f32(o2, s2, f2));
+	}
+	#endif
+
+	for(; i < n; ++i)
+	{
+		uint32_t c = i%3;
+		dst[i] = offset[c] + scale[c]*((float) src[i]);
+	}
+}
+
+void popcorn_mesh_decodeNormals(const int16_t* src,
+                                float* dst, uint32_t vc)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	uint32_t i = 0;
+
+	// unfold 4 octahedral normals at a time
+	#if defined(__SSE2__)
+	__m128 k    = _mm_set1_ps(POPCORN_MESH_SNORM);
+	__m128 one  = _mm_set1_ps(1.0f);
+	__m128 zero = _mm_setzero_ps();
+	__m128 sign = _mm_set1_ps(-0.0f);
+	for(; i + 4 <= vc; i += 4)
+	{
+		__m128i a  = _mm_loadu_si128((const __m128i*) &src[2*i]);
+		__m128  lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16));
+		__m128  hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16));
+		__m128  u  = _mm_mul_ps(k, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128  v  = _mm_mul_ps(k, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+		__m128  z  = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, u)),
+		                        _mm_andnot_ps(sign, v));
+		__m128  t  = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+		__m128  x  = _mm_sub_ps(u, _mm_or_ps(t, _mm_and_ps(sign, u)));
+		__m128  y  = _mm_sub_ps(v, _mm_or_ps(t, _mm_and_ps(sign, v)));
+		__m128  m  = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x),
+		                                               _mm_mul_ps(y, y)),
+		                                    _mm_mul_ps(z, z)));
+		x = _mm_div_ps(x, m);
+		y = _mm_div_ps(y, m);
+		z = _mm_div_ps(z, m);
+
+		float xyz[12];
+		_mm_storeu_ps(&xyz[0], x);
+		_mm_storeu_ps(&xyz[4], y);
+		_mm_storeu_ps(&xyz[8], z);
+
+		float*   d = &dst[3*i];
+		uint32_t j;
+		for(j = 0; j < 4; ++j)
+		{
+			d[3*j]     = xyz[j];
+			d[3*j + 1] = xyz[j + 4];
+			d[3*j + 2] = xyz[j + 8];
+		}
+	}
+	#elif defined(POPCORN_MESH_NEON)
+	float32x4_t one  = vdupq_n_f32(1.0f);
+	float32x4_t zero = vdupq_n_f32(0.0f);
+	uint32x4_t  sign = vdupq_n_u32(0x80000000);
+	for(; i + 4 <= vc; i += 4)
+	{
+		int16x4x2_t uv = vld2_s16(&src[2*i]);
+		float32x4_t u  = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(uv.val[0])),
+		                             POPCORN_MESH_SNORM);
+		float32x4_t v  = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(uv.val[1])),
+		                             POPCORN_MESH_SNORM);
+		float32x4_t z  = vsubq_f32(vsubq_f32(one, vabsq_f32(u)),
+		                           vabsq_f32(v));
+		float32x4_t t  = vmaxq_f32(vnegq_f32(z), zero);
+		float32x4_t x  = vsubq_f32(u, vbslq_f32(sign, u, t));
+		float32x4_t y  = vsubq_f32(v, vbslq_f32(sign, v, t));
+		float32x4_t m  = vsqrtq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(x, x),
+		                                                y, y),
+		                                      z, z));
+
+		float32x4x3_t xyz;
+		xyz.val[0] = vdivq_f32(x, m);
+		xyz.val[1] = vdivq_f32(y, m);
+		xyz.val[2] = vdivq_f32(z, m);
+		vst3q_f32(&dst[3*i], xyz);
+	}
+	#endif
+
+	for(; i < vc; ++i)
+	{
+		float u = POPCORN_MESH_SNORM*((float) src[2*i]);
+		float v = POPCORN_MESH_SNORM*((float) src[2*i + 1]);
+		float z = 1.0f - fabsf(u) - fabsf(v);
+		float t = (z < 0.0f) ? -z : 0.0f;
+		float x = (u < 0.0f) ? u + t : u - t;
+		float y = (v < 0.0f) ? v + t : v - t;
+		float m = sqrtf(x*x + y*y + z*z);
+
+		dst[3*i]     = x/m;
+		dst[3*i + 1] = y/m;
+		dst[3*i + 2] = z/m;
+	}
+}
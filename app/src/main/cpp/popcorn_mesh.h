@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_mesh_H
+#define popcorn_mesh_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// compressed mesh file (pcm)
+// header followed by the node table in depth-first
+// preorder and count parts where each part is
+// a part header and a zlib stream which inflates to
+//   uint16_t indices[ic];   // zigzag deltas
+//   uint16_t positions[3*vc]; // quantized to the bounds
+//   int16_t  normals[2*vc];   // octahedral snorm
+//
+// each primitive is stored as a chain of lods parts with
+// decreasing detail (lod 0 is the source primitive)
+#define POPCORN_MESH_MAGIC   0x314D4350 // "PCM1"
+#define POPCORN_MESH_VERSION 3
+#define POPCORN_MESH_LODS    4
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t nodes;
+} popcorn_meshHeader_t;
+
+typedef struct
+{
+	// parent is -1 for root nodes
+	int32_t parent;
+	float   local[16];
+} popcorn_meshNode_t;
+
+typedef struct
+{
+	uint32_t node;
+	uint32_t ic;
+	uint32_t vc;
+	uint32_t size;
+
+	// level of the chain and its simplification error
+	// in the units of the node
+	uint32_t lod;
+	uint32_t lods;
+	float    error;
+
+	// position = offset + scale*q
+	float offset[3];
+	float scale[3];
+} popcorn_meshPart_t;
+
+typedef struct popcorn_mesh_s
+{
+	// encoded mesh which may be mapped from the pak
+	const char* buf;
+	size_t      size;
+	size_t      offset;
+	uint32_t    count;
+
+	// node table
+	uint32_t            nodes;
+	popcorn_meshNode_t* node;
+
+	// decoded part
+	popcorn_meshPart_t part;
+	uint16_t*          ib;
+	float*             vb;
+	float*             nb;
+
+	// scratch buffers reused across parts
+	size_t size_raw;
+	size_t size_dst;
+	void*  raw;
+	void*  dst;
+} popcorn_mesh_t;
+
+popcorn_mesh_t* popcorn_mesh_new(const void* buf, size_t size);
+void            popcorn_mesh_delete(popcorn_mesh_t** _self);
+int             popcorn_mesh_next(popcorn_mesh_t* self);
+int             popcorn_mesh_reserve(popcorn_mesh_t* self,
+                                     uint32_t ic, uint32_t vc);
+int             popcorn_mesh_skip(popcorn_mesh_t* self);
+int             popcorn_mesh_seek(popcorn_mesh_t* self,
+                                  size_t offset);
+size_t          popcorn_mesh_rawSize(uint32_t ic, uint32_t vc);
+
+// decode kernels
+// decodeIndices returns the largest decoded index
+uint32_t popcorn_mesh_decodeIndices(const uint16_t* src,
+                                    uint16_t* dst,
+                                    uint32_t ic);
+void     popcorn_mesh_decodePositions(const uint16_t* src,
+                                      float* dst, uint32_t vc,
+                                      const float* offset,
+                                      const float* scale);
+void     popcorn_mesh_decodeNormals(const int16_t* src,
+                                    float* dst, uint32_t vc);
+
+#endif
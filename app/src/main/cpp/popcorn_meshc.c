@@ -0,0 +1,665 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libgltf/gltf.h"
+#include "popcorn_gltf.h"
+#include "popcorn_memory.h"
+#include "popcorn_mesh.h"
+#include "popcorn_scene.h"
+#include "popcorn_simplify.h"
+
+// LOD chains
+// each level targets half of the triangles of the previous
+// level and the chain ends once a level removes less than
+// 1/4 of the triangles, the error exceeds 1/10 of the part
+// radius or the part is small
+#define POPCORN_MESHC_LOD_REDUCTION 0.75f
+#define POPCORN_MESHC_LOD_ERROR     0.1f
+#define POPCORN_MESHC_LOD_MIN_IC    96
+
+typedef struct
+{
+	FILE*    f;
+	uint32_t count;
+
+	// node hierarchy in preorder
+	popcorn_scene_t* scene;
+	gltf_node_t**    nodes;
+
+	size_t   size_src;
+	size_t   size_dst;
+	float    error_vb;
+	float    error_nb;
+
+	// triangles and parts of each level
+	uint32_t lod_parts[POPCORN_MESH_LODS];
+	uint32_t lod_ic[POPCORN_MESH_LODS];
+	float    lod_error[POPCORN_MESH_LODS];
+} popcorn_meshc_t;
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static uint16_t popcorn_meshc_zigzag(int16_t d)
+{
+	return (uint16_t) ((((uint16_t) d) << 1) ^ (d >> 15));
+}
+
+static int16_t popcorn_meshc_snorm(float f)
+{
+	if(f > 1.0f)
+	{
+		f = 1.0f;
+	}
+	else if(f < -1.0f)
+	{
+		f = -1.0f;
+	}
+	return (int16_t) lroundf(32767.0f*f);
+}
+
+static void
+popcorn_meshc_octahedral(const float* n, int16_t* uv)
+{
+	ASSERT(n);
+	ASSERT(uv);
+
+	// project onto the octahedron and fold the
+	// lower hemisphere over the upper hemisphere
+	float l = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+	float u = 0.0f;
+	float v = 0.0f;
+	if(l > 0.0f)
+	{
+		u = n[0]/l;
+		v = n[1]/l;
+		if(n[2] < 0.0f)
+		{
+			float fu = (1.0f - fabsf(v))*((u < 0.0f) ? -1.0f : 1.0f);
+			float fv = (1.0f - fabsf(u))*((v < 0.0f) ? -1.0f : 1.0f);
+			u = fu;
+			v = fv;
+		}
+	}
+
+	uv[0] = popcorn_meshc_snorm(u);
+	uv[1] = popcorn_meshc_snorm(v);
+}
+
+static int
+popcorn_meshc_encode(popcorn_meshc_t* self, uint32_t node,
+                     uint32_t lod, uint32_t lods, float error,
+                     uint32_t ic, const uint16_t* ib,
+                     uint32_t vc, const float* vb,
+                     const float* nb)
+{
+	ASSERT(self);
+	ASSERT(ib);
+	ASSERT(vb);
+	ASSERT(nb);
+
+	popcorn_meshPart_t part =
+	{
+		.node  = node,
+		.ic    = ic,
+		.vc    = vc,
+		.lod   = lod,
+		.lods  = lods,
+		.error = error,
+	};
+
+	// position bounds
+	uint32_t i;
+	uint32_t c;
+	float    max[3];
+	for(c = 0; c < 3; ++c)
+	{
+		part.offset[c] = vb[c];
+		max[c]         = vb[c];
+	}
+	for(i = 1; i < vc; ++i)
+	{
+		for(c = 0; c < 3; ++c)
+		{
+			float p = vb[3*i + c];
+			if(p < part.offset[c])
+			{
+				part.offset[c] = p;
+			}
+			if(p > max[c])
+			{
+				max[c] = p;
+			}
+		}
+	}
+	for(c = 0; c < 3; ++c)
+	{
+		part.scale[c] = (max[c] - part.offset[c])/65535.0f;
+	}
+
+	size_t size_raw = popcorn_mesh_rawSize(ic, vc);
+	size_t size_dec = 2*ic + 24*vc;
+	uLong  bound    = compressBound((uLong) size_raw);
+
+	char* raw;
+	raw = (char*)
+	      popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH, 1,
+	                            size_raw + size_dec + bound);
+	if(raw == NULL)
+	{
+		LOGE("CALLOC failed");
+		return 0;
+	}
+
+	uint16_t* qib = (uint16_t*) raw;
+	uint16_t* qvb = (uint16_t*) (raw + 2*ic);
+	int16_t*  qnb = (int16_t*)  (raw + 2*ic + 6*vc);
+	uint16_t* dib = (uint16_t*) (raw + size_raw);
+	float*    dvb = (float*)    (raw + size_raw + 2*ic);
+	float*    dnb = (float*)    (raw + size_raw + 2*ic + 12*vc);
+	Bytef*    dst = (Bytef*)    (raw + size_raw + size_dec);
+
+	// delta and zigzag indices
+	uint16_t prev = 0;
+	for(i = 0; i < ic; ++i)
+	{
+		qib[i] = popcorn_meshc_zigzag((int16_t) (ib[i] - prev));
+		prev   = ib[i];
+	}
+
+	// quantize positions to the bounds
+	for(i = 0; i < vc; ++i)
+	{
+		for(c = 0; c < 3; ++c)
+		{
+			float q = 0.0f;
+			if(part.scale[c] > 0.0f)
+			{
+				q = (vb[3*i + c] - part.offset[c])/part.scale[c];
+			}
+			qvb[3*i + c] = (uint16_t) lroundf(q);
+		}
+	}
+
+	// octahedral normals
+	for(i = 0; i < vc; ++i)
+	{
+		popcorn_meshc_octahedral(&nb[3*i], &qnb[2*i]);
+	}
+
+	// verify the decoder
+	popcorn_mesh_decodeIndices(qib, dib, ic);
+	popcorn_mesh_decodePositions(qvb, dvb, vc,
+	                             part.offset, part.scale);
+	popcorn_mesh_decodeNormals(qnb, dnb, vc);
+	if(memcmp(ib, dib, 2*ic) != 0)
+	{
+		LOGE("invalid indices");
+		goto fail_verify;
+	}
+
+	for(i = 0; i < 3*vc; ++i)
+	{
+		float dv = fabsf(dvb[i] - vb[i]);
+		float dn = fabsf(dnb[i] - nb[i]);
+		if(dv > self->error_vb)
+		{
+			self->error_vb = dv;
+		}
+		if(dn > self->error_nb)
+		{
+			self->error_nb = dn;
+		}
+	}
+
+	// entropy encode
+	uLongf size = bound;
+	if(compress2(dst, &size, (const Bytef*) raw,
+	             (uLong) size_raw, 9) != Z_OK)
+	{
+		LOGE("compress2 failed");
+		goto fail_compress;
+	}
+	part.size = (uint32_t) size;
+
+	if((fwrite(&part, sizeof(popcorn_meshPart_t), 1,
+	           self->f) != 1) ||
+	   (fwrite(dst, size, 1, self->f) != 1))
+	{
+		LOGE("fwrite failed");
+		goto fail_write;
+	}
+
+	self->size_src += 2*ic + 24*vc;
+	self->size_dst += sizeof(popcorn_meshPart_t) + size;
+	++self->count;
+
+	self->lod_ic[lod] += ic;
+	++self->lod_parts[lod];
+	if(error > self->lod_error[lod])
+	{
+		self->lod_error[lod] = error;
+	}
+
+	popcorn_memory_free(raw);
+
+	// success
+	return 1;
+
+	// failure
+	fail_write:
+	fail_compress:
+	fail_verify:
+		popcorn_memory_free(raw);
+	return 0;
+}
+
+static float
+popcorn_meshc_radius(uint32_t vc, const float* vb)
+{
+	ASSERT(vb);
+
+	float min[3] = { vb[0], vb[1], vb[2] };
+	float max[3] = { vb[0], vb[1], vb[2] };
+
+	uint32_t i;
+	int      c;
+	for(i = 1; i < vc; ++i)
+	{
+		for(c = 0; c < 3; ++c)
+		{
+			float p = vb[3*i + c];
+			if(p < min[c])
+			{
+				min[c] = p;
+			}
+			if(p > max[c])
+			{
+				max[c] = p;
+			}
+		}
+	}
+
+	float dx = max[0] - min[0];
+	float dy = max[1] - min[1];
+	float dz = max[2] - min[2];
+	return 0.5f*sqrtf(dx*dx + dy*dy + dz*dz);
+}
+
+static int
+popcorn_meshc_encodeLods(popcorn_meshc_t* self,
+                         uint32_t node,
+                         uint32_t ic, const uint16_t* ib,
+                         uint32_t vc, const float* vb,
+                         const float* nb)
+{
+	ASSERT(self);
+	ASSERT(ib);
+	ASSERT(vb);
+	ASSERT(nb);
+
+	float max_error = POPCORN_MESHC_LOD_ERROR*
+	                  popcorn_meshc_radius(vc, vb);
+
+	// the chain length is stored in each part so the
+	// levels are counted before they are encoded
+	// simplification is deterministic
+	popcorn_simplify_t* simplify;
+	simplify = popcorn_simplify_new(ic, ib, vc, vb, nb);
+	if(simplify == NULL)
+	{
+		return 0;
+	}
+
+	uint32_t lods = 1;
+	while((lods < POPCORN_MESH_LODS) &&
+	      (simplify->ic >= POPCORN_MESHC_LOD_MIN_IC))
+	{
+		uint32_t prev = simplify->ic;
+		popcorn_simplify_reduce(simplify, prev/2, max_error);
+		if((float) simplify->ic >
+		   POPCORN_MESHC_LOD_REDUCTION*((float) prev))
+		{
+			break;
+		}
+		++lods;
+	}
+	popcorn_simplify_delete(&simplify);
+
+	if(popcorn_meshc_encode(self, node, 0, lods, 0.0f,
+	                        ic, ib, vc, vb, nb) == 0)
+	{
+		return 0;
+	}
+
+	if(lods == 1)
+	{
+		return 1;
+	}
+
+	simplify = popcorn_simplify_new(ic, ib, vc, vb, nb);
+	if(simplify == NULL)
+	{
+		return 0;
+	}
+
+	uint32_t lod;
+	for(lod = 1; lod < lods; ++lod)
+	{
+		popcorn_simplify_reduce(simplify, simplify->ic/2,
+		                        max_error);
+		if(popcorn_meshc_encode(self, node, lod, lods,
+		                        simplify->error,
+		                        simplify->ic, simplify->ib,
+		                        simplify->out_vc,
+		                        simplify->vb_out,
+		                        simplify->nb_out) == 0)
+		{
+			goto fail_encode;
+		}
+	}
+
+	popcorn_simplify_delete(&simplify);
+
+	// success
+	return 1;
+
+	// failure
+	fail_encode:
+		popcorn_simplify_delete(&simplify);
+	return 0;
+}
+
+static int
+popcorn_meshc_parseNode(popcorn_meshc_t* self,
+                        gltf_file_t* file,
+                        uint32_t id, int32_t parent,
+                        uint32_t depth)
+{
+	ASSERT(self);
+	ASSERT(file);
+
+	gltf_node_t* node = gltf_file_getNode(file, id);
+	if((node == NULL) || (depth >= POPCORN_GLTF_DEPTH))
+	{
+		LOGE("invalid node=%u, depth=%u", id, depth);
+		return 0;
+	}
+
+	cc_mat4f_t local;
+	popcorn_gltf_local(node, &local);
+
+	int idx = popcorn_scene_add(self->scene, parent, &local);
+	if(idx < 0)
+	{
+		return 0;
+	}
+
+	gltf_node_t** nodes;
+	nodes = (gltf_node_t**)
+	        popcorn_memory_realloc(POPCORN_MEMORY_TAG_MESH,
+	                               self->nodes,
+	                               (idx + 1)*sizeof(gltf_node_t*));
+	if(nodes == NULL)
+	{
+		LOGE("REALLOC failed");
+		return 0;
+	}
+	self->nodes      = nodes;
+	self->nodes[idx] = node;
+
+	cc_listIter_t* iter = cc_list_head(node->children);
+	while(iter)
+	{
+		uint32_t* child = (uint32_t*) cc_list_peekIter(iter);
+		if(popcorn_meshc_parseNode(self, file, *child,
+		                           (int32_t) idx,
+		                           depth + 1) == 0)
+		{
+			return 0;
+		}
+
+		iter = cc_list_next(iter);
+	}
+
+	return 1;
+}
+
+static int
+popcorn_meshc_parseFile(popcorn_meshc_t* self,
+                        popcorn_gltf_t* loader,
+                        gltf_file_t* file)
+{
+	ASSERT(self);
+	ASSERT(loader);
+	ASSERT(file);
+
+	// matches the parts loaded by popcorn_cockpit
+	gltf_scene_t* scene;
+	scene = gltf_file_getScene(file, file->scene);
+	if(scene == NULL)
+	{
+		return 0;
+	}
+
+	cc_listIter_t* iter = cc_list_head(scene->nodes);
+	while(iter)
+	{
+		uint32_t* nd = (uint32_t*) cc_list_peekIter(iter);
+		if(popcorn_meshc_parseNode(self, file, *nd,
+		                           POPCORN_SCENE_ROOT, 0) == 0)
+		{
+			return 0;
+		}
+
+		iter = cc_list_next(iter);
+	}
+
+	// write the node table
+	uint32_t i;
+	for(i = 0; i < self->scene->count; ++i)
+	{
+		popcorn_meshNode_t mn =
+		{
+			.parent = self->scene->parent[i],
+		};
+		memcpy(mn.local, &self->scene->local[i],
+		       sizeof(cc_mat4f_t));
+		if(fwrite(&mn, sizeof(popcorn_meshNode_t), 1,
+		          self->f) != 1)
+		{
+			LOGE("fwrite failed");
+			return 0;
+		}
+	}
+
+	// write the parts of each node
+	for(i = 0; i < self->scene->count; ++i)
+	{
+		gltf_node_t* node = self->nodes[i];
+		if(node->has_mesh == 0)
+		{
+			continue;
+		}
+
+		gltf_mesh_t* mesh = gltf_file_getMesh(file, node->mesh);
+		if(mesh == NULL)
+		{
+			return 0;
+		}
+
+		cc_listIter_t* piter = cc_list_head(mesh->primitives);
+		while(piter)
+		{
+			gltf_primitive_t* primitive;
+			primitive = (gltf_primitive_t*) cc_list_peekIter(piter);
+
+			// points and lines are skipped with a warning
+			if(popcorn_gltf_isTriangles(primitive))
+			{
+				if((popcorn_gltf_load(loader, file,
+				                      primitive) == 0) ||
+				   (popcorn_meshc_encodeLods(self, i,
+				                             loader->ic, loader->ib,
+				                             loader->vc, loader->vb,
+				                             loader->nb) == 0))
+				{
+					return 0;
+				}
+			}
+
+			piter = cc_list_next(piter);
+		}
+	}
+
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	if(argc != 3)
+	{
+		LOGE("usage: %s model.glb model.pcm", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	FILE* fsrc = fopen(argv[1], "r");
+	if(fsrc == NULL)
+	{
+		LOGE("invalid %s", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	fseek(fsrc, 0, SEEK_END);
+	size_t size = (size_t) ftell(fsrc);
+	fseek(fsrc, 0, SEEK_SET);
+
+	gltf_file_t* file = gltf_file_openf(fsrc, size);
+	if(file == NULL)
+	{
+		goto fail_gltf;
+	}
+
+	popcorn_meshc_t self =
+	{
+		.f = fopen(argv[2], "w"),
+	};
+	if(self.f == NULL)
+	{
+		LOGE("invalid %s", argv[2]);
+		goto fail_dst;
+	}
+
+	// the part count is written once known
+	popcorn_meshHeader_t header =
+	{
+		.magic   = POPCORN_MESH_MAGIC,
+		.version = POPCORN_MESH_VERSION,
+	};
+	if(fwrite(&header, sizeof(popcorn_meshHeader_t), 1,
+	          self.f) != 1)
+	{
+		LOGE("fwrite failed");
+		goto fail_write;
+	}
+
+	self.scene = popcorn_scene_new();
+	if(self.scene == NULL)
+	{
+		goto fail_scene;
+	}
+
+	popcorn_gltf_t* loader = popcorn_gltf_new();
+	if(loader == NULL)
+	{
+		goto fail_loader;
+	}
+
+	if(popcorn_meshc_parseFile(&self, loader, file) == 0)
+	{
+		goto fail_parse;
+	}
+
+	header.count = self.count;
+	header.nodes = self.scene->count;
+	if((fseek(self.f, 0, SEEK_SET) != 0) ||
+	   (fwrite(&header, sizeof(popcorn_meshHeader_t), 1,
+	           self.f) != 1))
+	{
+		LOGE("fwrite failed");
+		goto fail_header;
+	}
+
+	self.size_dst += sizeof(popcorn_meshHeader_t) +
+	                 header.nodes*sizeof(popcorn_meshNode_t);
+	LOGI("nodes=%u, parts=%u, src=%u, dst=%u, error_vb=%f, error_nb=%f",
+	     header.nodes, self.count, (uint32_t) self.size_src,
+	     (uint32_t) self.size_dst, self.error_vb, self.error_nb);
+
+	int i;
+	for(i = 0; i < POPCORN_MESH_LODS; ++i)
+	{
+		LOGI("lod=%i, parts=%u, ic=%u, error=%f",
+		     i, self.lod_parts[i], self.lod_ic[i],
+		     self.lod_error[i]);
+	}
+
+	popcorn_gltf_delete(&loader);
+	popcorn_memory_free(self.nodes);
+	popcorn_scene_delete(&self.scene);
+	fclose(self.f);
+	gltf_file_close(&file);
+	fclose(fsrc);
+
+	// success
+	return EXIT_SUCCESS;
+
+	// failure
+	fail_header:
+	fail_parse:
+		popcorn_gltf_delete(&loader);
+	fail_loader:
+		popcorn_memory_free(self.nodes);
+		popcorn_scene_delete(&self.scene);
+	fail_scene:
+	fail_write:
+		fclose(self.f);
+		remove(argv[2]);
+	fail_dst:
+		gltf_file_close(&file);
+	fail_gltf:
+		fclose(fsrc);
+	return EXIT_FAILURE;
+}
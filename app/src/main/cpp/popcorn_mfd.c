@@ -0,0 +1,698 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "texgz/texgz_png.h"
+#include "texgz/texgz_tex.h"
+#include "popcorn_frametime.h"
+#include "popcorn_instrument.h"
+#include "popcorn_memory.h"
+#include "popcorn_mfd.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int
+popcorn_mfd_loadBezel(popcorn_mfd_t* self, pak_file_t* pak)
+{
+	ASSERT(self);
+	ASSERT(pak);
+
+	size_t size = pak_file_seek(pak, "models/screen.png");
+	if(size == 0)
+	{
+		LOGE("pak_file_seek failed");
+		return 0;
+	}
+
+	texgz_tex_t* tex = texgz_png_importf(pak->f, size);
+	if(tex == NULL)
+	{
+		return 0;
+	}
+
+	if(texgz_tex_convert(tex, TEXGZ_UNSIGNED_BYTE,
+	                     TEXGZ_RGBA) == 0)
+	{
+		goto fail_convert;
+	}
+
+	self->bezel = vkk_image_new(self->engine,
+	                            (uint32_t) tex->width,
+	                            (uint32_t) tex->height, 1,
+	                            VKK_IMAGE_FORMAT_RGBA8888, 0,
+	                            VKK_STAGE_FS,
+	                            (const void*) tex->pixels);
+	if(self->bezel == NULL)
+	{
+		goto fail_image;
+	}
+
+	self->size_gpu += 4*((size_t) tex->width)*
+	                  ((size_t) tex->height);
+	texgz_tex_delete(&tex);
+
+	// success
+	return 1;
+
+	// failure
+	fail_image:
+	fail_convert:
+		texgz_tex_delete(&tex);
+	return 0;
+}
+
+static int
+popcorn_mfd_newOffscreen(popcorn_mfd_t* self,
+                         popcorn_shader_t* shader,
+                         popcorn_startup_t* startup)
+{
+	ASSERT(self);
+	ASSERT(shader);
+	ASSERT(startup);
+
+	vkk_engine_t* engine = self->engine;
+
+	// the display is drawn by its own image renderer
+	// outside of the default renderer pass
+	self->rend = vkk_renderer_newImage(engine,
+	                                   POPCORN_MFD_SIZE,
+	                                   POPCORN_MFD_SIZE,
+	                                   VKK_IMAGE_FORMAT_RGBA8888);
+	if(self->rend == NULL)
+	{
+		return 0;
+	}
+
+	vkk_uniformBinding_t ub_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformMfd
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.stage   = VKK_STAGE_FS,
+		},
+		// layout(set=0, binding=1) uniform sampler2D bezel
+		{
+			.binding = 1,
+			.type    = VKK_UNIFORM_TYPE_IMAGE,
+			.stage   = VKK_STAGE_FS,
+			.si      =
+			{
+				.min_filter  = VKK_SAMPLER_FILTER_LINEAR,
+				.mag_filter  = VKK_SAMPLER_FILTER_LINEAR,
+				.mipmap_mode = VKK_SAMPLER_MIPMAP_MODE_NEAREST,
+			},
+		},
+	};
+
+	// image renderers update buffers synchronously
+	self->usf0 = vkk_uniformSetFactory_new(engine,
+	                                       VKK_UPDATE_MODE_SYNCHRONOUS,
+	                                       2, ub_array0);
+	if(self->usf0 == NULL)
+	{
+		goto fail_usf0;
+	}
+
+	self->pl = vkk_pipelineLayout_new(engine, 1, &self->usf0);
+	if(self->pl == NULL)
+	{
+		goto fail_pl;
+	}
+
+	// the fullscreen triangle of sky.vert covers the image
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(shader, "sky.vert", 0);
+	fs = popcorn_shader_lookup(shader, "mfd.frag", 0);
+	if((vs == NULL) || (fs == NULL))
+	{
+		goto fail_gp;
+	}
+
+	vkk_graphicsPipelineInfo_t gpi =
+	{
+		.renderer          = self->rend,
+		.pl                = self->pl,
+		.vs                = vs,
+		.fs                = fs,
+		.vb_count          = 0,
+		.vbi               = NULL,
+		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
+		.primitive_restart = 0,
+		.cull_back         = 0,
+		.depth_test        = 0,
+		.depth_write       = 0,
+		.blend_mode        = VKK_BLEND_MODE_DISABLED
+	};
+
+	popcorn_startup_mark(startup, "mfd.pl");
+
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
+	self->gp = vkk_graphicsPipeline_new(engine, &gpi);
+	if(self->gp == NULL)
+	{
+		goto fail_gp;
+	}
+	popcorn_startup_mark(startup, "mfd.gp");
+
+	self->ub00 = vkk_buffer_new(engine,
+	                            VKK_UPDATE_MODE_SYNCHRONOUS,
+	                            VKK_BUFFER_USAGE_UNIFORM,
+	                            sizeof(popcorn_mfdUniform_t),
+	                            NULL);
+	if(self->ub00 == NULL)
+	{
+		goto fail_ub00;
+	}
+
+	vkk_uniformAttachment_t ua_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformMfd
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.buffer  = self->ub00
+		},
+		// layout(set=0, binding=1) uniform sampler2D bezel
+		{
+			.binding = 1,
+			.type    = VKK_UNIFORM_TYPE_IMAGE,
+			.image   = self->bezel
+		},
+	};
+
+	self->us0 = vkk_uniformSet_new(engine, 0, 2,
+	                               ua_array0,
+	                               self->usf0);
+	if(self->us0 == NULL)
+	{
+		goto fail_us0;
+	}
+
+	self->size_gpu += sizeof(popcorn_mfdUniform_t);
+
+	// success
+	return 1;
+
+	// failure
+	fail_us0:
+		vkk_buffer_delete(&self->ub00);
+	fail_ub00:
+		vkk_graphicsPipeline_delete(&self->gp);
+	fail_gp:
+		vkk_pipelineLayout_delete(&self->pl);
+	fail_pl:
+		vkk_uniformSetFactory_delete(&self->usf0);
+	fail_usf0:
+		vkk_renderer_delete(&self->rend);
+	return 0;
+}
+
+static void popcorn_mfd_deleteOffscreen(popcorn_mfd_t* self)
+{
+	ASSERT(self);
+
+	vkk_uniformSet_delete(&self->us0);
+	vkk_buffer_delete(&self->ub00);
+	vkk_graphicsPipeline_delete(&self->gp);
+	vkk_pipelineLayout_delete(&self->pl);
+	vkk_uniformSetFactory_delete(&self->usf0);
+	vkk_renderer_delete(&self->rend);
+}
+
+static int
+popcorn_mfd_newScreen(popcorn_mfd_t* self,
+                      popcorn_view_t* view,
+                      popcorn_shader_t* shader,
+                      popcorn_startup_t* startup)
+{
+	ASSERT(self);
+	ASSERT(view);
+	ASSERT(shader);
+	ASSERT(startup);
+
+	vkk_engine_t* engine = self->engine;
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(engine);
+
+	vkk_uniformBinding_t ub_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformMvp
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.stage   = VKK_STAGE_VS,
+		},
+		// layout(set=0, binding=1) uniform sampler2D image
+		{
+			.binding = 1,
+			.type    = VKK_UNIFORM_TYPE_IMAGE,
+			.stage   = VKK_STAGE_FS,
+			.si      =
+			{
+				.min_filter  = VKK_SAMPLER_FILTER_LINEAR,
+				.mag_filter  = VKK_SAMPLER_FILTER_LINEAR,
+				.mipmap_mode = VKK_SAMPLER_MIPMAP_MODE_NEAREST,
+			},
+		},
+	};
+
+	self->usf0_screen = vkk_uniformSetFactory_new(engine,
+	                                              VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                              2, ub_array0);
+	if(self->usf0_screen == NULL)
+	{
+		return 0;
+	}
+
+	// the view set is bound by the queue
+	vkk_uniformSetFactory_t* usf_array[] =
+	{
+		self->usf0_screen,
+		view->usf1,
+	};
+
+	self->pl_screen = vkk_pipelineLayout_new(engine,
+	                                         2, usf_array);
+	if(self->pl_screen == NULL)
+	{
+		goto fail_pl;
+	}
+
+	vkk_vertexBufferInfo_t vbi[] =
+	{
+		// layout(location=0) in vec3 vertex;
+		{
+			.location   = 0,
+			.components = 3,
+			.format     = VKK_VERTEX_FORMAT_FLOAT
+		},
+		// layout(location=1) in vec2 uv;
+		{
+			.location   = 1,
+			.components = 2,
+			.format     = VKK_VERTEX_FORMAT_FLOAT
+		},
+	};
+
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(shader, "screen.vert", 0);
+	fs = popcorn_shader_lookup(shader, "screen.frag", 0);
+	if((vs == NULL) || (fs == NULL))
+	{
+		goto fail_gp;
+	}
+
+	vkk_graphicsPipelineInfo_t gpi =
+	{
+		.renderer          = rend,
+		.pl                = self->pl_screen,
+		.vs                = vs,
+		.fs                = fs,
+		.vb_count          = 2,
+		.vbi               = vbi,
+		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
+		.primitive_restart = 0,
+		.cull_back         = 0,
+		.depth_test        = 1,
+		.depth_write       = 1,
+		.blend_mode        = VKK_BLEND_MODE_DISABLED
+	};
+
+	popcorn_startup_mark(startup, "mfd.pl_screen");
+
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
+	self->gp_screen = vkk_graphicsPipeline_new(engine, &gpi);
+	if(self->gp_screen == NULL)
+	{
+		goto fail_gp;
+	}
+	popcorn_startup_mark(startup, "mfd.gp_screen");
+
+	self->ub00_mvp = vkk_buffer_new(engine,
+	                                VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                VKK_BUFFER_USAGE_UNIFORM,
+	                                POPCORN_VIEW_MAX*sizeof(cc_mat4f_t),
+	                                NULL);
+	if(self->ub00_mvp == NULL)
+	{
+		goto fail_ub00;
+	}
+
+	// the quad faces the pilot and the top left corner
+	// samples the first row of the image
+	float x0 = POPCORN_MFD_CENTER_X - POPCORN_MFD_EXTENT;
+	float x1 = POPCORN_MFD_CENTER_X + POPCORN_MFD_EXTENT;
+	float y  = POPCORN_MFD_CENTER_Y;
+	float z0 = POPCORN_MFD_CENTER_Z - POPCORN_MFD_EXTENT;
+	float z1 = POPCORN_MFD_CENTER_Z + POPCORN_MFD_EXTENT;
+	float xyz[] =
+	{
+		x0, y, z1,
+		x0, y, z0,
+		x1, y, z0,
+		x0, y, z1,
+		x1, y, z0,
+		x1, y, z1,
+	};
+
+	float uv[] =
+	{
+		0.0f, 0.0f,
+		0.0f, 1.0f,
+		1.0f, 1.0f,
+		0.0f, 0.0f,
+		1.0f, 1.0f,
+		1.0f, 0.0f,
+	};
+
+	self->vb_xyz = vkk_buffer_new(engine,
+	                              VKK_UPDATE_MODE_STATIC,
+	                              VKK_BUFFER_USAGE_VERTEX,
+	                              sizeof(xyz), xyz);
+	if(self->vb_xyz == NULL)
+	{
+		goto fail_vb_xyz;
+	}
+
+	self->vb_uv = vkk_buffer_new(engine,
+	                             VKK_UPDATE_MODE_STATIC,
+	                             VKK_BUFFER_USAGE_VERTEX,
+	                             sizeof(uv), uv);
+	if(self->vb_uv == NULL)
+	{
+		goto fail_vb_uv;
+	}
+
+	int i;
+	for(i = 0; i < POPCORN_MFD_IMAGES; ++i)
+	{
+		self->image[i] = vkk_image_new(engine,
+		                               POPCORN_MFD_SIZE,
+		                               POPCORN_MFD_SIZE, 1,
+		                               VKK_IMAGE_FORMAT_RGBA8888,
+		                               0, VKK_STAGE_FS, NULL);
+		if(self->image[i] == NULL)
+		{
+			goto fail_image;
+		}
+
+		vkk_uniformAttachment_t ua_array0[] =
+		{
+			// layout(std140, set=0, binding=0) uniform uniformMvp
+			{
+				.binding = 0,
+				.type    = VKK_UNIFORM_TYPE_BUFFER,
+				.buffer  = self->ub00_mvp
+			},
+			// layout(set=0, binding=1) uniform sampler2D image
+			{
+				.binding = 1,
+				.type    = VKK_UNIFORM_TYPE_IMAGE,
+				.image   = self->image[i]
+			},
+		};
+
+		self->us0_screen[i] = vkk_uniformSet_new(engine, 0, 2,
+		                                         ua_array0,
+		                                         self->usf0_screen);
+		if(self->us0_screen[i] == NULL)
+		{
+			goto fail_us0;
+		}
+	}
+
+	self->size_gpu += POPCORN_VIEW_MAX*sizeof(cc_mat4f_t) +
+	                  sizeof(xyz) + sizeof(uv) +
+	                  4*POPCORN_MFD_IMAGES*POPCORN_MFD_SIZE*
+	                  POPCORN_MFD_SIZE;
+
+	// success
+	return 1;
+
+	// failure
+	fail_us0:
+	fail_image:
+	{
+		for(i = 0; i < POPCORN_MFD_IMAGES; ++i)
+		{
+			vkk_uniformSet_delete(&self->us0_screen[i]);
+			vkk_image_delete(&self->image[i]);
+		}
+		vkk_buffer_delete(&self->vb_uv);
+	}
+	fail_vb_uv:
+		vkk_buffer_delete(&self->vb_xyz);
+	fail_vb_xyz:
+		vkk_buffer_delete(&self->ub00_mvp);
+	fail_ub00:
+		vkk_graphicsPipeline_delete(&self->gp_screen);
+	fail_gp:
+		vkk_pipelineLayout_delete(&self->pl_screen);
+	fail_pl:
+		vkk_uniformSetFactory_delete(&self->usf0_screen);
+	return 0;
+}
+
+static void popcorn_mfd_deleteScreen(popcorn_mfd_t* self)
+{
+	ASSERT(self);
+
+	int i;
+	for(i = 0; i < POPCORN_MFD_IMAGES; ++i)
+	{
+		vkk_uniformSet_delete(&self->us0_screen[i]);
+		vkk_image_delete(&self->image[i]);
+	}
+	vkk_buffer_delete(&self->vb_uv);
+	vkk_buffer_delete(&self->vb_xyz);
+	vkk_buffer_delete(&self->ub00_mvp);
+	vkk_graphicsPipeline_delete(&self->gp_screen);
+	vkk_pipelineLayout_delete(&self->pl_screen);
+	vkk_uniformSetFactory_delete(&self->usf0_screen);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_mfd_t* popcorn_mfd_new(vkk_engine_t* engine,
+                               popcorn_view_t* view,
+                               popcorn_shader_t* shader,
+                               pak_file_t* pak,
+                               popcorn_startup_t* startup)
+{
+	ASSERT(engine);
+	ASSERT(view);
+	ASSERT(shader);
+	ASSERT(pak);
+	ASSERT(startup);
+
+	popcorn_mfd_t* self;
+	self = (popcorn_mfd_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_COCKPIT,
+	                             1, sizeof(popcorn_mfd_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->engine = engine;
+
+	if(popcorn_mfd_loadBezel(self, pak) == 0)
+	{
+		goto fail_bezel;
+	}
+
+	if(popcorn_mfd_newOffscreen(self, shader, startup) == 0)
+	{
+		goto fail_offscreen;
+	}
+
+	if(popcorn_mfd_newScreen(self, view, shader, startup) == 0)
+	{
+		goto fail_screen;
+	}
+
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_COCKPIT,
+	                        self->size_gpu);
+
+	// success
+	return self;
+
+	// failure
+	fail_screen:
+		popcorn_mfd_deleteOffscreen(self);
+	fail_offscreen:
+		vkk_image_delete(&self->bezel);
+	fail_bezel:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_mfd_delete(popcorn_mfd_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_mfd_t* self = *_self;
+	if(self)
+	{
+		LOGI("mfd updates=%u, deferred=%u",
+		     self->updates, self->deferred);
+
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_COCKPIT,
+		                       self->size_gpu);
+		popcorn_mfd_deleteScreen(self);
+		popcorn_mfd_deleteOffscreen(self);
+		vkk_image_delete(&self->bezel);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_mfd_pending(popcorn_mfd_t* self)
+{
+	ASSERT(self);
+
+	// an image is waiting to be drawn or the inputs have
+	// changed since the last image
+	if(self->dirty ||
+	   (memcmp(&self->pending, &self->uniform,
+	           sizeof(popcorn_mfdUniform_t)) != 0))
+	{
+		return 1;
+	}
+	return 0;
+}
+
+void popcorn_mfd_update(popcorn_mfd_t* self,
+                        const popcorn_flightState_t* state,
+                        float bearing, float tilt,
+                        double t)
+{
+	ASSERT(self);
+	ASSERT(state);
+
+	// the tilt is measured from world up (-z) so the
+	// pitch is the elevation of the nose above the
+	// horizon and the bank matches the horizon bar
+	float horizon[2];
+	popcorn_instrument_horizon(&state->attitude, horizon);
+	cc_vec4f_load(&self->pending.attitude,
+	              bearing, tilt - 90.0f, horizon[0],
+	              state->speed/POPCORN_FLIGHT_SPEED_MAX);
+
+	if(self->drawn &&
+	   (memcmp(&self->pending, &self->uniform,
+	           sizeof(popcorn_mfdUniform_t)) == 0))
+	{
+		return;
+	}
+
+	// changes are deferred until the next update period
+	if(self->drawn && (t - self->t < 1.0/POPCORN_MFD_RATE))
+	{
+		++self->deferred;
+		return;
+	}
+
+	// draw into the image which is not sampled by the
+	// last frame
+	uint32_t index = (self->index + 1) % POPCORN_MFD_IMAGES;
+	float    clear_color[4] =
+	{
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+	if(vkk_renderer_beginImage(self->rend,
+	                           VKK_RENDERER_MODE_DRAW,
+	                           self->image[index],
+	                           clear_color) == 0)
+	{
+		return;
+	}
+
+	memcpy(&self->uniform, &self->pending,
+	       sizeof(popcorn_mfdUniform_t));
+	vkk_renderer_updateBuffer(self->rend, self->ub00,
+	                          sizeof(popcorn_mfdUniform_t),
+	                          (const void*) &self->uniform);
+	vkk_renderer_bindGraphicsPipeline(self->rend, self->gp);
+	vkk_renderer_bindUniformSets(self->rend, 1, &self->us0);
+	vkk_renderer_draw(self->rend, 3, 0, NULL);
+	vkk_renderer_end(self->rend);
+
+	self->index = index;
+	self->drawn = 1;
+	self->dirty = 1;
+	self->t     = t;
+	++self->updates;
+}
+
+void popcorn_mfd_draw(popcorn_mfd_t* self,
+                      popcorn_queue_t* queue,
+                      popcorn_view_t* view,
+                      const cc_mat4f_t* mvp)
+{
+	ASSERT(self);
+	ASSERT(queue);
+	ASSERT(view);
+	ASSERT(mvp);
+
+	if(self->drawn == 0)
+	{
+		return;
+	}
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(self->engine);
+
+	// the screen samples the last image at the frame rate
+	vkk_renderer_updateBuffer(rend, self->ub00_mvp,
+	                          view->count*sizeof(cc_mat4f_t),
+	                          (const void*) mvp);
+
+	vkk_buffer_t* vb_array[] =
+	{
+		self->vb_xyz,
+		self->vb_uv,
+	};
+
+	float depth = sqrtf(POPCORN_MFD_CENTER_X*POPCORN_MFD_CENTER_X +
+	                    POPCORN_MFD_CENTER_Y*POPCORN_MFD_CENTER_Y +
+	                    POPCORN_MFD_CENTER_Z*POPCORN_MFD_CENTER_Z);
+	popcorn_queue_draw(queue, POPCORN_QUEUE_LAYER_COCKPIT,
+	                   self->gp_screen,
+	                   self->us0_screen[self->index],
+	                   depth, 6, 2, vb_array);
+	self->dirty = 0;
+}
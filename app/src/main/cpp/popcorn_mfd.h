@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_mfd_H
+#define popcorn_mfd_H
+
+#include "libcc/math/cc_mat4f.h"
+#include "libcc/math/cc_vec4f.h"
+#include "libpak/pak_file.h"
+#include "libvkk/vkk.h"
+#include "popcorn_flight.h"
+#include "popcorn_queue.h"
+#include "popcorn_shader.h"
+#include "popcorn_startup.h"
+#include "popcorn_view.h"
+
+// multi-function display
+// the attitude, heading and speed are drawn by mfd.frag
+// over the screen.png bezel into an offscreen image at a
+// fixed rate and the image is sampled by a screen quad in
+// the cockpit so the display does not cost a redraw of
+// the full surface every frame
+// build with -DPOPCORN_MFD_RATE=<hz> to override
+#ifndef POPCORN_MFD_RATE
+#define POPCORN_MFD_RATE 15.0
+#endif
+
+// image size in pixels
+#define POPCORN_MFD_SIZE 256
+
+// the screen alternates between images so an update
+// does not write the image sampled by the last frame
+#define POPCORN_MFD_IMAGES 2
+
+// screen quad in cockpit coordinates (x right,
+// y forward and z up) facing the pilot
+#define POPCORN_MFD_CENTER_X 0.0f
+#define POPCORN_MFD_CENTER_Y 0.45f
+#define POPCORN_MFD_CENTER_Z -0.24f
+#define POPCORN_MFD_EXTENT   0.06f
+
+// see uniformMfd in mfd.frag
+// attitude is the bearing, pitch and bank in degrees and
+// the speed relative to POPCORN_FLIGHT_SPEED_MAX
+typedef struct
+{
+	cc_vec4f_t attitude;
+} popcorn_mfdUniform_t;
+
+typedef struct
+{
+	vkk_engine_t* engine;
+
+	// offscreen pass
+	vkk_renderer_t*          rend;
+	vkk_image_t*             bezel;
+	vkk_uniformSetFactory_t* usf0;
+	vkk_pipelineLayout_t*    pl;
+	vkk_graphicsPipeline_t*  gp;
+	vkk_buffer_t*            ub00;
+	vkk_uniformSet_t*        us0;
+
+	// screen quad
+	vkk_uniformSetFactory_t* usf0_screen;
+	vkk_pipelineLayout_t*    pl_screen;
+	vkk_graphicsPipeline_t*  gp_screen;
+	vkk_buffer_t*            ub00_mvp;
+	vkk_buffer_t*            vb_xyz;
+	vkk_buffer_t*            vb_uv;
+	vkk_image_t*             image[POPCORN_MFD_IMAGES];
+	vkk_uniformSet_t*        us0_screen[POPCORN_MFD_IMAGES];
+
+	// index of the last image drawn
+	uint32_t index;
+
+	// inputs of the last image and the update time
+	// the image is dirty until it is drawn by the screen
+	// and the inputs are pending until they are drawn to
+	// the image
+	int                  drawn;
+	int                  dirty;
+	double               t;
+	popcorn_mfdUniform_t uniform;
+	popcorn_mfdUniform_t pending;
+
+	// statistics
+	size_t   size_gpu;
+	uint32_t updates;
+	uint32_t deferred;
+} popcorn_mfd_t;
+
+popcorn_mfd_t* popcorn_mfd_new(vkk_engine_t* engine,
+                               popcorn_view_t* view,
+                               popcorn_shader_t* shader,
+                               pak_file_t* pak,
+                               popcorn_startup_t* startup);
+void           popcorn_mfd_delete(popcorn_mfd_t** _self);
+int            popcorn_mfd_pending(popcorn_mfd_t* self);
+void           popcorn_mfd_update(popcorn_mfd_t* self,
+                                  const popcorn_flightState_t* state,
+                                  float bearing, float tilt,
+                                  double t);
+void           popcorn_mfd_draw(popcorn_mfd_t* self,
+                                popcorn_queue_t* queue,
+                                popcorn_view_t* view,
+                                const cc_mat4f_t* mvp);
+
+#endif
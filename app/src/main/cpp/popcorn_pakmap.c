@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_pakmap.h"
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_pakmap_t* popcorn_pakmap_new(pak_file_t* pak,
+                                     const char* key)
+{
+	ASSERT(pak);
+	ASSERT(key);
+
+	size_t size = pak_file_seek(pak, key);
+	if(size == 0)
+	{
+		return NULL;
+	}
+
+	// the entry starts at the current position
+	// which is not generally page aligned
+	long offset = ftell(pak->f);
+	long page   = sysconf(_SC_PAGESIZE);
+	int  fd     = fileno(pak->f);
+	if((offset < 0) || (page <= 0) || (fd < 0))
+	{
+		LOGE("invalid offset=%li, page=%li, fd=%i",
+		     offset, page, fd);
+		return NULL;
+	}
+
+	popcorn_pakmap_t* self;
+	self = (popcorn_pakmap_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                             1, sizeof(popcorn_pakmap_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	long aligned = offset - (offset%page);
+	self->length = size + (size_t) (offset - aligned);
+	self->base   = mmap(NULL, self->length, PROT_READ,
+	                    MAP_PRIVATE, fd, (off_t) aligned);
+	if(self->base == MAP_FAILED)
+	{
+		LOGE("mmap failed");
+		goto fail_mmap;
+	}
+
+	// prefetch since the entry is read immediately
+	madvise(self->base, self->length, MADV_WILLNEED);
+
+	self->data = (const char*) self->base + (offset - aligned);
+	self->size = size;
+
+	// success
+	return self;
+
+	// failure
+	fail_mmap:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_pakmap_delete(popcorn_pakmap_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_pakmap_t* self = *_self;
+	if(self)
+	{
+		munmap(self->base, self->length);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_pakmap_H
+#define popcorn_pakmap_H
+
+#include <stddef.h>
+
+#include "libpak/pak_file.h"
+
+// read-only mapping of a pak entry
+// the mapping remains valid after the pak is closed
+// the pak is mapped from the file extracted to the internal
+// path rather than from the APK asset
+typedef struct popcorn_pakmap_s
+{
+	// page aligned mapping
+	void*  base;
+	size_t length;
+
+	// entry
+	const void* data;
+	size_t      size;
+} popcorn_pakmap_t;
+
+popcorn_pakmap_t* popcorn_pakmap_new(pak_file_t* pak,
+                                     const char* key);
+void              popcorn_pakmap_delete(popcorn_pakmap_t** _self);
+
+#endif
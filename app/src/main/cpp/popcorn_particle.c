@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define POPCORN_PARTICLE_NEON
+#endif
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_particle.h"
+
+// arrays of the structure of arrays
+#define POPCORN_PARTICLE_ARRAYS 8
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+typedef struct
+{
+	float damp;
+	float gdt[3];
+} popcorn_particleStep_t;
+
+static void
+popcorn_particle_step(const popcorn_particleForce_t* force,
+                      float dt, popcorn_particleStep_t* step)
+{
+	ASSERT(force);
+	ASSERT(step);
+
+	// the drag is integrated exactly over the step
+	step->damp   = expf(-force->drag*dt);
+	step->gdt[0] = force->g[0]*dt;
+	step->gdt[1] = force->g[1]*dt;
+	step->gdt[2] = force->g[2]*dt;
+}
+
+static void
+popcorn_particle_updateScalar(popcorn_particle_t* self,
+                              const popcorn_particleStep_t* step,
+                              float dt, uint32_t first)
+{
+	ASSERT(self);
+	ASSERT(step);
+
+	uint32_t i;
+	for(i = first; i < self->count; ++i)
+	{
+		float vx = self->vx[i]*step->damp + step->gdt[0];
+		float vy = self->vy[i]*step->damp + step->gdt[1];
+		float vz = self->vz[i]*step->damp + step->gdt[2];
+
+		self->px[i] += vx*dt;
+		self->py[i] += vy*dt;
+		self->pz[i] += vz*dt;
+		self->vx[i]  = vx;
+		self->vy[i]  = vy;
+		self->vz[i]  = vz;
+		self->age[i] += dt;
+	}
+}
+
+#if defined(__SSE2__)
+
+static uint32_t
+popcorn_particle_updateSimd(popcorn_particle_t* self,
+                            const popcorn_particleStep_t* step,
+                            float dt)
+{
+	ASSERT(self);
+	ASSERT(step);
+
+	__m128 damp = _mm_set1_ps(step->damp);
+	__m128 gdtx = _mm_set1_ps(step->gdt[0]);
+	__m128 gdty = _mm_set1_ps(step->gdt[1]);
+	__m128 gdtz = _mm_set1_ps(step->gdt[2]);
+	__m128 vdt  = _mm_set1_ps(dt);
+
+	uint32_t i;
+	for(i = 0; i + 4 <= self->count; i += 4)
+	{
+		__m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&self->vx[i]),
+		                                  damp), gdtx);
+		__m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&self->vy[i]),
+		                                  damp), gdty);
+		__m128 vz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&self->vz[i]),
+		                                  damp), gdtz);
+		_mm_storeu_ps(&self->px[i],
+		              _mm_add_ps(_mm_loadu_ps(&self->px[i]),
+		                         _mm_mul_ps(vx, vdt)));
+		_mm_storeu_ps(&self->py[i],
+		              _mm_add_ps(_mm_loadu_ps(&self->py[i]),
+		                         _mm_mul_ps(vy, vdt)));
+		_mm_storeu_ps(&self->pz[i],
+		              _mm_add_ps(_mm_loadu_ps(&self->pz[i]),
+		                         _mm_mul_ps(vz, vdt)));
+		_mm_storeu_ps(&self->vx[i], vx);
+		_mm_storeu_ps(&self->vy[i], vy);
+		_mm_storeu_ps(&self->vz[i], vz);
+		_mm_storeu_ps(&self->age[i],
+		              _mm_add_ps(_mm_loadu_ps(&self->age[i]), vdt));
+	}
+
+	return i;
+}
+
+#elif defined(POPCORN_PARTICLE_NEON)
+
+static uint32_t
+popcorn_particle_updateSimd(popcorn_particle_t* self,
+                            const popcorn_particleStep_t* step,
+                            float dt)
+{
+	ASSERT(self);
+	ASSERT(step);
+
+	float32x4_t gdtx = vdupq_n_f32(step->gdt[0]);
+	float32x4_t gdty = vdupq_n_f32(step->gdt[1]);
+	float32x4_t gdtz = vdupq_n_f32(step->gdt[2]);
+	float32x4_t vdt  = vdupq_n_f32(dt);
+
+	uint32_t i;
+	for(i = 0; i + 4 <= self->count; i += 4)
+	{
+		float32x4_t vx = vmlaq_n_f32(gdtx, vld1q_f32(&self->vx[i]),
+		                             step->damp);
+		float32x4_t vy = vmlaq_n_f32(gdty, vld1q_f32(&self->vy[i]),
+		                             step->damp);
+		float32x4_t vz = vmlaq_n_f32(gdtz, vld1q_f32(&self->vz[i]),
+		                             step->damp);
+		vst1q_f32(&self->px[i],
+		          vmlaq_n_f32(vld1q_f32(&self->px[i]), vx, dt));
+		vst1q_f32(&self->py[i],
+		          vmlaq_n_f32(vld1q_f32(&self->py[i]), vy, dt));
+		vst1q_f32(&self->pz[i],
+		          vmlaq_n_f32(vld1q_f32(&self->pz[i]), vz, dt));
+		vst1q_f32(&self->vx[i], vx);
+		vst1q_f32(&self->vy[i], vy);
+		vst1q_f32(&self->vz[i], vz);
+		vst1q_f32(&self->age[i],
+		          vaddq_f32(vld1q_f32(&self->age[i]), vdt));
+	}
+
+	return i;
+}
+
+#endif
+
+static void popcorn_particle_expire(popcorn_particle_t* self)
+{
+	ASSERT(self);
+
+	// replace expired particles with the last particle
+	uint32_t i = 0;
+	while(i < self->count)
+	{
+		if(self->age[i] < self->life[i])
+		{
+			++i;
+			continue;
+		}
+
+		uint32_t last = --self->count;
+		self->px[i]   = self->px[last];
+		self->py[i]   = self->py[last];
+		self->pz[i]   = self->pz[last];
+		self->vx[i]   = self->vx[last];
+		self->vy[i]   = self->vy[last];
+		self->vz[i]   = self->vz[last];
+		self->age[i]  = self->age[last];
+		self->life[i] = self->life[last];
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_particle_t* popcorn_particle_new(uint32_t budget)
+{
+	if(budget == 0)
+	{
+		LOGE("invalid budget");
+		return NULL;
+	}
+
+	popcorn_particle_t* self;
+	self = (popcorn_particle_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_PARTICLE,
+	                             1, sizeof(popcorn_particle_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	// the arrays share one allocation
+	float* buf;
+	buf = (float*)
+	      popcorn_memory_calloc(POPCORN_MEMORY_TAG_PARTICLE,
+	                            POPCORN_PARTICLE_ARRAYS*
+	                            ((size_t) budget),
+	                            sizeof(float));
+	if(buf == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_buf;
+	}
+
+	self->budget = budget;
+	self->px     = buf;
+	self->py     = buf + budget;
+	self->pz     = buf + 2*budget;
+	self->vx     = buf + 3*budget;
+	self->vy     = buf + 4*budget;
+	self->vz     = buf + 5*budget;
+	self->age    = buf + 6*budget;
+	self->life   = buf + 7*budget;
+
+	// success
+	return self;
+
+	// failure
+	fail_buf:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_particle_delete(popcorn_particle_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_particle_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->px);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_particle_clear(popcorn_particle_t* self)
+{
+	ASSERT(self);
+
+	self->count = 0;
+}
+
+int popcorn_particle_emit(popcorn_particle_t* self,
+                          const float* p,
+                          const float* v,
+                          float life)
+{
+	ASSERT(self);
+	ASSERT(p);
+	ASSERT(v);
+
+	if(self->count >= self->budget)
+	{
+		++self->dropped;
+		return 0;
+	}
+
+	uint32_t i = self->count++;
+	self->px[i]   = p[0];
+	self->py[i]   = p[1];
+	self->pz[i]   = p[2];
+	self->vx[i]   = v[0];
+	self->vy[i]   = v[1];
+	self->vz[i]   = v[2];
+	self->age[i]  = 0.0f;
+	self->life[i] = life;
+
+	return 1;
+}
+
+void popcorn_particle_update(popcorn_particle_t* self,
+                             const popcorn_particleForce_t* force,
+                             float dt)
+{
+	ASSERT(self);
+	ASSERT(force);
+
+	popcorn_particleStep_t step;
+	popcorn_particle_step(force, dt, &step);
+
+	uint32_t first = 0;
+	#if defined(__SSE2__) || defined(POPCORN_PARTICLE_NEON)
+	first = popcorn_particle_updateSimd(self, &step, dt);
+	#endif
+
+	popcorn_particle_updateScalar(self, &step, dt, first);
+	popcorn_particle_expire(self);
+}
+
+void popcorn_particle_translate(popcorn_particle_t* self,
+                                const float* offset)
+{
+	ASSERT(self);
+	ASSERT(offset);
+
+	uint32_t i;
+	for(i = 0; i < self->count; ++i)
+	{
+		self->px[i] += offset[0];
+		self->py[i] += offset[1];
+		self->pz[i] += offset[2];
+	}
+}
+
+void popcorn_particle_updateRef(popcorn_particle_t* self,
+                                const popcorn_particleForce_t* force,
+                                float dt)
+{
+	ASSERT(self);
+	ASSERT(force);
+
+	popcorn_particleStep_t step;
+	popcorn_particle_step(force, dt, &step);
+	popcorn_particle_updateScalar(self, &step, dt, 0);
+	popcorn_particle_expire(self);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_particle_H
+#define popcorn_particle_H
+
+#include <stdint.h>
+
+// particle pool
+// particles are stored as a structure of arrays so the
+// update kernel advances 4 particles per instruction
+// and expired particles are replaced by the last particle
+// so the live particles remain packed
+
+// default particle budget
+#define POPCORN_PARTICLE_BUDGET 16384
+
+typedef struct
+{
+	uint32_t budget;
+	uint32_t count;
+	uint32_t dropped;
+
+	// structure of arrays
+	float* px;
+	float* py;
+	float* pz;
+	float* vx;
+	float* vy;
+	float* vz;
+	float* age;
+	float* life;
+} popcorn_particle_t;
+
+// the motion of a particle is
+// dv/dt = g - drag*v
+typedef struct
+{
+	float g[3];
+	float drag;
+} popcorn_particleForce_t;
+
+popcorn_particle_t* popcorn_particle_new(uint32_t budget);
+void                popcorn_particle_delete(popcorn_particle_t** _self);
+void                popcorn_particle_clear(popcorn_particle_t* self);
+int                 popcorn_particle_emit(popcorn_particle_t* self,
+                                          const float* p,
+                                          const float* v,
+                                          float life);
+void                popcorn_particle_update(popcorn_particle_t* self,
+                                            const popcorn_particleForce_t* force,
+                                            float dt);
+void                popcorn_particle_translate(popcorn_particle_t* self,
+                                               const float* offset);
+
+// scalar reference kernel
+void popcorn_particle_updateRef(popcorn_particle_t* self,
+                                const popcorn_particleForce_t* force,
+                                float dt);
+
+#endif
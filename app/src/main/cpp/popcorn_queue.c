@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_queue.h"
+
+#define POPCORN_QUEUE_SHIFT_LAYER    60
+#define POPCORN_QUEUE_SHIFT_PIPELINE 52
+#define POPCORN_QUEUE_SHIFT_UNIFORM  40
+#define POPCORN_QUEUE_SHIFT_DEPTH    16
+
+typedef union
+{
+	float    f;
+	uint32_t u;
+} popcorn_queueBits_t;
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static uint32_t
+popcorn_queue_intern(void** table, uint32_t* count,
+                     uint32_t max, void* ptr)
+{
+	ASSERT(table);
+	ASSERT(count);
+	ASSERT(ptr);
+
+	// the tables are small and ids only affect the
+	// order so a full table shares the last id
+	uint32_t i;
+	for(i = 0; i < *count; ++i)
+	{
+		if(table[i] == ptr)
+		{
+			return i;
+		}
+	}
+
+	if(*count == max)
+	{
+		return max - 1;
+	}
+
+	table[*count] = ptr;
+	++(*count);
+	return i;
+}
+
+static uint32_t popcorn_queue_depth(float depth)
+{
+	// non-negative floats sort as their bits so the depth
+	// is the top 24 bits below the sign
+	popcorn_queueBits_t bits = { .f=depth };
+	if((depth > 0.0f) == 0)
+	{
+		// negative or NaN
+		return 0;
+	}
+	return (bits.u >> 7) & 0xFFFFFF;
+}
+
+static popcorn_queuePacket_t*
+popcorn_queue_packet(popcorn_queue_t* self,
+                     popcorn_queueLayer_e layer,
+                     vkk_graphicsPipeline_t* gp,
+                     vkk_uniformSet_t* us0,
+                     float depth)
+{
+	ASSERT(self);
+	ASSERT(layer < POPCORN_QUEUE_LAYER_COUNT);
+	ASSERT(gp);
+	ASSERT(us0);
+
+	if(self->count >= POPCORN_QUEUE_PACKETS)
+	{
+		if(self->dropped == 0)
+		{
+			LOGE("invalid count=%u", self->count);
+		}
+		++self->dropped;
+		return NULL;
+	}
+
+	uint64_t pipeline;
+	uint64_t uniform;
+	pipeline = popcorn_queue_intern((void**) self->pipelines,
+	                                &self->pipeline_count,
+	                                POPCORN_QUEUE_PIPELINES,
+	                                (void*) gp);
+	uniform  = popcorn_queue_intern((void**) self->uniforms,
+	                                &self->uniform_count,
+	                                POPCORN_QUEUE_UNIFORMS,
+	                                (void*) us0);
+
+	uint32_t idx = self->count++;
+	self->keys[idx] =
+		(((uint64_t) layer) << POPCORN_QUEUE_SHIFT_LAYER)   |
+		(pipeline           << POPCORN_QUEUE_SHIFT_PIPELINE) |
+		(uniform            << POPCORN_QUEUE_SHIFT_UNIFORM)  |
+		(((uint64_t) popcorn_queue_depth(depth)) <<
+		 POPCORN_QUEUE_SHIFT_DEPTH) |
+		((uint64_t) idx);
+
+	popcorn_queuePacket_t* packet = &self->packets[idx];
+	packet->gp  = gp;
+	packet->us0 = us0;
+	return packet;
+}
+
+static void popcorn_queue_sort(popcorn_queue_t* self)
+{
+	ASSERT(self);
+
+	// LSD radix sort of the key bytes above the sequence
+	// the sort is stable and packets are recorded in
+	// sequence order so the sequence bytes are skipped
+	// as are bytes which are equal for all packets
+	uint32_t  n   = self->count;
+	uint64_t* src = self->keys;
+	uint64_t* dst = self->keys_tmp;
+	uint32_t  shift;
+	for(shift = POPCORN_QUEUE_SHIFT_DEPTH; shift < 64; shift += 8)
+	{
+		uint32_t hist[256];
+		memset(hist, 0, sizeof(hist));
+
+		uint32_t i;
+		for(i = 0; i < n; ++i)
+		{
+			++hist[(src[i] >> shift) & 0xFF];
+		}
+
+		if(hist[(src[0] >> shift) & 0xFF] == n)
+		{
+			continue;
+		}
+
+		uint32_t sum = 0;
+		for(i = 0; i < 256; ++i)
+		{
+			uint32_t c = hist[i];
+			hist[i] = sum;
+			sum    += c;
+		}
+
+		for(i = 0; i < n; ++i)
+		{
+			dst[hist[(src[i] >> shift) & 0xFF]++] = src[i];
+		}
+
+		uint64_t* tmp = src;
+		src = dst;
+		dst = tmp;
+		++self->radix_passes;
+	}
+
+	if(src != self->keys)
+	{
+		memcpy(self->keys, src, n*sizeof(uint64_t));
+	}
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_queue_t* popcorn_queue_new(void)
+{
+	popcorn_queue_t* self;
+	self = (popcorn_queue_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_QUEUE,
+	                             1, sizeof(popcorn_queue_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->packets = (popcorn_queuePacket_t*)
+	                popcorn_memory_calloc(POPCORN_MEMORY_TAG_QUEUE,
+	                                      POPCORN_QUEUE_PACKETS,
+	                                      sizeof(popcorn_queuePacket_t));
+	if(self->packets == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_packets;
+	}
+
+	self->keys = (uint64_t*)
+	             popcorn_memory_calloc(POPCORN_MEMORY_TAG_QUEUE,
+	                                   2*POPCORN_QUEUE_PACKETS,
+	                                   sizeof(uint64_t));
+	if(self->keys == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_keys;
+	}
+	self->keys_tmp = &self->keys[POPCORN_QUEUE_PACKETS];
+
+	// success
+	return self;
+
+	// failure
+	fail_keys:
+		popcorn_memory_free(self->packets);
+	fail_packets:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_queue_delete(popcorn_queue_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_queue_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->keys);
+		popcorn_memory_free(self->packets);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_queue_begin(popcorn_queue_t* self)
+{
+	ASSERT(self);
+
+	self->count = 0;
+}
+
+int popcorn_queue_draw(popcorn_queue_t* self,
+                       popcorn_queueLayer_e layer,
+                       vkk_graphicsPipeline_t* gp,
+                       vkk_uniformSet_t* us0,
+                       float depth,
+                       uint32_t vertex_count,
+                       uint32_t vb_count,
+                       vkk_buffer_t** vb_array)
+{
+	// vb_array may be NULL when vb_count is 0
+	ASSERT(self);
+	ASSERT(vb_count <= POPCORN_QUEUE_VERTEX_BUFFERS);
+	ASSERT((vb_count == 0) || vb_array);
+
+	popcorn_queuePacket_t* packet;
+	packet = popcorn_queue_packet(self, layer, gp, us0, depth);
+	if(packet == NULL)
+	{
+		return 0;
+	}
+
+	packet->count    = vertex_count;
+	packet->vb_count = vb_count;
+	packet->ib       = NULL;
+	if(vb_count)
+	{
+		memcpy(packet->vb, vb_array, vb_count*sizeof(vkk_buffer_t*));
+	}
+	return 1;
+}
+
+int popcorn_queue_drawIndexed(popcorn_queue_t* self,
+                              popcorn_queueLayer_e layer,
+                              vkk_graphicsPipeline_t* gp,
+                              vkk_uniformSet_t* us0,
+                              float depth,
+                              uint32_t index_count,
+                              uint32_t vb_count,
+                              vkk_buffer_t* ib,
+                              vkk_buffer_t** vb_array)
+{
+	ASSERT(self);
+	ASSERT(vb_count <= POPCORN_QUEUE_VERTEX_BUFFERS);
+	ASSERT(ib);
+	ASSERT(vb_array);
+
+	popcorn_queuePacket_t* packet;
+	packet = popcorn_queue_packet(self, layer, gp, us0, depth);
+	if(packet == NULL)
+	{
+		return 0;
+	}
+
+	packet->count    = index_count;
+	packet->vb_count = vb_count;
+	packet->ib       = ib;
+	memcpy(packet->vb, vb_array, vb_count*sizeof(vkk_buffer_t*));
+	return 1;
+}
+
+void popcorn_queue_submit(popcorn_queue_t* self,
+                          vkk_renderer_t* rend,
+                          popcorn_view_t* view)
+{
+	ASSERT(self);
+	ASSERT(rend);
+	ASSERT(view);
+
+	++self->frames;
+	if(self->count == 0)
+	{
+		return;
+	}
+
+	popcorn_queue_sort(self);
+
+	// the views of each layer share the sorted packets
+	uint32_t first = 0;
+	while(first < self->count)
+	{
+		uint64_t layer = self->keys[first] >>
+		                 POPCORN_QUEUE_SHIFT_LAYER;
+		uint32_t last  = first + 1;
+		while((last < self->count) &&
+		      ((self->keys[last] >> POPCORN_QUEUE_SHIFT_LAYER) ==
+		       layer))
+		{
+			++last;
+		}
+
+		if(layer == POPCORN_QUEUE_LAYER_COCKPIT)
+		{
+			vkk_renderer_clearDepth(rend);
+		}
+
+		vkk_graphicsPipeline_t* gp  = NULL;
+		vkk_uniformSet_t*       us0 = NULL;
+
+		uint32_t v;
+		for(v = 0; v < view->count; ++v)
+		{
+			popcorn_view_viewport(view, v, rend);
+
+			// the view uniform set changed
+			us0 = NULL;
+
+			uint32_t i;
+			for(i = first; i < last; ++i)
+			{
+				popcorn_queuePacket_t* packet;
+				packet = &self->packets[self->keys[i] & 0xFFFF];
+
+				// pipelines may have different layouts so
+				// binding a pipeline also rebinds the sets
+				if(packet->gp != gp)
+				{
+					vkk_renderer_bindGraphicsPipeline(rend,
+					                                  packet->gp);
+					gp  = packet->gp;
+					us0 = NULL;
+					++self->pipeline_binds;
+				}
+				else
+				{
+					++self->pipeline_avoided;
+				}
+
+				if(packet->us0 != us0)
+				{
+					vkk_uniformSet_t* us_array[] =
+					{
+						packet->us0,
+						view->us1[v],
+					};
+					vkk_renderer_bindUniformSets(rend, 2, us_array);
+					us0 = packet->us0;
+					++self->uniform_binds;
+				}
+				else
+				{
+					++self->uniform_avoided;
+				}
+
+				if(packet->ib)
+				{
+					vkk_renderer_drawIndexed(rend, packet->count,
+					                         packet->vb_count,
+					                         VKK_INDEX_TYPE_USHORT,
+					                         packet->ib,
+					                         packet->vb);
+				}
+				else
+				{
+					vkk_renderer_draw(rend, packet->count,
+					                  packet->vb_count,
+					                  packet->vb);
+				}
+				++self->draws;
+			}
+		}
+
+		first = last;
+	}
+}
+
+void popcorn_queue_report(popcorn_queue_t* self)
+{
+	ASSERT(self);
+
+	// avoided binds are the binds of a naive submission
+	// which binds the state of every draw
+	LOGI("frames=%u, draws=%u, radix_passes=%u, dropped=%u",
+	     self->frames, (uint32_t) self->draws,
+	     (uint32_t) self->radix_passes, self->dropped);
+	LOGI("pipeline_binds=%u, pipeline_avoided=%u",
+	     (uint32_t) self->pipeline_binds,
+	     (uint32_t) self->pipeline_avoided);
+	LOGI("uniform_binds=%u, uniform_avoided=%u",
+	     (uint32_t) self->uniform_binds,
+	     (uint32_t) self->uniform_avoided);
+}
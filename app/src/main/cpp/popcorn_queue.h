@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_queue_H
+#define popcorn_queue_H
+
+#include <stdint.h>
+
+#include "libvkk/vkk.h"
+#include "popcorn_view.h"
+
+// draw queue
+// draws are recorded as packets and radix sorted by a
+// 64-bit key before submission so that consecutive
+// packets share state and opaque packets are drawn front
+// to back within a state
+//
+// key layout (msb to lsb)
+// layer:    4 bits
+// pipeline: 8 bits
+// uniform:  12 bits
+// depth:    24 bits
+// sequence: 16 bits
+// the sequence is the packet index
+#define POPCORN_QUEUE_PACKETS   1024
+#define POPCORN_QUEUE_PIPELINES 256
+#define POPCORN_QUEUE_UNIFORMS  4096
+
+// the vertex buffers of a packet are copied
+#define POPCORN_QUEUE_VERTEX_BUFFERS 3
+
+// layers are drawn in order and the cockpit layer is
+// drawn over the world so its depth is cleared first
+// the background layer is drawn behind the world and the
+// effects layer is blended over the opaque world
+typedef enum
+{
+	POPCORN_QUEUE_LAYER_BACKGROUND = 0,
+	POPCORN_QUEUE_LAYER_WORLD      = 1,
+	POPCORN_QUEUE_LAYER_EFFECTS    = 2,
+	POPCORN_QUEUE_LAYER_COCKPIT    = 3,
+} popcorn_queueLayer_e;
+
+#define POPCORN_QUEUE_LAYER_COUNT 4
+
+// packets bind the uniform sets {us0, view->us1[v]}
+typedef struct
+{
+	vkk_graphicsPipeline_t* gp;
+	vkk_uniformSet_t*       us0;
+	uint32_t                count;
+	uint32_t                vb_count;
+	vkk_buffer_t*           ib;
+	vkk_buffer_t*           vb[POPCORN_QUEUE_VERTEX_BUFFERS];
+} popcorn_queuePacket_t;
+
+typedef struct
+{
+	// packets and the sort buffers are preallocated so
+	// the frame loop does not allocate
+	uint32_t               count;
+	popcorn_queuePacket_t* packets;
+	uint64_t*              keys;
+	uint64_t*              keys_tmp;
+	uint32_t               dropped;
+
+	// state ids for the sort key
+	// ids are assigned on first use and never reused
+	uint32_t                pipeline_count;
+	uint32_t                uniform_count;
+	vkk_graphicsPipeline_t* pipelines[POPCORN_QUEUE_PIPELINES];
+	vkk_uniformSet_t*       uniforms[POPCORN_QUEUE_UNIFORMS];
+
+	// statistics
+	uint32_t frames;
+	uint64_t draws;
+	uint64_t pipeline_binds;
+	uint64_t pipeline_avoided;
+	uint64_t uniform_binds;
+	uint64_t uniform_avoided;
+	uint64_t radix_passes;
+} popcorn_queue_t;
+
+popcorn_queue_t* popcorn_queue_new(void);
+void             popcorn_queue_delete(popcorn_queue_t** _self);
+void             popcorn_queue_begin(popcorn_queue_t* self);
+int              popcorn_queue_draw(popcorn_queue_t* self,
+                                    popcorn_queueLayer_e layer,
+                                    vkk_graphicsPipeline_t* gp,
+                                    vkk_uniformSet_t* us0,
+                                    float depth,
+                                    uint32_t vertex_count,
+                                    uint32_t vb_count,
+                                    vkk_buffer_t** vb_array);
+int              popcorn_queue_drawIndexed(popcorn_queue_t* self,
+                                           popcorn_queueLayer_e layer,
+                                           vkk_graphicsPipeline_t* gp,
+                                           vkk_uniformSet_t* us0,
+                                           float depth,
+                                           uint32_t index_count,
+                                           uint32_t vb_count,
+                                           vkk_buffer_t* ib,
+                                           vkk_buffer_t** vb_array);
+void             popcorn_queue_submit(popcorn_queue_t* self,
+                                      vkk_renderer_t* rend,
+                                      popcorn_view_t* view);
+void             popcorn_queue_report(popcorn_queue_t* self);
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_recorder.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+typedef union
+{
+	float    f;
+	uint32_t u;
+} popcorn_recorderBits_t;
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_recorder_t* popcorn_recorder_new(double rate)
+{
+	popcorn_recorder_t* self;
+	self = (popcorn_recorder_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RECORDER,
+	                             1, sizeof(popcorn_recorder_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	// the ring is allocated up front so
+	// recording never allocates
+	self->records = (popcorn_recorderRecord_t*)
+	                popcorn_memory_calloc(POPCORN_MEMORY_TAG_RECORDER,
+	                                      POPCORN_RECORDER_CAPACITY,
+	                                      sizeof(popcorn_recorderRecord_t));
+	if(self->records == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_records;
+	}
+
+	self->rate = rate;
+
+	popcorn_recorderBits_t zero = { .f=0.0f };
+	atomic_init(&self->frame_ms, zero.u);
+
+	// success
+	return self;
+
+	// failure
+	fail_records:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_recorder_delete(popcorn_recorder_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_recorder_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->records);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_recorder_frame(popcorn_recorder_t* self,
+                            float frame_ms)
+{
+	ASSERT(self);
+
+	popcorn_recorderBits_t bits = { .f=frame_ms };
+	atomic_store_explicit(&self->frame_ms, bits.u,
+	                      memory_order_relaxed);
+}
+
+popcorn_recorderRecord_t*
+popcorn_recorder_next(popcorn_recorder_t* self)
+{
+	ASSERT(self);
+
+	// overwrite the oldest record when the ring is full
+	popcorn_recorderRecord_t* record;
+	record = &self->records[self->count % POPCORN_RECORDER_CAPACITY];
+	++self->count;
+
+	popcorn_recorderBits_t bits;
+	bits.u = atomic_load_explicit(&self->frame_ms,
+	                              memory_order_relaxed);
+	record->frame_ms = bits.f;
+
+	return record;
+}
+
+int popcorn_recorder_save(popcorn_recorder_t* self,
+                          const char* fname)
+{
+	ASSERT(self);
+	ASSERT(fname);
+
+	uint32_t count = self->count;
+	uint32_t first = 0;
+	if(count > POPCORN_RECORDER_CAPACITY)
+	{
+		first = count % POPCORN_RECORDER_CAPACITY;
+		count = POPCORN_RECORDER_CAPACITY;
+	}
+
+	FILE* f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("invalid %s", fname);
+		return 0;
+	}
+
+	popcorn_recorderHeader_t header =
+	{
+		.magic       = POPCORN_RECORDER_MAGIC,
+		.version     = POPCORN_RECORDER_VERSION,
+		.record_size = sizeof(popcorn_recorderRecord_t),
+		.count       = count,
+		.rate        = self->rate,
+	};
+
+	if(fwrite(&header, sizeof(popcorn_recorderHeader_t),
+	          1, f) != 1)
+	{
+		LOGE("fwrite failed");
+		goto fail_write;
+	}
+
+	// write the ring in tick order
+	uint32_t n1 = count - first;
+	if(fwrite(&self->records[first],
+	          sizeof(popcorn_recorderRecord_t), n1, f) != n1)
+	{
+		LOGE("fwrite failed");
+		goto fail_write;
+	}
+
+	if(first && (fwrite(self->records,
+	                    sizeof(popcorn_recorderRecord_t),
+	                    first, f) != first))
+	{
+		LOGE("fwrite failed");
+		goto fail_write;
+	}
+
+	fclose(f);
+
+	LOGI("fname=%s, count=%u", fname, count);
+
+	// success
+	return 1;
+
+	// failure
+	fail_write:
+		fclose(f);
+	return 0;
+}
+
+int popcorn_recorder_csv(const char* src, const char* dst)
+{
+	ASSERT(src);
+	ASSERT(dst);
+
+	FILE* fsrc = fopen(src, "r");
+	if(fsrc == NULL)
+	{
+		LOGE("invalid %s", src);
+		return 0;
+	}
+
+	popcorn_recorderHeader_t header;
+	if(fread(&header, sizeof(popcorn_recorderHeader_t),
+	         1, fsrc) != 1)
+	{
+		LOGE("fread failed");
+		goto fail_header;
+	}
+
+	if((header.magic       != POPCORN_RECORDER_MAGIC)   ||
+	   (header.version     != POPCORN_RECORDER_VERSION) ||
+	   (header.record_size != sizeof(popcorn_recorderRecord_t)))
+	{
+		LOGE("invalid magic=0x%X, version=%u, record_size=%u",
+		     header.magic, header.version, header.record_size);
+		goto fail_header;
+	}
+
+	FILE* fdst = fopen(dst, "w");
+	if(fdst == NULL)
+	{
+		LOGE("invalid %s", dst);
+		goto fail_dst;
+	}
+
+	fprintf(fdst, "t,tick,reset,contact,"
+	              "qx,qy,qz,qs,x,y,z,speed,acceleration,"
+	              "roll,pitch,yaw1,yaw2,rx,ry,"
+	              "frame_ms,tick_ms\n");
+
+	uint32_t i;
+	for(i = 0; i < header.count; ++i)
+	{
+		popcorn_recorderRecord_t r;
+		if(fread(&r, sizeof(popcorn_recorderRecord_t),
+		         1, fsrc) != 1)
+		{
+			LOGE("fread failed");
+			goto fail_record;
+		}
+
+		fprintf(fdst, "%lf,%u,%u,%u,"
+		              "%f,%f,%f,%f,%f,%f,%f,%f,%f,"
+		              "%f,%f,%f,%f,%f,%f,"
+		              "%f,%f\n",
+		        r.t, r.tick,
+		        (r.flags & POPCORN_RECORDER_FLAG_RESET)   ? 1 : 0,
+		        (r.flags & POPCORN_RECORDER_FLAG_CONTACT) ? 1 : 0,
+		        r.attitude[0], r.attitude[1],
+		        r.attitude[2], r.attitude[3],
+		        r.position[0], r.position[1], r.position[2],
+		        r.speed, r.acceleration,
+		        r.inputs[0], r.inputs[1], r.inputs[2],
+		        r.inputs[3], r.inputs[4], r.inputs[5],
+		        r.frame_ms, r.tick_ms);
+	}
+
+	fclose(fdst);
+	fclose(fsrc);
+
+	// success
+	return 1;
+
+	// failure
+	fail_record:
+		fclose(fdst);
+	fail_dst:
+	fail_header:
+		fclose(fsrc);
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_recorder_H
+#define popcorn_recorder_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// flight data recorder file
+// header followed by count records in tick order
+#define POPCORN_RECORDER_MAGIC   0x52444650 // "PFDR"
+#define POPCORN_RECORDER_VERSION 2
+
+// ring capacity in ticks (10 minutes at 60 Hz)
+#define POPCORN_RECORDER_CAPACITY 36000
+
+#define POPCORN_RECORDER_FLAG_RESET   0x1
+#define POPCORN_RECORDER_FLAG_CONTACT 0x2
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t count;
+	double   rate;
+} popcorn_recorderHeader_t;
+
+typedef struct
+{
+	double   t;
+	uint32_t tick;
+	uint32_t flags;
+
+	// world position in double precision
+	// see POPCORN_FLIGHT_CELL
+	double position[3];
+
+	// attitude quaternion (x,y,z,s)
+	float attitude[4];
+	float speed;
+	float acceleration;
+
+	// roll, pitch, yaw1, yaw2, rx, ry
+	float inputs[6];
+
+	// most recent render frame time and
+	// the time spent simulating the tick
+	float frame_ms;
+	float tick_ms;
+} popcorn_recorderRecord_t;
+
+typedef struct popcorn_recorder_s
+{
+	double rate;
+
+	// written by the render thread
+	atomic_uint frame_ms;
+
+	// written by the simulation thread
+	uint32_t                  count;
+	popcorn_recorderRecord_t* records;
+} popcorn_recorder_t;
+
+popcorn_recorder_t* popcorn_recorder_new(double rate);
+void                popcorn_recorder_delete(popcorn_recorder_t** _self);
+void                popcorn_recorder_frame(popcorn_recorder_t* self,
+                                           float frame_ms);
+popcorn_recorderRecord_t*
+                    popcorn_recorder_next(popcorn_recorder_t* self);
+int                 popcorn_recorder_save(popcorn_recorder_t* self,
+                                          const char* fname);
+int                 popcorn_recorder_csv(const char* src,
+                                         const char* dst);
+
+#endif
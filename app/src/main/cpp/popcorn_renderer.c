@@ -25,17 +25,46 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define LOG_TAG "popcorn"
 #include "libcc/math/cc_mat4f.h"
 #include "libcc/math/cc_vec2f.h"
+#include "libcc/math/cc_vec3f.h"
 #include "libcc/math/cc_vec4f.h"
 #include "libcc/cc_log.h"
-#include "libcc/cc_memory.h"
 #include "libcc/cc_timestamp.h"
 #include "libvkk/vkk_platform.h"
 #include "popcorn_cockpit.h"
+#include "popcorn_collision.h"
+#include "popcorn_contrail.h"
+#include "popcorn_frametime.h"
+#include "popcorn_graph.h"
+#include "popcorn_input.h"
+#include "popcorn_memory.h"
+#include "popcorn_queue.h"
+#include "popcorn_recorder.h"
 #include "popcorn_renderer.h"
+#include "popcorn_shader.h"
+#include "popcorn_sim.h"
+#include "popcorn_sky.h"
+#include "popcorn_startup.h"
+
+// cell size of the collision spatial hash
+#define POPCORN_RENDERER_CELL_SIZE 0.25f
+
+// frames before the memory steady state is enforced
+#define POPCORN_RENDERER_WARMUP 60
+
+// unchanged frames drawn before frames are skipped
+// build with -DPOPCORN_RENDERER_CONTINUOUS to draw every frame
+#define POPCORN_RENDERER_STILL 2
+
+// particle budget of the contrails
+// build with -DPOPCORN_RENDERER_PARTICLES=<count> to override
+#ifndef POPCORN_RENDERER_PARTICLES
+#define POPCORN_RENDERER_PARTICLES POPCORN_PARTICLE_BUDGET
+#endif
 
 /***********************************************************
 * private                                                  *
@@ -72,8 +101,14 @@ popcorn_renderer_newPipelineLayout(popcorn_renderer_t* self)
 {
 	ASSERT(self);
 
+	vkk_uniformSetFactory_t* usf_array[] =
+	{
+		self->usf0,
+		self->view->usf1,
+	};
+
 	self->pl = vkk_pipelineLayout_new(self->engine,
-	                                  1, &self->usf0);
+	                                  2, usf_array);
 	if(self->pl == NULL)
 	{
 		return 0;
@@ -112,12 +147,21 @@ popcorn_renderer_newGraphicsPipeline(popcorn_renderer_t* self)
 		},
 	};
 
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(self->shader, "cube.vert", 0);
+	fs = popcorn_shader_lookup(self->shader, "cube.frag", 0);
+	if((vs == NULL) || (fs == NULL))
+	{
+		return 0;
+	}
+
 	vkk_graphicsPipelineInfo_t gpi =
 	{
 		.renderer          = rend,
 		.pl                = self->pl,
-		.vs                = "shaders/cube_vert.spv",
-		.fs                = "shaders/cube_frag.spv",
+		.vs                = vs,
+		.fs                = fs,
 		.vb_count          = 3,
 		.vbi               = vbi,
 		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
@@ -128,6 +172,7 @@ popcorn_renderer_newGraphicsPipeline(popcorn_renderer_t* self)
 		.blend_mode        = 0
 	};
 
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
 	self->gp = vkk_graphicsPipeline_new(self->engine,
 	                                    &gpi);
 	if(self->gp == NULL)
@@ -158,6 +203,28 @@ popcorn_renderer_keyPress(popcorn_renderer_t* self,
 			self->escape_t0 = t1;
 		}
 	}
+	else if(keycode == 'g')
+	{
+		atomic_fetch_xor(&self->graph_visible, 1);
+	}
+}
+
+static void popcorn_renderer_startup(popcorn_renderer_t* self)
+{
+	ASSERT(self);
+
+	if(self->startup == NULL)
+	{
+		return;
+	}
+
+	popcorn_cockpit_startup(self->cockpit, self->startup);
+
+	char fname[256];
+	snprintf(fname, 256, "%s/startup.json",
+	         vkk_engine_internalPath(self->engine));
+	popcorn_startup_report(self->startup, fname);
+	popcorn_startup_delete(&self->startup);
 }
 
 static void
@@ -175,7 +242,7 @@ popcorn_renderer_vpn(popcorn_renderer_t* self,
 	                0.0f, 0.0f, 0.0f,
 	                1.0f, 0.0f, 0.0f,
 	                0.0f, 0.0f, -1.0f);
-	cc_mat4f_rotateq(&mvm, 0, &self->attitude);
+	cc_mat4f_rotateq(&mvm, 0, &self->state.attitude);
 
 	// vpn is the negative z-axis of the
 	// rotation matrix
@@ -209,58 +276,53 @@ popcorn_renderer_spherical(popcorn_renderer_t* self,
 	*_tilt    = (180.0f/M_PI)*tilt;
 }
 
-static void
-popcorn_renderer_reset(popcorn_renderer_t* self)
+static int
+popcorn_renderer_changed(popcorn_renderer_t* self,
+                         uint32_t width, uint32_t height)
 {
 	ASSERT(self);
 
-	self->speed        = 0.0f;
-	self->acceleration = 0.0f;
-	cc_vec3f_load(&self->position, 0.0f, 0.0f, 0.0f);
-	cc_quaternion_identity(&self->attitude);
+	// the frame depends on the view, the position, the
+	// instrument inputs, the live particles, the cockpit
+	// parts waiting to stream and the display
+	popcorn_flightState_t* a = &self->state;
+	popcorn_flightState_t* b = &self->drawn;
+	if(atomic_exchange(&self->dirty, 0) ||
+	   atomic_load(&self->graph_visible) ||
+	   popcorn_contrail_active(self->contrail) ||
+	   popcorn_cockpit_pending(self->cockpit)  ||
+	   (width  != self->drawn_width)  ||
+	   (height != self->drawn_height) ||
+	   (a->resets       != b->resets)       ||
+	   (a->rx           != b->rx)           ||
+	   (a->ry           != b->ry)           ||
+	   (a->roll         != b->roll)         ||
+	   (a->pitch        != b->pitch)        ||
+	   (a->acceleration != b->acceleration) ||
+	   (a->speed        != b->speed)        ||
+	   (memcmp(&a->attitude, &b->attitude,
+	           sizeof(cc_quaternion_t)) != 0) ||
+	   (memcmp(a->sector, b->sector,
+	           sizeof(a->sector)) != 0) ||
+	   (memcmp(&a->position, &b->position,
+	           sizeof(cc_vec3f_t)) != 0))
+	{
+		self->still = 0;
+		return 1;
+	}
+
+	// draw a few unchanged frames so every presented
+	// image shows the final state
+	++self->still;
+	return (self->still <= POPCORN_RENDERER_STILL);
 }
 
-static void
-popcorn_renderer_resetSpherical(popcorn_renderer_t* self,
-                                float bearing, float tilt)
+static void popcorn_renderer_sleep(double dt)
 {
-	ASSERT(self);
-
-	self->speed        = 0.0f;
-	self->acceleration = 0.0f;
-	cc_vec3f_load(&self->position, 0.0f, 0.0f, 0.0f);
-
-	// remap orientation
-	// see the principle axes of an aircraft
-	// https://en.wikipedia.org/wiki/Euler_angles
-	cc_mat4f_t mvm; // model-view-matrix
-	cc_mat4f_lookat(&mvm, 1,
-	                0.0f, 0.0f, 0.0f,
-	                1.0f, 0.0f, 0.0f,
-	                0.0f, 0.0f, -1.0f);
-	cc_mat4f_transpose(&mvm);
-
-	// convert to radians
-	bearing *= (M_PI/180.0f);
-	tilt    *= (M_PI/180.0f);
-
-	cc_vec4f_t vpn =
-	{
-		.x = cos(bearing)*sin(tilt),
-		.y = sin(bearing)*sin(tilt),
-		.z = cos(tilt),
-	};
-	cc_vec4f_t up =
-	{
-		.x = 0.0f,
-		.y = 0.0f,
-		.z = 1.0f,
-	};
-	cc_mat4f_lookat(&mvm, 0,
-	                0.0f,  0.0f,  0.0f,
-	                vpn.x, vpn.y, vpn.z,
-	                up.x,  up.y,  up.z);
-	cc_mat4f_quaternion(&mvm, &self->attitude);
+	struct timespec ts;
+	ts.tv_sec  = (time_t) dt;
+	ts.tv_nsec = (long) (1.0e9*(dt - (double) ts.tv_sec));
+	nanosleep(&ts, NULL);
 }
 
 /***********************************************************
@@ -274,7 +336,8 @@ popcorn_renderer_new(vkk_engine_t* engine)
 
 	popcorn_renderer_t* self;
 	self = (popcorn_renderer_t*)
-	       CALLOC(1, sizeof(popcorn_renderer_t));
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_renderer_t));
 	if(self == NULL)
 	{
 		LOGE("CALLOC failed");
@@ -284,23 +347,57 @@ popcorn_renderer_new(vkk_engine_t* engine)
 	self->engine    = engine;
 	self->escape_t0 = cc_timestamp();
 
-	// attitude quaternion must be initialized
-	popcorn_renderer_reset(self);
+	// time each phase of startup
+	popcorn_startup_t* startup = popcorn_startup_new();
+	if(startup == NULL)
+	{
+		goto fail_startup;
+	}
+
+	self->input = popcorn_input_new();
+	if(self->input == NULL)
+	{
+		goto fail_input;
+	}
+	popcorn_startup_mark(startup, "input");
+
+	char resource[256];
+	snprintf(resource, 256, "%s/resource.pak",
+	         vkk_engine_internalPath(engine));
+
+	self->shader = popcorn_shader_new(resource);
+	if(self->shader == NULL)
+	{
+		goto fail_shader;
+	}
+	popcorn_startup_mark(startup, "shader");
+
+	// stereo views are enabled by POPCORN_STEREO=1
+	const char* stereo = getenv("POPCORN_STEREO");
+	self->view = popcorn_view_new(engine,
+	                              stereo && (stereo[0] == '1'));
+	if(self->view == NULL)
+	{
+		goto fail_view;
+	}
 
 	if(popcorn_renderer_newUniformSetFactory(self) == 0)
 	{
 		goto fail_usf;
 	}
+	popcorn_startup_mark(startup, "renderer.usf");
 
 	if(popcorn_renderer_newPipelineLayout(self) == 0)
 	{
 		goto fail_pl;
 	}
+	popcorn_startup_mark(startup, "renderer.pl");
 
 	if(popcorn_renderer_newGraphicsPipeline(self) == 0)
 	{
 		goto fail_gp;
 	}
+	popcorn_startup_mark(startup, "renderer.gp");
 
 	const cc_vec4f_t A = { .x=-1.0f, .y= 1.0f, .z= 1.0f, .w=1.0f };
 	const cc_vec4f_t B = { .x=-1.0f, .y=-1.0f, .z= 1.0f, .w=1.0f };
@@ -353,7 +450,8 @@ popcorn_renderer_new(vkk_engine_t* engine)
 	self->ub00_mvp = vkk_buffer_new(engine,
 	                                VKK_UPDATE_MODE_ASYNCHRONOUS,
 	                                VKK_BUFFER_USAGE_UNIFORM,
-	                                sizeof(cc_mat4f_t), NULL);
+	                                POPCORN_VIEW_MAX*sizeof(cc_mat4f_t),
+	                                NULL);
 	if(self->ub00_mvp == NULL)
 	{
 		goto fail_ub00_mvp;
@@ -388,6 +486,7 @@ popcorn_renderer_new(vkk_engine_t* engine)
 	{
 		goto fail_vb_rgba;
 	}
+	popcorn_startup_mark(startup, "renderer.buffers");
 
 	vkk_uniformAttachment_t ua_array0[] =
 	{
@@ -406,19 +505,117 @@ popcorn_renderer_new(vkk_engine_t* engine)
 	{
 		goto fail_us0_mvp;
 	}
+	popcorn_startup_mark(startup, "renderer.us");
 
-	self->cockpit = popcorn_cockpit_new(engine);
+	self->collision = popcorn_collision_new(POPCORN_RENDERER_CELL_SIZE);
+	if(self->collision == NULL)
+	{
+		goto fail_collision;
+	}
+
+	// the cube is the only world mesh
+	if(popcorn_collision_addMesh(self->collision, 0, NULL,
+	                             36, 4, (const float*) xyzw,
+	                             0, NULL) == 0)
+	{
+		goto fail_mesh;
+	}
+	popcorn_startup_mark(startup, "collision");
+
+	self->cockpit = popcorn_cockpit_new(engine, self->view,
+	                                    self->shader, startup);
 	if(self->cockpit == NULL)
 	{
 		LOGE("invalid cockpit");
 		goto fail_cockpit;
 	}
 
+	self->frametime = popcorn_frametime_new();
+	if(self->frametime == NULL)
+	{
+		goto fail_frametime;
+	}
+
+	self->graph = popcorn_graph_new(engine, self->shader,
+	                                startup);
+	if(self->graph == NULL)
+	{
+		goto fail_graph;
+	}
+	popcorn_startup_mark(startup, "graph");
+
+	self->queue = popcorn_queue_new();
+	if(self->queue == NULL)
+	{
+		goto fail_queue;
+	}
+
+	self->sky = popcorn_sky_new(engine, self->view, self->shader,
+	                            startup);
+	if(self->sky == NULL)
+	{
+		goto fail_sky;
+	}
+	popcorn_startup_mark(startup, "sky");
+
+	self->contrail = popcorn_contrail_new(engine, self->view,
+	                                      self->shader,
+	                                      POPCORN_RENDERER_PARTICLES,
+	                                      startup);
+	if(self->contrail == NULL)
+	{
+		goto fail_contrail;
+	}
+	popcorn_startup_mark(startup, "contrail");
+
+	self->recorder = popcorn_recorder_new(POPCORN_SIM_RATE);
+	if(self->recorder == NULL)
+	{
+		goto fail_recorder;
+	}
+	popcorn_startup_mark(startup, "recorder");
+
+	// the simulation starts once the scene is ready
+	self->sim = popcorn_sim_new(self->input, self->collision,
+	                            self->recorder);
+	if(self->sim == NULL)
+	{
+		goto fail_sim;
+	}
+	popcorn_sim_snapshot(self->sim, cc_timestamp(),
+	                     &self->state);
+	self->frame_t0 = cc_timestamp();
+	popcorn_startup_mark(startup, "sim");
+
+	self->startup = startup;
+
+	self->size_gpu = POPCORN_VIEW_MAX*sizeof(cc_mat4f_t) +
+	                 sizeof(xyzw) + sizeof(uv) + sizeof(rgba);
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_RENDERER,
+	                        self->size_gpu);
+
 	// success
 	return self;
 
 	// failure
+	fail_sim:
+		popcorn_recorder_delete(&self->recorder);
+	fail_recorder:
+		popcorn_contrail_delete(&self->contrail);
+	fail_contrail:
+		popcorn_sky_delete(&self->sky);
+	fail_sky:
+		popcorn_queue_delete(&self->queue);
+	fail_queue:
+		popcorn_graph_delete(&self->graph);
+	fail_graph:
+		popcorn_frametime_delete(&self->frametime);
+	fail_frametime:
+		popcorn_cockpit_delete(&self->cockpit);
 	fail_cockpit:
+	fail_mesh:
+		popcorn_collision_delete(&self->collision);
+	fail_collision:
 		vkk_uniformSet_delete(&self->us0_mvp);
 	fail_us0_mvp:
 		vkk_buffer_delete(&self->vb_rgba);
@@ -435,7 +632,15 @@ popcorn_renderer_new(vkk_engine_t* engine)
 	fail_pl:
 		vkk_uniformSetFactory_delete(&self->usf0);
 	fail_usf:
-		FREE(self);
+		popcorn_view_delete(&self->view);
+	fail_view:
+		popcorn_shader_delete(&self->shader);
+	fail_shader:
+		popcorn_input_delete(&self->input);
+	fail_input:
+		popcorn_startup_delete(&startup);
+	fail_startup:
+		popcorn_memory_free(self);
 	return NULL;
 }
 
@@ -447,8 +652,35 @@ void popcorn_renderer_delete(popcorn_renderer_t** _self)
 	popcorn_renderer_t* self = *_self;
 	if(self)
 	{
+		popcorn_memory_steady(0);
+		popcorn_renderer_startup(self);
+		popcorn_sim_delete(&self->sim);
+		LOGI("frames=%u, skipped=%u",
+		     self->frames, self->skipped);
+
+		// save the flight once the simulation has stopped
+		char fname[256];
+		snprintf(fname, 256, "%s/popcorn.fdr",
+		         vkk_engine_internalPath(self->engine));
+		popcorn_recorder_save(self->recorder, fname);
+		popcorn_recorder_delete(&self->recorder);
+
+		// summarize the frame times and hitches
+		snprintf(fname, 256, "%s/frametime.json",
+		         vkk_engine_internalPath(self->engine));
+		popcorn_frametime_report(self->frametime, fname);
+		popcorn_contrail_delete(&self->contrail);
+		popcorn_sky_delete(&self->sky);
+		popcorn_queue_report(self->queue);
+		popcorn_queue_delete(&self->queue);
+		popcorn_graph_delete(&self->graph);
+		popcorn_frametime_delete(&self->frametime);
+
 		popcorn_cockpit_delete(&self->cockpit);
+		popcorn_collision_delete(&self->collision);
 		vkk_uniformSet_delete(&self->us0_mvp);
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_RENDERER,
+		                       self->size_gpu);
 		vkk_buffer_delete(&self->vb_rgba);
 		vkk_buffer_delete(&self->vb_uv);
 		vkk_buffer_delete(&self->vb_xyzw);
@@ -456,11 +688,26 @@ void popcorn_renderer_delete(popcorn_renderer_t** _self)
 		vkk_graphicsPipeline_delete(&self->gp);
 		vkk_pipelineLayout_delete(&self->pl);
 		vkk_uniformSetFactory_delete(&self->usf0);
-		FREE(self);
+		popcorn_view_delete(&self->view);
+		popcorn_shader_delete(&self->shader);
+		popcorn_input_delete(&self->input);
+		popcorn_memory_free(self);
 		*_self = NULL;
+
+		// remaining live bytes are leaks
+		popcorn_memory_report();
 	}
 }
 
+void popcorn_renderer_pause(popcorn_renderer_t* self)
+{
+	ASSERT(self);
+
+	// the simulation is resumed by the next draw
+	popcorn_sim_pause(self->sim, 1);
+	self->paused = 1;
+}
+
 void popcorn_renderer_draw(popcorn_renderer_t* self)
 {
 	ASSERT(self);
@@ -468,6 +715,43 @@ void popcorn_renderer_draw(popcorn_renderer_t* self)
 	vkk_renderer_t* rend;
 	rend = vkk_engine_defaultRenderer(self->engine);
 
+	if(self->paused)
+	{
+		popcorn_sim_pause(self->sim, 0);
+		atomic_store(&self->dirty, 1);
+		self->paused = 0;
+	}
+
+	// the render thread only reads the simulation state
+	uint32_t width;
+	uint32_t height;
+	double   t = cc_timestamp();
+	vkk_renderer_surfaceSize(rend, &width, &height);
+	popcorn_sim_snapshot(self->sim, t, &self->state);
+
+	// particles are emitted along the interpolated path
+	popcorn_contrail_update(self->contrail, &self->state, t);
+
+	// the display is redrawn at its own rate and a new
+	// image is presented by the next frame
+	float bearing;
+	float tilt;
+	popcorn_renderer_spherical(self, &bearing, &tilt);
+	popcorn_cockpit_update(self->cockpit, &self->state,
+	                       bearing, tilt, t);
+
+	#ifndef POPCORN_RENDERER_CONTINUOUS
+	// the presented image remains on screen so a static
+	// scene only polls the simulation once per tick
+	if(popcorn_renderer_changed(self, width, height) == 0)
+	{
+		++self->skipped;
+		popcorn_renderer_sleep(1.0/POPCORN_SIM_RATE);
+		self->frame_t0 = cc_timestamp();
+		return;
+	}
+	#endif
+
 	float clear_color[4] =
 	{
 		0.0f, 0.0f, 0.0f, 1.0f
@@ -479,15 +763,11 @@ void popcorn_renderer_draw(popcorn_renderer_t* self)
 		return;
 	}
 
-	uint32_t width;
-	uint32_t height;
-	vkk_renderer_surfaceSize(rend, &width, &height);
-
-	// perspective projection
+	// perspective projection of each view
 	float      w      = (float) width;
 	float      h      = (float) height;
-	float      fovy   = (h > w) ? 60.0f : 45.0f;
-	float      aspect = w/h;
+	float      aspect = popcorn_view_layout(self->view, width, height);
+	float      fovy   = (aspect < 1.0f) ? 60.0f : 45.0f;
 	float      near   = 0.001f;
 	float      far    = 1000.0f;
 	cc_mat4f_t pm;
@@ -495,84 +775,71 @@ void popcorn_renderer_draw(popcorn_renderer_t* self)
 	                     fovy, aspect,
 	                     near, far);
 
+	float ms = (float) (1000.0*(t - self->frame_t0));
+	popcorn_recorder_frame(self->recorder, ms);
+	popcorn_frametime_frame(self->frametime, ms);
+	self->frame_t0 = t;
+
 	// remap orientation
 	// see the principle axes of an aircraft
 	// https://en.wikipedia.org/wiki/Euler_angles
 	cc_mat4f_t mvm; // model-view-matrix
-	cc_mat4f_t mnm; // model-normal-matrix
 	cc_mat4f_lookat(&mvm, 1,
 	                0.0f, 0.0f, 0.0f,
 	                1.0f, 0.0f, 0.0f,
 	                0.0f, 0.0f, -1.0f);
-	cc_mat4f_copy(&mvm, &mnm);
 
 	// head rotation
-	float rx = -90.0f*self->rx;
-	float ry = 30.0f*self->ry;
+	float rx = -90.0f*self->state.rx;
+	float ry = 30.0f*self->state.ry;
 	cc_mat4f_rotate(&mvm, 0, rx, 0.0f, 0.0f, 1.0f);
 	cc_mat4f_rotate(&mvm, 0, ry, 0.0f, 1.0f, 0.0f);
 
-	// compute the attitude change
-	float rate  = 45.0f/60.0f;
-	float yaw   = rate*(self->yaw1 - self->yaw2);
-	float pitch = -rate*self->pitch;
-	float roll  = -rate*self->roll;
-	cc_quaternion_t q;
-	cc_quaternion_loadeuler(&q, roll, pitch, yaw);
-
-	// update attitude
-	// post multiply the current attitude
-	// Flight Simulators and Quaternions
-	// https://flylib.com/books/en/2.208.1.130/1/
-	cc_quaternion_rotateq(&q, &self->attitude);
-	cc_quaternion_copy(&q, &self->attitude);
-
 	// attitude rotation
-	cc_mat4f_rotateq(&mvm, 0, &self->attitude);
-	cc_mat4f_rotateq(&mnm, 0, &self->attitude);
-
-	// compute direction
-	cc_vec3f_t direction;
-	cc_vec3f_load(&direction, -mnm.m20, -mnm.m21, -mnm.m22);
-
-	// update speed
-	self->speed += 0.0001f*self->acceleration;
-	if(self->speed < 0.0f)
-	{
-		self->speed = 0.0f;
-	}
-	else if(self->speed > 0.005f)
-	{
-		self->speed = 0.005f;
+	cc_mat4f_rotateq(&mvm, 0, &self->state.attitude);
+
+	// the sky only depends on the rotation
+	cc_mat4f_t rvm;
+	cc_mat4f_copy(&mvm, &rvm);
+
+	// floating origin
+	// objects are translated relative to the eye in double
+	// precision so the shaders only see small floats
+	// the position is relative to the sector of the aircraft
+	// and objects in the sector such as the contrails use
+	// the sector relative mvm
+	double eye[3];
+	popcorn_flight_world(&self->state, eye);
+	cc_mat4f_translate(&mvm, 0,
+	                   -self->state.position.x,
+	                   -self->state.position.y,
+	                   -self->state.position.z);
+
+	// the cube is centered at the world origin
+	cc_mat4f_t cvm;
+	cc_mat4f_copy(&rvm, &cvm);
+	cc_mat4f_translate(&cvm, 0,
+	                   (float) -eye[0],
+	                   (float) -eye[1],
+	                   (float) -eye[2]);
+
+	// finalize the mvp of each view
+	cc_mat4f_t mvp[POPCORN_VIEW_MAX];
+	cc_mat4f_t cube_mvp[POPCORN_VIEW_MAX];
+	uint32_t   v;
+	for(v = 0; v < self->view->count; ++v)
+	{
+		popcorn_view_mvp(self->view, v, &pm, &mvm, &mvp[v]);
+		popcorn_view_mvp(self->view, v, &pm, &cvm, &cube_mvp[v]);
 	}
 
-	// update position
-	cc_vec3f_t velocity;
-	cc_vec3f_muls_copy(&direction, self->speed, &velocity);
-	cc_vec3f_addv(&self->position, &velocity);
-	if((self->position.x < -1.0f) ||
-	   (self->position.x >  1.0f) ||
-	   (self->position.y < -1.0f) ||
-	   (self->position.y >  1.0f) ||
-	   (self->position.z < -1.0f) ||
-	   (self->position.z >  1.0f))
-	{
-		// reset on collision
-		popcorn_renderer_reset(self);
-	}
-	cc_mat4f_translate(&mvm, 0, -self->position.x,
-	                   -self->position.y, -self->position.z);
+	// the queue is sorted by state and front to back
+	popcorn_queue_begin(self->queue);
 
-	// finalize mvp
-	cc_mat4f_t mvp;
-	cc_mat4f_mulm_copy(&pm, &mvm, &mvp);
+	// draw sky and ground
+	popcorn_sky_draw(self->sky, self->queue, &pm, &rvm, eye);
 
 	// draw cube
-	vkk_uniformSet_t* us_array[] =
-	{
-		self->us0_mvp,
-	};
-
 	vkk_buffer_t* vb_array[] =
 	{
 		self->vb_xyzw,
@@ -580,17 +847,50 @@ void popcorn_renderer_draw(popcorn_renderer_t* self)
 		self->vb_rgba,
 	};
 
-	vkk_renderer_bindGraphicsPipeline(rend, self->gp);
+	float depth = (float) sqrt(eye[0]*eye[0] + eye[1]*eye[1] +
+	                           eye[2]*eye[2]);
 	vkk_renderer_updateBuffer(rend, self->ub00_mvp,
-	                          sizeof(cc_mat4f_t),
-	                          (const void*) &mvp);
-	vkk_renderer_bindUniformSets(rend, 1, us_array);
-	vkk_renderer_draw(rend, 36, 3, vb_array);
+	                          sizeof(cube_mvp),
+	                          (const void*) cube_mvp);
+	popcorn_queue_draw(self->queue, POPCORN_QUEUE_LAYER_WORLD,
+	                   self->gp, self->us0_mvp, depth,
+	                   36, 3, vb_array);
+
+	// draw contrails
+	popcorn_contrail_draw(self->contrail, self->queue, self->view,
+	                      &mvm, mvp);
 
 	// draw cockpit
-	popcorn_cockpit_draw(self->cockpit, fovy, aspect, rx, ry);
+	popcorn_cockpit_draw(self->cockpit, self->queue, self->view,
+	                     &self->state, fovy, aspect, rx, ry);
+
+	popcorn_queue_submit(self->queue, rend, self->view);
+
+	// the graph covers the whole surface
+	if(atomic_load(&self->graph_visible))
+	{
+		vkk_renderer_viewport(rend, 0.0f, 0.0f, w, h);
+		vkk_renderer_scissor(rend, 0, 0, width, height);
+		popcorn_graph_draw(self->graph, self->frametime, w, h);
+	}
 
 	vkk_renderer_end(rend);
+
+	memcpy(&self->drawn, &self->state, sizeof(popcorn_flightState_t));
+	self->drawn_width  = width;
+	self->drawn_height = height;
+
+	// the frame loop must not allocate once warmed up
+	if(popcorn_memory_frame())
+	{
+		popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_ALLOC);
+	}
+	++self->frames;
+	if(self->frames == POPCORN_RENDERER_WARMUP)
+	{
+		popcorn_renderer_startup(self);
+		popcorn_memory_steady(1);
+	}
 }
 
 void popcorn_renderer_event(popcorn_renderer_t* self,
@@ -599,6 +899,13 @@ void popcorn_renderer_event(popcorn_renderer_t* self,
 	ASSERT(self);
 	ASSERT(event);
 
+	// events are counted to detect bursts and
+	// wake on-demand rendering
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_EVENTS);
+	atomic_store(&self->dirty, 1);
+
+	// the event thread is the producer for the input queue
+	// and the flight state is only modified by the consumer
 	if((event->type == VKK_EVENT_TYPE_KEY_UP) ||
 	   ((event->type == VKK_EVENT_TYPE_KEY_DOWN) &&
 	    (event->key.repeat)))
@@ -613,57 +920,69 @@ void popcorn_renderer_event(popcorn_renderer_t* self,
 
 		if(e->axis == VKK_AXIS_X1)
 		{
-			self->roll = e->value;
+			popcorn_input_axis(self->input,
+			                   POPCORN_INPUT_AXIS_ROLL,
+			                   e->value);
 		}
 		else if(e->axis == VKK_AXIS_Y1)
 		{
-			self->pitch = e->value;
+			popcorn_input_axis(self->input,
+			                   POPCORN_INPUT_AXIS_PITCH,
+			                   e->value);
 		}
 		else if(e->axis == VKK_AXIS_X2)
 		{
-			self->rx = e->value;
+			popcorn_input_axis(self->input,
+			                   POPCORN_INPUT_AXIS_HEAD_X,
+			                   e->value);
 		}
 		else if(e->axis == VKK_AXIS_Y2)
 		{
-			self->ry = e->value;
+			popcorn_input_axis(self->input,
+			                   POPCORN_INPUT_AXIS_HEAD_Y,
+			                   e->value);
 		}
 		else if(e->axis == VKK_AXIS_LT)
 		{
-			self->yaw1 = e->value;
+			popcorn_input_axis(self->input,
+			                   POPCORN_INPUT_AXIS_YAW1,
+			                   e->value);
 		}
 		else if(e->axis == VKK_AXIS_RT)
 		{
-			self->yaw2 = e->value;
+			popcorn_input_axis(self->input,
+			                   POPCORN_INPUT_AXIS_YAW2,
+			                   e->value);
 		}
 	}
-	else if(event->type == VKK_EVENT_TYPE_BUTTON_UP)
+	else if((event->type == VKK_EVENT_TYPE_BUTTON_UP) ||
+	        (event->type == VKK_EVENT_TYPE_BUTTON_DOWN))
 	{
 		vkk_eventButton_t* e = &event->button;
 
+		double ts   = cc_timestamp();
+		int    down = (event->type == VKK_EVENT_TYPE_BUTTON_DOWN);
 		if(e->button == VKK_BUTTON_A)
 		{
-			self->acceleration += 1.0f;
+			popcorn_input_button(self->input,
+			                     POPCORN_INPUT_BUTTON_BRAKE,
+			                     down, ts);
 		}
 		else if(e->button == VKK_BUTTON_B)
 		{
-			self->acceleration -= 1.0f;
+			popcorn_input_button(self->input,
+			                     POPCORN_INPUT_BUTTON_THRUST,
+			                     down, ts);
 		}
 		else if(e->button == VKK_BUTTON_X)
 		{
-			popcorn_renderer_reset(self);
+			popcorn_input_button(self->input,
+			                     POPCORN_INPUT_BUTTON_RESET,
+			                     down, ts);
 		}
-	}
-	else if(event->type == VKK_EVENT_TYPE_BUTTON_DOWN)
-	{
-		vkk_eventButton_t* e = &event->button;
-
-		if(e->button == VKK_BUTTON_A)
-		{
-			self->acceleration -= 1.0f;
-		}
-		else if(e->button == VKK_BUTTON_B)
+		else if((e->button == VKK_BUTTON_Y) && (down == 0))
 		{
-			self->acceleration += 1.0f;
+			atomic_fetch_xor(&self->graph_visible, 1);
 		}
 	}
 }
@@ -24,11 +24,23 @@
 #ifndef popcorn_renderer_H
 #define popcorn_renderer_H
 
-#include "libcc/math/cc_quaternion.h"
-#include "libcc/math/cc_vec3f.h"
+#include <stdatomic.h>
+
 #include "libvkk/vkk_platform.h"
 #include "libvkk/vkk.h"
 #include "popcorn_cockpit.h"
+#include "popcorn_collision.h"
+#include "popcorn_contrail.h"
+#include "popcorn_frametime.h"
+#include "popcorn_graph.h"
+#include "popcorn_input.h"
+#include "popcorn_queue.h"
+#include "popcorn_recorder.h"
+#include "popcorn_shader.h"
+#include "popcorn_sim.h"
+#include "popcorn_sky.h"
+#include "popcorn_startup.h"
+#include "popcorn_view.h"
 
 /***********************************************************
 * public                                                   *
@@ -37,6 +49,8 @@
 typedef struct popcorn_renderer_s
 {
 	vkk_engine_t*            engine;
+	popcorn_shader_t*        shader;
+	popcorn_view_t*          view;
 	vkk_uniformSetFactory_t* usf0;
 	vkk_pipelineLayout_t*    pl;
 	vkk_graphicsPipeline_t*  gp;
@@ -48,22 +62,58 @@ typedef struct popcorn_renderer_s
 
 	vkk_uniformSet_t* us0_mvp;
 
+	// gpu memory of the buffers above
+	size_t size_gpu;
+
 	// escape state
 	double escape_t0;
 
-	// rotation state
-	float           yaw1;
-	float           yaw2;
-	float           pitch;
-	float           roll;
-	float           rx;
-	float           ry;
-	cc_quaternion_t attitude;
+	// input queue
+	popcorn_input_t* input;
+
+	// collision
+	popcorn_collision_t* collision;
+
+	// flight data recorder
+	popcorn_recorder_t* recorder;
+	double              frame_t0;
+
+	// frames drawn for memory accounting
+	uint32_t frames;
+
+	// the startup report is written after the warmup
+	// frames since they upload the cockpit parts
+	popcorn_startup_t* startup;
+
+	// on-demand rendering
+	// frames are skipped while the drawn view and
+	// instruments are unchanged and no event arrived
+	atomic_int            dirty;
+	int                   paused;
+	uint32_t              still;
+	uint32_t              skipped;
+	uint32_t              drawn_width;
+	uint32_t              drawn_height;
+	popcorn_flightState_t drawn;
+
+	// sorted draw queue
+	popcorn_queue_t* queue;
+
+	// sky and ground
+	popcorn_sky_t* sky;
+
+	// contrails and exhaust
+	popcorn_contrail_t* contrail;
+
+	// frame time histogram and graph
+	// graph_visible is toggled by the event thread
+	popcorn_frametime_t* frametime;
+	popcorn_graph_t*     graph;
+	atomic_int           graph_visible;
 
-	// position
-	float      acceleration;
-	float      speed;
-	cc_vec3f_t position;
+	// simulation and the interpolated state
+	popcorn_sim_t*        sim;
+	popcorn_flightState_t state;
 
 	// cockpit
 	popcorn_cockpit_t* cockpit;
@@ -71,6 +121,7 @@ typedef struct popcorn_renderer_s
 
 popcorn_renderer_t* popcorn_renderer_new(vkk_engine_t* engine);
 void                popcorn_renderer_delete(popcorn_renderer_t** _self);
+void                popcorn_renderer_pause(popcorn_renderer_t* self);
 void                popcorn_renderer_draw(popcorn_renderer_t* self);
 void                popcorn_renderer_event(popcorn_renderer_t* self,
                                            vkk_event_t* event);
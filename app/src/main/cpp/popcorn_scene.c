@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_scene.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int
+popcorn_scene_resize(void** _buf, size_t elem, uint32_t size)
+{
+	ASSERT(_buf);
+
+	void* buf;
+	buf = popcorn_memory_realloc(POPCORN_MEMORY_TAG_SCENE,
+	                             *_buf, elem*size);
+	if(buf == NULL)
+	{
+		LOGE("REALLOC failed");
+		return 0;
+	}
+
+	*_buf = buf;
+	return 1;
+}
+
+static int popcorn_scene_grow(popcorn_scene_t* self)
+{
+	ASSERT(self);
+
+	if(self->count < self->size)
+	{
+		return 1;
+	}
+
+	uint32_t size = self->size ? 2*self->size : 16;
+	if((popcorn_scene_resize((void**) &self->parent,
+	                         sizeof(int32_t), size) == 0) ||
+	   (popcorn_scene_resize((void**) &self->end,
+	                         sizeof(uint32_t), size) == 0) ||
+	   (popcorn_scene_resize((void**) &self->local,
+	                         sizeof(cc_mat4f_t), size) == 0) ||
+	   (popcorn_scene_resize((void**) &self->world,
+	                         sizeof(cc_mat4f_t), size) == 0) ||
+	   (popcorn_scene_resize((void**) &self->dirty,
+	                         sizeof(uint8_t), size) == 0) ||
+	   (popcorn_scene_resize((void**) &self->dirty_list,
+	                         sizeof(uint32_t), size) == 0))
+	{
+		return 0;
+	}
+
+	self->size = size;
+	return 1;
+}
+
+static void
+popcorn_scene_mark(popcorn_scene_t* self, uint32_t node)
+{
+	ASSERT(self);
+
+	if(self->dirty[node] == 0)
+	{
+		self->dirty[node] = 1;
+		self->dirty_list[self->dirty_count++] = node;
+	}
+}
+
+static int popcorn_scene_cmp(const void* a, const void* b)
+{
+	ASSERT(a);
+	ASSERT(b);
+
+	uint32_t na = *((const uint32_t*) a);
+	uint32_t nb = *((const uint32_t*) b);
+	return (na > nb) - (na < nb);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_scene_t* popcorn_scene_new(void)
+{
+	popcorn_scene_t* self;
+	self = (popcorn_scene_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_SCENE,
+	                             1, sizeof(popcorn_scene_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	return self;
+}
+
+void popcorn_scene_delete(popcorn_scene_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_scene_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->dirty_list);
+		popcorn_memory_free(self->dirty);
+		popcorn_memory_free(self->world);
+		popcorn_memory_free(self->local);
+		popcorn_memory_free(self->end);
+		popcorn_memory_free(self->parent);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_scene_add(popcorn_scene_t* self, int32_t parent,
+                      const cc_mat4f_t* local)
+{
+	ASSERT(self);
+	ASSERT(local);
+
+	// nodes must be added in preorder so the parent
+	// subtree must end at the new node
+	if((parent != POPCORN_SCENE_ROOT) &&
+	   ((parent < 0) || ((uint32_t) parent >= self->count) ||
+	    (self->end[parent] != self->count)))
+	{
+		LOGE("invalid parent=%i, count=%u",
+		     parent, self->count);
+		return -1;
+	}
+
+	if(popcorn_scene_grow(self) == 0)
+	{
+		return -1;
+	}
+
+	uint32_t node = self->count++;
+	self->parent[node] = parent;
+	self->end[node]    = node + 1;
+	self->dirty[node]  = 0;
+	cc_mat4f_copy(local, &self->local[node]);
+	cc_mat4f_identity(&self->world[node]);
+
+	// extend the ancestor subtrees
+	while(parent != POPCORN_SCENE_ROOT)
+	{
+		self->end[parent] = node + 1;
+		parent = self->parent[parent];
+	}
+
+	popcorn_scene_mark(self, node);
+
+	return (int) node;
+}
+
+void popcorn_scene_setLocal(popcorn_scene_t* self,
+                            uint32_t node,
+                            const cc_mat4f_t* local)
+{
+	ASSERT(self);
+	ASSERT(node < self->count);
+	ASSERT(local);
+
+	cc_mat4f_copy(local, &self->local[node]);
+	popcorn_scene_mark(self, node);
+}
+
+uint32_t popcorn_scene_update(popcorn_scene_t* self)
+{
+	ASSERT(self);
+
+	self->updated = 0;
+	if(self->dirty_count == 0)
+	{
+		return 0;
+	}
+
+	// sort the dirty nodes so a dirty descendant is
+	// skipped when its ancestor subtree is recomputed
+	qsort(self->dirty_list, self->dirty_count,
+	      sizeof(uint32_t), popcorn_scene_cmp);
+
+	uint32_t i;
+	uint32_t n;
+	uint32_t covered = 0;
+	for(i = 0; i < self->dirty_count; ++i)
+	{
+		uint32_t node = self->dirty_list[i];
+		self->dirty[node] = 0;
+		if(node < covered)
+		{
+			continue;
+		}
+
+		// parents precede children in preorder
+		covered = self->end[node];
+		for(n = node; n < covered; ++n)
+		{
+			int32_t p = self->parent[n];
+			if(p == POPCORN_SCENE_ROOT)
+			{
+				cc_mat4f_copy(&self->local[n], &self->world[n]);
+			}
+			else
+			{
+				cc_mat4f_mulm_copy(&self->world[p],
+				                   &self->local[n],
+				                   &self->world[n]);
+			}
+		}
+		self->updated += covered - node;
+	}
+	self->dirty_count = 0;
+
+	return self->updated;
+}
+
+const cc_mat4f_t*
+popcorn_scene_world(popcorn_scene_t* self, uint32_t node)
+{
+	ASSERT(self);
+	ASSERT(node < self->count);
+
+	return &self->world[node];
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_scene_H
+#define popcorn_scene_H
+
+#include <stdint.h>
+
+#include "libcc/math/cc_mat4f.h"
+
+// flattened scene graph
+// nodes are stored in depth-first preorder so a subtree
+// is the contiguous range [node, end[node]) and a parent
+// always precedes its children
+#define POPCORN_SCENE_ROOT -1
+
+typedef struct
+{
+	uint32_t    count;
+	uint32_t    size;
+	int32_t*    parent;
+	uint32_t*   end;
+	cc_mat4f_t* local;
+	cc_mat4f_t* world;
+
+	// nodes whose local transform changed since the
+	// last update
+	uint8_t*  dirty;
+	uint32_t  dirty_count;
+	uint32_t* dirty_list;
+
+	// nodes recomputed by the last update
+	uint32_t updated;
+} popcorn_scene_t;
+
+popcorn_scene_t*  popcorn_scene_new(void);
+void              popcorn_scene_delete(popcorn_scene_t** _self);
+int               popcorn_scene_add(popcorn_scene_t* self,
+                                    int32_t parent,
+                                    const cc_mat4f_t* local);
+void              popcorn_scene_setLocal(popcorn_scene_t* self,
+                                         uint32_t node,
+                                         const cc_mat4f_t* local);
+uint32_t          popcorn_scene_update(popcorn_scene_t* self);
+const cc_mat4f_t* popcorn_scene_world(popcorn_scene_t* self,
+                                      uint32_t node);
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libpak/pak_file.h"
+#include "popcorn_memory.h"
+#include "popcorn_shader.h"
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+typedef struct
+{
+	const char* define;
+	uint32_t    feature;
+} popcorn_shaderDefine_t;
+
+static const popcorn_shaderDefine_t POPCORN_SHADER_DEFINES[] =
+{
+	{ "LIGHTING", POPCORN_SHADER_FEATURE_LIGHTING },
+	{ NULL,       0                               },
+};
+
+static int
+popcorn_shader_parseLine(popcorn_shader_t* self, char* line)
+{
+	ASSERT(self);
+	ASSERT(line);
+
+	// <src> <path> [DEFINE ...]
+	char* save = NULL;
+	char* src  = strtok_r(line, " \t\r", &save);
+	if(src == NULL)
+	{
+		// ignore empty lines
+		return 1;
+	}
+
+	char* path = strtok_r(NULL, " \t\r", &save);
+	if(path == NULL)
+	{
+		LOGE("invalid src=%s", src);
+		return 0;
+	}
+
+	uint32_t features = 0;
+	char*    define   = strtok_r(NULL, " \t\r", &save);
+	while(define)
+	{
+		const popcorn_shaderDefine_t* d = POPCORN_SHADER_DEFINES;
+		while(d->define)
+		{
+			if(strcmp(d->define, define) == 0)
+			{
+				break;
+			}
+			++d;
+		}
+
+		if(d->define == NULL)
+		{
+			LOGE("invalid define=%s", define);
+			return 0;
+		}
+
+		features |= d->feature;
+		define    = strtok_r(NULL, " \t\r", &save);
+	}
+
+	if(self->count >= POPCORN_SHADER_VARIANTS)
+	{
+		LOGE("invalid count=%u", self->count);
+		return 0;
+	}
+
+	popcorn_shaderVariant_t* variant = &self->variant[self->count];
+	snprintf(variant->src,  32, "%s", src);
+	snprintf(variant->path, 64, "%s", path);
+	variant->features = features;
+	++self->count;
+
+	return 1;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_shader_t* popcorn_shader_new(const char* resource)
+{
+	ASSERT(resource);
+
+	popcorn_shader_t* self;
+	self = (popcorn_shader_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_shader_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	pak_file_t* pak;
+	pak = pak_file_open(resource, PAK_FLAG_READ);
+	if(pak == NULL)
+	{
+		goto fail_open;
+	}
+
+	size_t size;
+	// the index is missing when the pak predates the
+	// shader variants and must be rebuilt
+	size = pak_file_seek(pak, POPCORN_SHADER_INDEX);
+	if(size == 0)
+	{
+		LOGE("invalid %s: missing %s, run build-resource.sh",
+		     resource, POPCORN_SHADER_INDEX);
+		goto fail_seek;
+	}
+
+	char* buf;
+	buf = (char*)
+	      popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                            1, size + 1);
+	if(buf == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_buf;
+	}
+
+	if(fread((void*) buf, size, 1, pak->f) != 1)
+	{
+		LOGE("fread failed");
+		goto fail_read;
+	}
+
+	char* save = NULL;
+	char* line = strtok_r(buf, "\n", &save);
+	while(line)
+	{
+		if(popcorn_shader_parseLine(self, line) == 0)
+		{
+			goto fail_parse;
+		}
+		line = strtok_r(NULL, "\n", &save);
+	}
+
+	popcorn_memory_free(buf);
+	pak_file_close(&pak);
+
+	LOGI("variants=%u", self->count);
+
+	// success
+	return self;
+
+	// failure
+	fail_parse:
+	fail_read:
+		popcorn_memory_free(buf);
+	fail_buf:
+	fail_seek:
+		pak_file_close(&pak);
+	fail_open:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_shader_delete(popcorn_shader_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_shader_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+const char* popcorn_shader_lookup(popcorn_shader_t* self,
+                                  const char* src,
+                                  uint32_t features)
+{
+	ASSERT(self);
+	ASSERT(src);
+
+	uint32_t i;
+	for(i = 0; i < self->count; ++i)
+	{
+		popcorn_shaderVariant_t* variant = &self->variant[i];
+		if((variant->features == features) &&
+		   (strcmp(variant->src, src) == 0))
+		{
+			return variant->path;
+		}
+	}
+
+	LOGE("invalid src=%s, features=0x%X", src, features);
+	return NULL;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_shader_H
+#define popcorn_shader_H
+
+#include <stdint.h>
+
+// shader variant index
+// see resource/shaders/variants.txt
+#define POPCORN_SHADER_INDEX "shaders/variants.idx"
+
+// maximum number of variants in the index
+#define POPCORN_SHADER_VARIANTS 64
+
+// features select a variant by the defines
+// used to compile the shader
+#define POPCORN_SHADER_FEATURE_LIGHTING 0x1
+
+typedef struct
+{
+	char     src[32];
+	char     path[64];
+	uint32_t features;
+} popcorn_shaderVariant_t;
+
+typedef struct popcorn_shader_s
+{
+	uint32_t                count;
+	popcorn_shaderVariant_t variant[POPCORN_SHADER_VARIANTS];
+} popcorn_shader_t;
+
+popcorn_shader_t* popcorn_shader_new(const char* resource);
+void              popcorn_shader_delete(popcorn_shader_t** _self);
+const char*       popcorn_shader_lookup(popcorn_shader_t* self,
+                                        const char* src,
+                                        uint32_t features);
+
+#endif
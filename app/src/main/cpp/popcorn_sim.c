@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libcc/cc_timestamp.h"
+#include "popcorn_memory.h"
+#include "popcorn_sim.h"
+
+// set in the middle index of the triple buffer
+// when it contains a snapshot the reader has not seen
+#define POPCORN_SIM_FRESH 0x4
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static void
+popcorn_sim_step(popcorn_sim_t* self, double t)
+{
+	ASSERT(self);
+
+	popcorn_flightState_t* state = &self->state;
+	double                 t0    = cc_timestamp();
+
+	// consume the input which occurred before the tick
+	popcorn_inputState_t in;
+	popcorn_input_poll(self->input, t, &in);
+
+	uint32_t flags;
+	flags = popcorn_flight_step(state, &in, self->collision, t);
+	if(flags & POPCORN_FLIGHT_FLAG_CONTACT)
+	{
+		LOGI("contact: id=%u, t=%f, point=%f,%f,%f, normal=%f,%f,%f",
+		     state->contact.id, state->contact.t,
+		     state->contact.point.x,
+		     state->contact.point.y,
+		     state->contact.point.z,
+		     state->contact.normal.x,
+		     state->contact.normal.y,
+		     state->contact.normal.z);
+	}
+
+	if(self->recorder)
+	{
+		popcorn_recorderRecord_t* r;
+		r = popcorn_recorder_next(self->recorder);
+		r->t            = state->t;
+		r->tick         = state->tick;
+		r->flags        = 0;
+		r->attitude[0]  = state->attitude.v.x;
+		r->attitude[1]  = state->attitude.v.y;
+		r->attitude[2]  = state->attitude.v.z;
+		r->attitude[3]  = state->attitude.s;
+		popcorn_flight_world(state, r->position);
+		r->speed        = state->speed;
+		r->acceleration = state->acceleration;
+		r->inputs[0]    = state->roll;
+		r->inputs[1]    = state->pitch;
+		r->inputs[2]    = state->yaw1;
+		r->inputs[3]    = state->yaw2;
+		r->inputs[4]    = state->rx;
+		r->inputs[5]    = state->ry;
+		r->tick_ms      = (float) (1000.0*(cc_timestamp() - t0));
+
+		if(flags & POPCORN_FLIGHT_FLAG_RESET)
+		{
+			r->flags |= POPCORN_RECORDER_FLAG_RESET;
+		}
+
+		if(flags & POPCORN_FLIGHT_FLAG_CONTACT)
+		{
+			r->flags |= POPCORN_RECORDER_FLAG_CONTACT;
+		}
+	}
+}
+
+static void popcorn_sim_publish(popcorn_sim_t* self)
+{
+	ASSERT(self);
+
+	memcpy(&self->buffer[self->back], &self->state,
+	       sizeof(popcorn_flightState_t));
+
+	// swap the back and middle buffers
+	uint32_t back = self->back | POPCORN_SIM_FRESH;
+	uint32_t old;
+	old = atomic_exchange_explicit(&self->middle, back,
+	                               memory_order_acq_rel);
+	self->back = old & 0x3;
+}
+
+static int popcorn_sim_acquire(popcorn_sim_t* self)
+{
+	ASSERT(self);
+
+	uint32_t middle;
+	middle = atomic_load_explicit(&self->middle,
+	                              memory_order_relaxed);
+	if((middle & POPCORN_SIM_FRESH) == 0)
+	{
+		return 0;
+	}
+
+	// swap the front and middle buffers
+	uint32_t old;
+	old = atomic_exchange_explicit(&self->middle, self->front,
+	                               memory_order_acq_rel);
+	self->front = old & 0x3;
+
+	return 1;
+}
+
+static void popcorn_sim_sleep(double dt)
+{
+	if(dt <= 0.0)
+	{
+		return;
+	}
+
+	struct timespec ts;
+	ts.tv_sec  = (time_t) dt;
+	ts.tv_nsec = (long) (1.0e9*(dt - (double) ts.tv_sec));
+	nanosleep(&ts, NULL);
+}
+
+static void* popcorn_sim_thread(void* arg)
+{
+	ASSERT(arg);
+
+	popcorn_sim_t* self = (popcorn_sim_t*) arg;
+
+	uint32_t tick = 0;
+	while(atomic_load(&self->running))
+	{
+		// rebase the tick clock after a pause so the
+		// paused time is not simulated
+		pthread_mutex_lock(&self->mutex);
+		if(self->paused)
+		{
+			while(self->paused && atomic_load(&self->running))
+			{
+				pthread_cond_wait(&self->cond, &self->mutex);
+			}
+			self->t0 = cc_timestamp() - ((double) tick)*self->dt;
+		}
+		pthread_mutex_unlock(&self->mutex);
+
+		// the simulation runs at a fixed rate so a slow
+		// frame never changes the flight model
+		double t    = cc_timestamp();
+		double next = self->t0 + ((double) (tick + 1))*self->dt;
+		if(t < next)
+		{
+			popcorn_sim_sleep(next - t);
+			continue;
+		}
+
+		// drop ticks after a long stall rather
+		// than spiral trying to catch up
+		uint32_t behind = (uint32_t) ((t - next)/self->dt);
+		if(behind > POPCORN_SIM_CATCHUP)
+		{
+			tick += behind - POPCORN_SIM_CATCHUP;
+			next  = self->t0 + ((double) (tick + 1))*self->dt;
+		}
+
+		while(next <= t)
+		{
+			++tick;
+			popcorn_sim_step(self, next);
+			next = self->t0 + ((double) (tick + 1))*self->dt;
+		}
+
+		popcorn_sim_publish(self);
+	}
+
+	return NULL;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_sim_t* popcorn_sim_new(popcorn_input_t* input,
+                               popcorn_collision_t* collision,
+                               popcorn_recorder_t* recorder)
+{
+	// recorder is optional
+	ASSERT(input);
+	ASSERT(collision);
+
+	popcorn_sim_t* self;
+	self = (popcorn_sim_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_SIM,
+	                             1, sizeof(popcorn_sim_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->input     = input;
+	self->collision = collision;
+	self->recorder  = recorder;
+	self->dt        = 1.0/POPCORN_SIM_RATE;
+	self->t0        = cc_timestamp();
+
+	// attitude quaternion must be initialized
+	popcorn_flight_reset(&self->state);
+	self->state.t = self->t0;
+
+	int i;
+	for(i = 0; i < 3; ++i)
+	{
+		memcpy(&self->buffer[i], &self->state,
+		       sizeof(popcorn_flightState_t));
+	}
+	memcpy(&self->prev, &self->state,
+	       sizeof(popcorn_flightState_t));
+	memcpy(&self->curr, &self->state,
+	       sizeof(popcorn_flightState_t));
+
+	self->back  = 0;
+	self->front = 2;
+	atomic_init(&self->middle, 1);
+	atomic_init(&self->running, 1);
+
+	if(pthread_mutex_init(&self->mutex, NULL) != 0)
+	{
+		LOGE("pthread_mutex_init failed");
+		goto fail_mutex;
+	}
+
+	if(pthread_cond_init(&self->cond, NULL) != 0)
+	{
+		LOGE("pthread_cond_init failed");
+		goto fail_cond;
+	}
+
+	if(pthread_create(&self->thread, NULL,
+	                  popcorn_sim_thread,
+	                  (void*) self) != 0)
+	{
+		LOGE("pthread_create failed");
+		goto fail_thread;
+	}
+
+	// success
+	return self;
+
+	// failure
+	fail_thread:
+		pthread_cond_destroy(&self->cond);
+	fail_cond:
+		pthread_mutex_destroy(&self->mutex);
+	fail_mutex:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_sim_delete(popcorn_sim_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_sim_t* self = *_self;
+	if(self)
+	{
+		pthread_mutex_lock(&self->mutex);
+		atomic_store(&self->running, 0);
+		pthread_cond_signal(&self->cond);
+		pthread_mutex_unlock(&self->mutex);
+		pthread_join(self->thread, NULL);
+		pthread_cond_destroy(&self->cond);
+		pthread_mutex_destroy(&self->mutex);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_sim_pause(popcorn_sim_t* self, int paused)
+{
+	ASSERT(self);
+
+	pthread_mutex_lock(&self->mutex);
+	self->paused = paused;
+	pthread_cond_signal(&self->cond);
+	pthread_mutex_unlock(&self->mutex);
+}
+
+void popcorn_sim_snapshot(popcorn_sim_t* self,
+                          double t,
+                          popcorn_flightState_t* state)
+{
+	ASSERT(self);
+	ASSERT(state);
+
+	if(popcorn_sim_acquire(self))
+	{
+		memcpy(&self->prev, &self->curr,
+		       sizeof(popcorn_flightState_t));
+		memcpy(&self->curr, &self->buffer[self->front],
+		       sizeof(popcorn_flightState_t));
+	}
+
+	popcorn_flightState_t* prev = &self->prev;
+	popcorn_flightState_t* curr = &self->curr;
+	memcpy(state, curr, sizeof(popcorn_flightState_t));
+
+	// do not interpolate across a reset
+	if((prev->resets != curr->resets) ||
+	   (curr->t <= prev->t))
+	{
+		return;
+	}
+
+	// render one tick behind the simulation and
+	// interpolate between the last two snapshots
+	float s = (float) ((t - self->dt - prev->t)/
+	                   (curr->t - prev->t));
+	if(s <= 0.0f)
+	{
+		s = 0.0f;
+	}
+	else if(s >= 1.0f)
+	{
+		return;
+	}
+
+	cc_quaternion_slerp(&prev->attitude, &curr->attitude,
+	                    s, &state->attitude);
+
+	// the previous position is expressed relative to the
+	// current sector in case the tick rebased
+	cc_vec3f_t p0;
+	cc_vec3f_t dp;
+	popcorn_flight_offset(prev->sector, curr->sector, &p0);
+	cc_vec3f_addv(&p0, &prev->position);
+	cc_vec3f_subv_copy(&curr->position, &p0, &dp);
+	cc_vec3f_muls(&dp, s);
+	cc_vec3f_addv_copy(&p0, &dp, &state->position);
+
+	state->speed = prev->speed + s*(curr->speed - prev->speed);
+	state->rx    = prev->rx + s*(curr->rx - prev->rx);
+	state->ry    = prev->ry + s*(curr->ry - prev->ry);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_sim_H
+#define popcorn_sim_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "popcorn_collision.h"
+#include "popcorn_flight.h"
+#include "popcorn_input.h"
+#include "popcorn_recorder.h"
+
+// fixed simulation rate
+#define POPCORN_SIM_RATE 60.0
+
+// maximum ticks simulated to catch up after a stall
+#define POPCORN_SIM_CATCHUP 4
+
+typedef struct popcorn_sim_s
+{
+	// shared with the renderer
+	popcorn_input_t*     input;
+	popcorn_collision_t* collision;
+	popcorn_recorder_t*  recorder;
+
+	// simulation thread state
+	double                dt;
+	double                t0;
+	popcorn_flightState_t state;
+	pthread_t             thread;
+	atomic_int            running;
+
+	// the thread blocks while paused
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	int             paused;
+
+	// lock-free triple buffer
+	// the writer owns back, the reader owns front and
+	// middle holds the most recent completed snapshot
+	popcorn_flightState_t buffer[3];
+	atomic_uint           middle;
+	uint32_t              back;
+	uint32_t              front;
+
+	// render thread state
+	popcorn_flightState_t prev;
+	popcorn_flightState_t curr;
+} popcorn_sim_t;
+
+popcorn_sim_t* popcorn_sim_new(popcorn_input_t* input,
+                               popcorn_collision_t* collision,
+                               popcorn_recorder_t* recorder);
+void           popcorn_sim_delete(popcorn_sim_t** _self);
+void           popcorn_sim_pause(popcorn_sim_t* self,
+                                 int paused);
+void           popcorn_sim_snapshot(popcorn_sim_t* self,
+                                    double t,
+                                    popcorn_flightState_t* state);
+
+#endif
@@ -0,0 +1,857 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_simplify.h"
+
+// boundary planes are weighted so open edges are only
+// collapsed along the boundary
+#define POPCORN_SIMPLIFY_BOUNDARY 10.0
+
+// quadric coefficients
+// a2, ab, ac, ad, b2, bc, bd, c2, cd, d2
+#define POPCORN_SIMPLIFY_QUADRIC 10
+
+typedef struct
+{
+	uint32_t from;
+	uint32_t to;
+	double   cost;
+} popcorn_simplifyEdge_t;
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static const float*
+popcorn_simplify_position(popcorn_simplify_t* self,
+                          uint32_t w)
+{
+	ASSERT(self);
+
+	return &self->vb[3*self->wlist[self->wfirst[w]]];
+}
+
+static void
+popcorn_simplify_addPlane(double* q, double a, double b,
+                          double c, double d, double weight)
+{
+	ASSERT(q);
+
+	q[0] += weight*a*a;
+	q[1] += weight*a*b;
+	q[2] += weight*a*c;
+	q[3] += weight*a*d;
+	q[4] += weight*b*b;
+	q[5] += weight*b*c;
+	q[6] += weight*b*d;
+	q[7] += weight*c*c;
+	q[8] += weight*c*d;
+	q[9] += weight*d*d;
+}
+
+static double
+popcorn_simplify_eval(const double* q, const float* p)
+{
+	ASSERT(q);
+	ASSERT(p);
+
+	double x = p[0];
+	double y = p[1];
+	double z = p[2];
+	double e = q[0]*x*x + 2.0*q[1]*x*y + 2.0*q[2]*x*z +
+	           2.0*q[3]*x + q[4]*y*y + 2.0*q[5]*y*z +
+	           2.0*q[6]*y + q[7]*z*z + 2.0*q[8]*z + q[9];
+	return (e > 0.0) ? e : 0.0;
+}
+
+static void
+popcorn_simplify_normal(const float* p0, const float* p1,
+                        const float* p2, double* n)
+{
+	ASSERT(p0);
+	ASSERT(p1);
+	ASSERT(p2);
+	ASSERT(n);
+
+	double u[3] =
+	{
+		p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]
+	};
+	double v[3] =
+	{
+		p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]
+	};
+	n[0] = u[1]*v[2] - u[2]*v[1];
+	n[1] = u[2]*v[0] - u[0]*v[2];
+	n[2] = u[0]*v[1] - u[1]*v[0];
+}
+
+static uint64_t
+popcorn_simplify_edgeKey(uint32_t a, uint32_t b)
+{
+	return (a < b) ? ((((uint64_t) a) << 32) | b) :
+	                 ((((uint64_t) b) << 32) | a);
+}
+
+static int popcorn_simplify_cmpKey(const void* a, const void* b)
+{
+	ASSERT(a);
+	ASSERT(b);
+
+	uint64_t ka = *((const uint64_t*) a);
+	uint64_t kb = *((const uint64_t*) b);
+	return (ka < kb) ? -1 : ((ka > kb) ? 1 : 0);
+}
+
+static int popcorn_simplify_cmpCost(const void* a, const void* b)
+{
+	ASSERT(a);
+	ASSERT(b);
+
+	const popcorn_simplifyEdge_t* ea;
+	const popcorn_simplifyEdge_t* eb;
+	ea = (const popcorn_simplifyEdge_t*) a;
+	eb = (const popcorn_simplifyEdge_t*) b;
+	return (ea->cost < eb->cost) ? -1 :
+	       ((ea->cost > eb->cost) ? 1 : 0);
+}
+
+static int popcorn_simplify_weld(popcorn_simplify_t* self)
+{
+	ASSERT(self);
+
+	// open addressing hash of the vertex positions
+	uint32_t size = 16;
+	while(size < 2*self->vc)
+	{
+		size *= 2;
+	}
+
+	uint32_t* table;
+	table = (uint32_t*)
+	        popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                              size, sizeof(uint32_t));
+	if(table == NULL)
+	{
+		LOGE("CALLOC failed");
+		return 0;
+	}
+
+	// table entries are vertex + 1
+	uint32_t v;
+	for(v = 0; v < self->vc; ++v)
+	{
+		const float* p = &self->vb[3*v];
+		uint32_t     h = 2166136261u;
+		uint32_t     bits[3];
+		memcpy(bits, p, sizeof(bits));
+
+		int i;
+		for(i = 0; i < 3; ++i)
+		{
+			h = (h ^ bits[i])*16777619u;
+		}
+
+		uint32_t slot = h & (size - 1);
+		while(table[slot])
+		{
+			uint32_t u = table[slot] - 1;
+			if(memcmp(&self->vb[3*u], p, 3*sizeof(float)) == 0)
+			{
+				break;
+			}
+			slot = (slot + 1) & (size - 1);
+		}
+
+		if(table[slot])
+		{
+			self->wid[v] = self->wid[table[slot] - 1];
+		}
+		else
+		{
+			table[slot]  = v + 1;
+			self->wid[v] = self->wvc++;
+		}
+	}
+	popcorn_memory_free(table);
+
+	// vertices of each welded vertex
+	for(v = 0; v < self->vc; ++v)
+	{
+		++self->wfirst[self->wid[v] + 1];
+	}
+
+	uint32_t w;
+	for(w = 0; w < self->wvc; ++w)
+	{
+		self->wfirst[w + 1] += self->wfirst[w];
+	}
+
+	for(v = 0; v < self->vc; ++v)
+	{
+		self->wlist[self->wfirst[self->wid[v]]++] = v;
+	}
+
+	for(w = self->wvc; w > 0; --w)
+	{
+		self->wfirst[w] = self->wfirst[w - 1];
+	}
+	self->wfirst[0] = 0;
+
+	return 1;
+}
+
+static int popcorn_simplify_quadrics(popcorn_simplify_t* self)
+{
+	ASSERT(self);
+
+	uint32_t t;
+	for(t = 0; t < self->tc; ++t)
+	{
+		uint32_t*    c  = &self->tri[3*t];
+		const float* p0 = &self->vb[3*c[0]];
+		const float* p1 = &self->vb[3*c[1]];
+		const float* p2 = &self->vb[3*c[2]];
+
+		double n[3];
+		popcorn_simplify_normal(p0, p1, p2, n);
+
+		double l = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+		if(l == 0.0)
+		{
+			continue;
+		}
+		n[0] /= l;
+		n[1] /= l;
+		n[2] /= l;
+
+		double d = -(n[0]*p0[0] + n[1]*p0[1] + n[2]*p0[2]);
+
+		int i;
+		for(i = 0; i < 3; ++i)
+		{
+			double* q;
+			q = &self->quadric[POPCORN_SIMPLIFY_QUADRIC*
+			                   self->wid[c[i]]];
+			popcorn_simplify_addPlane(q, n[0], n[1], n[2], d, 1.0);
+		}
+	}
+
+	// boundary edges are used by a single triangle
+	uint64_t* keys = (uint64_t*) self->edges;
+	uint32_t  kc   = 3*self->tc;
+	for(t = 0; t < self->tc; ++t)
+	{
+		uint32_t* c = &self->tri[3*t];
+
+		int i;
+		for(i = 0; i < 3; ++i)
+		{
+			keys[3*t + i] =
+				popcorn_simplify_edgeKey(self->wid[c[i]],
+				                         self->wid[c[(i + 1)%3]]);
+		}
+	}
+	qsort(keys, kc, sizeof(uint64_t), popcorn_simplify_cmpKey);
+
+	for(t = 0; t < self->tc; ++t)
+	{
+		uint32_t*    c  = &self->tri[3*t];
+		const float* p0 = &self->vb[3*c[0]];
+		const float* p1 = &self->vb[3*c[1]];
+		const float* p2 = &self->vb[3*c[2]];
+
+		double n[3];
+		popcorn_simplify_normal(p0, p1, p2, n);
+
+		int i;
+		for(i = 0; i < 3; ++i)
+		{
+			uint32_t a = self->wid[c[i]];
+			uint32_t b = self->wid[c[(i + 1)%3]];
+			uint64_t key = popcorn_simplify_edgeKey(a, b);
+
+			uint64_t* k;
+			k = (uint64_t*) bsearch(&key, keys, kc,
+			                        sizeof(uint64_t),
+			                        popcorn_simplify_cmpKey);
+			ASSERT(k);
+			if(((k > keys) && (k[-1] == key)) ||
+			   ((k < &keys[kc - 1]) && (k[1] == key)))
+			{
+				continue;
+			}
+
+			// plane through the edge perpendicular to
+			// the triangle
+			const float* pa = &self->vb[3*c[i]];
+			const float* pb = &self->vb[3*c[(i + 1)%3]];
+			double e[3] =
+			{
+				pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]
+			};
+			double m[3] =
+			{
+				e[1]*n[2] - e[2]*n[1],
+				e[2]*n[0] - e[0]*n[2],
+				e[0]*n[1] - e[1]*n[0],
+			};
+			double l = sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+			if(l == 0.0)
+			{
+				continue;
+			}
+			m[0] /= l;
+			m[1] /= l;
+			m[2] /= l;
+
+			double d = -(m[0]*pa[0] + m[1]*pa[1] + m[2]*pa[2]);
+			popcorn_simplify_addPlane(&self->quadric[POPCORN_SIMPLIFY_QUADRIC*a],
+			                          m[0], m[1], m[2], d,
+			                          POPCORN_SIMPLIFY_BOUNDARY);
+			popcorn_simplify_addPlane(&self->quadric[POPCORN_SIMPLIFY_QUADRIC*b],
+			                          m[0], m[1], m[2], d,
+			                          POPCORN_SIMPLIFY_BOUNDARY);
+		}
+	}
+
+	return 1;
+}
+
+static uint32_t popcorn_simplify_edges(popcorn_simplify_t* self)
+{
+	ASSERT(self);
+
+	// unique welded edges of the current triangles
+	// the keys alias the front of the edge array and are
+	// consumed before the edges overwrite them
+	uint64_t* keys = (uint64_t*) self->edges;
+	uint32_t  kc   = 0;
+	uint32_t  t;
+	for(t = 0; t < self->tc; ++t)
+	{
+		uint32_t* c = &self->tri[3*t];
+
+		int i;
+		for(i = 0; i < 3; ++i)
+		{
+			keys[kc++] =
+				popcorn_simplify_edgeKey(self->wid[c[i]],
+				                         self->wid[c[(i + 1)%3]]);
+		}
+	}
+	qsort(keys, kc, sizeof(uint64_t), popcorn_simplify_cmpKey);
+
+	uint32_t n = 0;
+	uint32_t i;
+	for(i = 0; i < kc; ++i)
+	{
+		if((i == 0) || (keys[i] != keys[i - 1]))
+		{
+			keys[n++] = keys[i];
+		}
+	}
+
+	// edges are larger than keys so fill from the back
+	popcorn_simplifyEdge_t* edges;
+	edges = (popcorn_simplifyEdge_t*) self->edges;
+	for(i = n; i > 0; --i)
+	{
+		uint64_t key = keys[i - 1];
+		uint32_t a   = (uint32_t) (key >> 32);
+		uint32_t b   = (uint32_t) (key & 0xFFFFFFFF);
+
+		double q[POPCORN_SIMPLIFY_QUADRIC];
+		int    j;
+		for(j = 0; j < POPCORN_SIMPLIFY_QUADRIC; ++j)
+		{
+			q[j] = self->quadric[POPCORN_SIMPLIFY_QUADRIC*a + j] +
+			       self->quadric[POPCORN_SIMPLIFY_QUADRIC*b + j];
+		}
+
+		double cost_ab;
+		double cost_ba;
+		cost_ab = popcorn_simplify_eval(q, popcorn_simplify_position(self, b));
+		cost_ba = popcorn_simplify_eval(q, popcorn_simplify_position(self, a));
+
+		popcorn_simplifyEdge_t* e = &edges[i - 1];
+		if(cost_ab <= cost_ba)
+		{
+			e->from = a;
+			e->to   = b;
+			e->cost = cost_ab;
+		}
+		else
+		{
+			e->from = b;
+			e->to   = a;
+			e->cost = cost_ba;
+		}
+	}
+	qsort(edges, n, sizeof(popcorn_simplifyEdge_t),
+	      popcorn_simplify_cmpCost);
+
+	return n;
+}
+
+static void popcorn_simplify_adjacency(popcorn_simplify_t* self)
+{
+	ASSERT(self);
+
+	// triangles of each welded vertex
+	memset(self->afirst, 0, (self->wvc + 1)*sizeof(uint32_t));
+
+	uint32_t t;
+	int      i;
+	for(t = 0; t < self->tc; ++t)
+	{
+		for(i = 0; i < 3; ++i)
+		{
+			++self->afirst[self->wid[self->tri[3*t + i]] + 1];
+		}
+	}
+
+	uint32_t w;
+	for(w = 0; w < self->wvc; ++w)
+	{
+		self->afirst[w + 1] += self->afirst[w];
+	}
+
+	for(t = 0; t < self->tc; ++t)
+	{
+		for(i = 0; i < 3; ++i)
+		{
+			uint32_t w = self->wid[self->tri[3*t + i]];
+			self->alist[self->afirst[w]++] = t;
+		}
+	}
+
+	for(w = self->wvc; w > 0; --w)
+	{
+		self->afirst[w] = self->afirst[w - 1];
+	}
+	self->afirst[0] = 0;
+}
+
+static int
+popcorn_simplify_collapse(popcorn_simplify_t* self,
+                          popcorn_simplifyEdge_t* e,
+                          uint32_t* removed)
+{
+	ASSERT(self);
+	ASSERT(e);
+	ASSERT(removed);
+
+	uint32_t     a  = e->from;
+	uint32_t     b  = e->to;
+	const float* pb = popcorn_simplify_position(self, b);
+
+	// reject collapses which flip a triangle
+	uint32_t r = 0;
+	uint32_t i;
+	for(i = self->afirst[a]; i < self->afirst[a + 1]; ++i)
+	{
+		uint32_t* c = &self->tri[3*self->alist[i]];
+		uint32_t  w[3] =
+		{
+			self->wid[c[0]], self->wid[c[1]], self->wid[c[2]]
+		};
+
+		if((w[0] == b) || (w[1] == b) || (w[2] == b))
+		{
+			++r;
+			continue;
+		}
+
+		const float* p[3];
+		const float* q[3];
+		int j;
+		for(j = 0; j < 3; ++j)
+		{
+			p[j] = &self->vb[3*c[j]];
+			q[j] = (w[j] == a) ? pb : p[j];
+		}
+
+		double n0[3];
+		double n1[3];
+		popcorn_simplify_normal(p[0], p[1], p[2], n0);
+		popcorn_simplify_normal(q[0], q[1], q[2], n1);
+		if(n0[0]*n1[0] + n0[1]*n1[1] + n0[2]*n1[2] <= 0.0)
+		{
+			return 0;
+		}
+	}
+
+	// the neighbourhood of a changes so it is locked
+	// until the next pass
+	for(i = self->afirst[a]; i < self->afirst[a + 1]; ++i)
+	{
+		uint32_t* c = &self->tri[3*self->alist[i]];
+		self->locked[self->wid[c[0]]] = 1;
+		self->locked[self->wid[c[1]]] = 1;
+		self->locked[self->wid[c[2]]] = 1;
+	}
+	self->locked[a]   = 1;
+	self->locked[b]   = 1;
+	self->collapse[a] = b;
+
+	int j;
+	for(j = 0; j < POPCORN_SIMPLIFY_QUADRIC; ++j)
+	{
+		self->quadric[POPCORN_SIMPLIFY_QUADRIC*b + j] +=
+			self->quadric[POPCORN_SIMPLIFY_QUADRIC*a + j];
+	}
+
+	double error = sqrt(e->cost);
+	if(error > self->error)
+	{
+		self->error = (float) error;
+	}
+
+	*removed += r;
+	return 1;
+}
+
+static uint32_t
+popcorn_simplify_target(popcorn_simplify_t* self, uint32_t v)
+{
+	ASSERT(self);
+
+	// vertices follow their welded vertex to the vertex of
+	// the target with the most similar normal
+	uint32_t w = self->wid[v];
+	if(self->collapse[w] == w)
+	{
+		return v;
+	}
+
+	const float* n    = &self->nb[3*v];
+	uint32_t     b    = self->collapse[w];
+	uint32_t     best = self->wlist[self->wfirst[b]];
+	float        dot  = -2.0f;
+	uint32_t     i;
+	for(i = self->wfirst[b]; i < self->wfirst[b + 1]; ++i)
+	{
+		uint32_t     u  = self->wlist[i];
+		const float* m  = &self->nb[3*u];
+		float        d  = n[0]*m[0] + n[1]*m[1] + n[2]*m[2];
+		if(d > dot)
+		{
+			dot  = d;
+			best = u;
+		}
+	}
+
+	return best;
+}
+
+static void popcorn_simplify_apply(popcorn_simplify_t* self)
+{
+	ASSERT(self);
+
+	// remap the corners and remove degenerate triangles
+	uint32_t tc = 0;
+	uint32_t t;
+	for(t = 0; t < self->tc; ++t)
+	{
+		uint32_t c[3];
+		int      i;
+		for(i = 0; i < 3; ++i)
+		{
+			c[i] = popcorn_simplify_target(self,
+			                               self->tri[3*t + i]);
+		}
+
+		uint32_t w0 = self->wid[c[0]];
+		uint32_t w1 = self->wid[c[1]];
+		uint32_t w2 = self->wid[c[2]];
+		if((w0 == w1) || (w1 == w2) || (w2 == w0))
+		{
+			continue;
+		}
+
+		memcpy(&self->tri[3*tc], c, sizeof(c));
+		++tc;
+	}
+	self->tc = tc;
+}
+
+static void popcorn_simplify_compact(popcorn_simplify_t* self)
+{
+	ASSERT(self);
+
+	uint32_t v;
+	for(v = 0; v < self->vc; ++v)
+	{
+		self->map[v] = UINT32_MAX;
+	}
+
+	uint32_t vc = 0;
+	uint32_t i;
+	for(i = 0; i < 3*self->tc; ++i)
+	{
+		v = self->tri[i];
+		if(self->map[v] == UINT32_MAX)
+		{
+			self->map[v] = vc;
+			memcpy(&self->vb_out[3*vc], &self->vb[3*v],
+			       3*sizeof(float));
+			memcpy(&self->nb_out[3*vc], &self->nb[3*v],
+			       3*sizeof(float));
+			++vc;
+		}
+		self->ib[i] = (uint16_t) self->map[v];
+	}
+
+	self->ic     = 3*self->tc;
+	self->out_vc = vc;
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_simplify_t* popcorn_simplify_new(uint32_t ic,
+                                         const uint16_t* ib,
+                                         uint32_t vc,
+                                         const float* vb,
+                                         const float* nb)
+{
+	ASSERT(ib);
+	ASSERT(vb);
+	ASSERT(nb);
+
+	popcorn_simplify_t* self;
+	self = (popcorn_simplify_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH, 1,
+	                             sizeof(popcorn_simplify_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->vc = vc;
+	self->vb = vb;
+	self->nb = nb;
+
+	uint32_t tc = ic/3;
+
+	// one block for the per-vertex arrays
+	size_t size_v   = (size_t) vc + 1;
+	size_t size_tri = 3*((size_t) tc) + 1;
+	self->wid = (uint32_t*)
+	            popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                                  6*size_v + 2*size_tri,
+	                                  sizeof(uint32_t));
+	if(self->wid == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_wid;
+	}
+	self->wfirst   = self->wid      + size_v;
+	self->wlist    = self->wfirst   + size_v;
+	self->collapse = self->wlist    + size_v;
+	self->afirst   = self->collapse + size_v;
+	self->map      = self->afirst   + size_v;
+	self->tri      = self->map      + size_v;
+	self->alist    = self->tri      + size_tri;
+
+	self->quadric = (double*)
+	                popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                                      POPCORN_SIMPLIFY_QUADRIC*size_v,
+	                                      sizeof(double));
+	if(self->quadric == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_quadric;
+	}
+
+	self->locked = (uint8_t*)
+	               popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                                     size_v, sizeof(uint8_t));
+	if(self->locked == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_locked;
+	}
+
+	// each triangle has at most 3 unique edges
+	self->edges = popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                                    size_tri,
+	                                    sizeof(popcorn_simplifyEdge_t));
+	if(self->edges == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_edges;
+	}
+
+	self->ib = (uint16_t*)
+	           popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                                 size_tri, sizeof(uint16_t));
+	if(self->ib == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_ib;
+	}
+
+	self->vb_out = (float*)
+	               popcorn_memory_calloc(POPCORN_MEMORY_TAG_MESH,
+	                                     6*size_v, sizeof(float));
+	if(self->vb_out == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_vb;
+	}
+	self->nb_out = self->vb_out + 3*size_v;
+
+	if(popcorn_simplify_weld(self) == 0)
+	{
+		goto fail_weld;
+	}
+
+	// skip triangles which are degenerate once welded
+	uint32_t t;
+	for(t = 0; t < tc; ++t)
+	{
+		const uint16_t* c = &ib[3*t];
+		uint32_t w0 = self->wid[c[0]];
+		uint32_t w1 = self->wid[c[1]];
+		uint32_t w2 = self->wid[c[2]];
+		if((w0 == w1) || (w1 == w2) || (w2 == w0))
+		{
+			continue;
+		}
+
+		self->tri[3*self->tc]     = c[0];
+		self->tri[3*self->tc + 1] = c[1];
+		self->tri[3*self->tc + 2] = c[2];
+		++self->tc;
+	}
+
+	uint32_t w;
+	for(w = 0; w < self->wvc; ++w)
+	{
+		self->collapse[w] = w;
+	}
+
+	popcorn_simplify_quadrics(self);
+	popcorn_simplify_compact(self);
+
+	// success
+	return self;
+
+	// failure
+	fail_weld:
+		popcorn_memory_free(self->vb_out);
+	fail_vb:
+		popcorn_memory_free(self->ib);
+	fail_ib:
+		popcorn_memory_free(self->edges);
+	fail_edges:
+		popcorn_memory_free(self->locked);
+	fail_locked:
+		popcorn_memory_free(self->quadric);
+	fail_quadric:
+		popcorn_memory_free(self->wid);
+	fail_wid:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_simplify_delete(popcorn_simplify_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_simplify_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self->vb_out);
+		popcorn_memory_free(self->ib);
+		popcorn_memory_free(self->edges);
+		popcorn_memory_free(self->locked);
+		popcorn_memory_free(self->quadric);
+		popcorn_memory_free(self->wid);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+int popcorn_simplify_reduce(popcorn_simplify_t* self,
+                            uint32_t target_ic,
+                            float max_error)
+{
+	ASSERT(self);
+
+	// collapses continue from the previous reduce so the
+	// levels of a chain are nested
+	double   max_cost = ((double) max_error)*((double) max_error);
+	uint32_t target   = target_ic/3;
+	while(self->tc > target)
+	{
+		uint32_t n = popcorn_simplify_edges(self);
+		popcorn_simplify_adjacency(self);
+		memset(self->locked, 0, self->wvc*sizeof(uint8_t));
+
+		popcorn_simplifyEdge_t* edges;
+		edges = (popcorn_simplifyEdge_t*) self->edges;
+
+		uint32_t need      = self->tc - target;
+		uint32_t removed   = 0;
+		uint32_t collapses = 0;
+		uint32_t i;
+		for(i = 0; (i < n) && (removed < need); ++i)
+		{
+			popcorn_simplifyEdge_t* e = &edges[i];
+			if(e->cost > max_cost)
+			{
+				break;
+			}
+
+			if(self->locked[e->from] || self->locked[e->to])
+			{
+				continue;
+			}
+
+			collapses += popcorn_simplify_collapse(self, e,
+			                                       &removed);
+		}
+
+		if(collapses == 0)
+		{
+			break;
+		}
+
+		popcorn_simplify_apply(self);
+	}
+
+	popcorn_simplify_compact(self);
+
+	return 1;
+}
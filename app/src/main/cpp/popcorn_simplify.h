@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_simplify_H
+#define popcorn_simplify_H
+
+#include <stdint.h>
+
+// mesh simplification for LOD chains
+// vertices are collapsed onto a neighbour along edges in
+// order of their quadric error (Garland and Heckbert) so no
+// new vertices or attributes are created. Vertices that
+// share a position (normal seams) collapse together and
+// boundary edges are constrained by perpendicular planes.
+//
+// the error is an upper bound on the distance from the
+// collapsed vertices to the planes of the original
+// triangles that they replaced
+
+typedef struct
+{
+	// source mesh
+	uint32_t     vc;
+	const float* vb;
+	const float* nb;
+
+	// vertices which share a position are welded
+	// wvc is the welded vertex count
+	// wlist[wfirst[w]..wfirst[w + 1]) are the vertices of w
+	uint32_t  wvc;
+	uint32_t* wid;
+	uint32_t* wfirst;
+	uint32_t* wlist;
+
+	// quadric of each welded vertex and the welded
+	// vertex it collapsed onto
+	double*   quadric;
+	uint32_t* collapse;
+	uint8_t*  locked;
+
+	// current triangles
+	uint32_t  tc;
+	uint32_t* tri;
+
+	// collapse candidates and adjacency of each pass
+	void*     edges;
+	uint32_t* afirst;
+	uint32_t* alist;
+
+	// compacted output of the last reduce
+	float     error;
+	uint32_t  ic;
+	uint32_t  out_vc;
+	uint16_t* ib;
+	float*    vb_out;
+	float*    nb_out;
+	uint32_t* map;
+} popcorn_simplify_t;
+
+popcorn_simplify_t* popcorn_simplify_new(uint32_t ic,
+                                         const uint16_t* ib,
+                                         uint32_t vc,
+                                         const float* vb,
+                                         const float* nb);
+void                popcorn_simplify_delete(popcorn_simplify_t** _self);
+int                 popcorn_simplify_reduce(popcorn_simplify_t* self,
+                                            uint32_t target_ic,
+                                            float max_error);
+
+#endif
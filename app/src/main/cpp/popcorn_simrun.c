@@ -0,0 +1,725 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libcc/cc_timestamp.h"
+#include "popcorn_collision.h"
+#include "popcorn_flight.h"
+#include "popcorn_input.h"
+#include "popcorn_memory.h"
+#include "popcorn_sim.h"
+
+// batch flight runner
+// scripted flights are stepped headless at the fixed
+// simulation rate as fast as possible on all cores
+//
+// script format (one event per line)
+// <seconds> <control> [value]
+// controls: roll, pitch, yaw1, yaw2, headx, heady (axis value),
+// thrust, brake (1=down, 0=up), reset and end
+#define POPCORN_SIMRUN_EVENTS  1024
+#define POPCORN_SIMRUN_THREADS 64
+
+typedef enum
+{
+	POPCORN_SIMRUN_CONTROL_AXIS   = 0,
+	POPCORN_SIMRUN_CONTROL_BUTTON = 1,
+	POPCORN_SIMRUN_CONTROL_END    = 2,
+} popcorn_simrunControl_e;
+
+typedef struct
+{
+	double                  t;
+	popcorn_simrunControl_e control;
+	uint32_t                id;
+	float                   value;
+} popcorn_simrunEvent_t;
+
+typedef struct
+{
+	const char*           fname;
+	double                duration;
+	uint32_t              count;
+	popcorn_simrunEvent_t event[POPCORN_SIMRUN_EVENTS];
+} popcorn_simrunScript_t;
+
+typedef struct
+{
+	uint32_t script;
+	uint32_t repeat;
+	uint32_t ticks;
+	double   wall;
+	uint32_t contacts;
+	uint32_t resets;
+	float    max_speed;
+	float    distance;
+	float    attitude[4];
+	double   position[3];
+} popcorn_simrunResult_t;
+
+typedef struct
+{
+	// options
+	uint32_t    repeats;
+	float       jitter;
+	uint32_t    every;
+	const char* prefix;
+
+	uint32_t                script_count;
+	popcorn_simrunScript_t* scripts;
+
+	// flights are claimed by the workers
+	uint32_t                flights;
+	atomic_uint             next;
+	atomic_int              failed;
+	popcorn_simrunResult_t* results;
+} popcorn_simrun_t;
+
+/***********************************************************
+* private                                                  *
+***********************************************************/
+
+static int
+popcorn_simrun_parse(popcorn_simrunScript_t* self,
+                     const char* fname)
+{
+	ASSERT(self);
+	ASSERT(fname);
+
+	FILE* f = fopen(fname, "r");
+	if(f == NULL)
+	{
+		LOGE("invalid %s", fname);
+		return 0;
+	}
+
+	self->fname    = fname;
+	self->duration = 0.0;
+	self->count    = 0;
+
+	char line[256];
+	int  lineno = 0;
+	while(fgets(line, 256, f))
+	{
+		++lineno;
+
+		char* comment = strchr(line, '#');
+		if(comment)
+		{
+			*comment = '\0';
+		}
+
+		double t;
+		char   name[32];
+		float  value = 0.0f;
+		int    n     = sscanf(line, "%lf %31s %f", &t, name, &value);
+		if(n <= 0)
+		{
+			continue;
+		}
+		else if((n < 2) || (t < 0.0))
+		{
+			LOGE("invalid %s:%i", fname, lineno);
+			goto fail_line;
+		}
+
+		if(self->count >= POPCORN_SIMRUN_EVENTS)
+		{
+			LOGE("invalid %s:%i events", fname, lineno);
+			goto fail_line;
+		}
+
+		popcorn_simrunEvent_t* e = &self->event[self->count];
+		e->t     = t;
+		e->value = value;
+		if(strcmp(name, "roll") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_AXIS;
+			e->id      = POPCORN_INPUT_AXIS_ROLL;
+		}
+		else if(strcmp(name, "pitch") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_AXIS;
+			e->id      = POPCORN_INPUT_AXIS_PITCH;
+		}
+		else if(strcmp(name, "yaw1") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_AXIS;
+			e->id      = POPCORN_INPUT_AXIS_YAW1;
+		}
+		else if(strcmp(name, "yaw2") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_AXIS;
+			e->id      = POPCORN_INPUT_AXIS_YAW2;
+		}
+		else if(strcmp(name, "headx") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_AXIS;
+			e->id      = POPCORN_INPUT_AXIS_HEAD_X;
+		}
+		else if(strcmp(name, "heady") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_AXIS;
+			e->id      = POPCORN_INPUT_AXIS_HEAD_Y;
+		}
+		else if(strcmp(name, "thrust") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_BUTTON;
+			e->id      = POPCORN_INPUT_BUTTON_THRUST;
+		}
+		else if(strcmp(name, "brake") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_BUTTON;
+			e->id      = POPCORN_INPUT_BUTTON_BRAKE;
+		}
+		else if(strcmp(name, "reset") == 0)
+		{
+			// the reset is applied on release
+			e->control = POPCORN_SIMRUN_CONTROL_BUTTON;
+			e->id      = POPCORN_INPUT_BUTTON_RESET;
+			e->value   = 0.0f;
+		}
+		else if(strcmp(name, "end") == 0)
+		{
+			e->control = POPCORN_SIMRUN_CONTROL_END;
+			e->id      = 0;
+		}
+		else
+		{
+			LOGE("invalid %s:%i %s", fname, lineno, name);
+			goto fail_line;
+		}
+
+		// events must be in order
+		if(self->count &&
+		   (t < self->event[self->count - 1].t))
+		{
+			LOGE("invalid %s:%i order", fname, lineno);
+			goto fail_line;
+		}
+
+		if(t > self->duration)
+		{
+			self->duration = t;
+		}
+		++self->count;
+	}
+
+	fclose(f);
+
+	if(self->duration <= 0.0)
+	{
+		LOGE("invalid %s duration", fname);
+		return 0;
+	}
+
+	// success
+	return 1;
+
+	// failure
+	fail_line:
+		fclose(f);
+	return 0;
+}
+
+static float popcorn_simrun_random(uint32_t* seed)
+{
+	ASSERT(seed);
+
+	// deterministic LCG in [-1,1]
+	*seed = 1664525*(*seed) + 1013904223;
+	return 2.0f*((float) (*seed >> 8))/((float) (1 << 24)) - 1.0f;
+}
+
+static popcorn_collision_t* popcorn_simrun_world(void)
+{
+	popcorn_collision_t* collision;
+	collision = popcorn_collision_new(0.25f);
+	if(collision == NULL)
+	{
+		return NULL;
+	}
+
+	// the cube is the only world mesh
+	// see popcorn_renderer_new
+	const float P[8][4] =
+	{
+		{ -1.0f,  1.0f,  1.0f, 1.0f }, // A
+		{ -1.0f, -1.0f,  1.0f, 1.0f }, // B
+		{  1.0f,  1.0f,  1.0f, 1.0f }, // C
+		{  1.0f, -1.0f,  1.0f, 1.0f }, // D
+		{ -1.0f,  1.0f, -1.0f, 1.0f }, // E
+		{ -1.0f, -1.0f, -1.0f, 1.0f }, // F
+		{  1.0f,  1.0f, -1.0f, 1.0f }, // G
+		{  1.0f, -1.0f, -1.0f, 1.0f }, // H
+	};
+
+	const int idx[36] =
+	{
+		0, 1, 3, 0, 3, 2, // top
+		4, 5, 7, 4, 7, 6, // bottom
+		2, 6, 7, 2, 7, 3, // right
+		0, 4, 5, 0, 5, 1, // left
+		0, 4, 6, 0, 6, 2, // back
+		1, 5, 7, 1, 7, 3, // front
+	};
+
+	float xyzw[4*36];
+	int   i;
+	for(i = 0; i < 36; ++i)
+	{
+		memcpy(&xyzw[4*i], P[idx[i]], 4*sizeof(float));
+	}
+
+	if(popcorn_collision_addMesh(collision, 0, NULL,
+	                             36, 4, xyzw, 0, NULL) == 0)
+	{
+		popcorn_collision_delete(&collision);
+		return NULL;
+	}
+
+	return collision;
+}
+
+static int
+popcorn_simrun_fly(popcorn_simrun_t* self, uint32_t flight,
+                   popcorn_collision_t* collision,
+                   popcorn_input_t* input)
+{
+	ASSERT(self);
+	ASSERT(collision);
+	ASSERT(input);
+
+	popcorn_simrunResult_t* result = &self->results[flight];
+	popcorn_simrunScript_t* script;
+	result->script = flight/self->repeats;
+	result->repeat = flight%self->repeats;
+	script         = &self->scripts[result->script];
+
+	FILE* f = NULL;
+	if(self->prefix)
+	{
+		char fname[256];
+		snprintf(fname, 256, "%s_%u.csv", self->prefix, flight);
+		f = fopen(fname, "w");
+		if(f == NULL)
+		{
+			LOGE("invalid %s", fname);
+			return 0;
+		}
+		fprintf(f, "t,tick,flags,qx,qy,qz,qw,x,y,z,speed\n");
+	}
+
+	// axis values of repeated flights are scaled by a
+	// deterministic jitter
+	uint32_t seed = flight + 1;
+	float    scale[POPCORN_INPUT_AXIS_COUNT];
+	int      i;
+	for(i = 0; i < POPCORN_INPUT_AXIS_COUNT; ++i)
+	{
+		scale[i] = 1.0f;
+		if(result->repeat)
+		{
+			scale[i] += self->jitter*popcorn_simrun_random(&seed);
+		}
+	}
+
+	// zero the axes from the previous flight
+	// the button edges were consumed by its last tick and
+	// the acceleration is held by the flight state
+	popcorn_inputState_t in;
+	for(i = 0; i < POPCORN_INPUT_AXIS_COUNT; ++i)
+	{
+		popcorn_input_axis(input, (popcorn_inputAxis_e) i, 0.0f);
+	}
+
+	popcorn_flightState_t state;
+	memset(&state, 0, sizeof(popcorn_flightState_t));
+	popcorn_flight_reset(&state);
+
+	double   dt    = 1.0/POPCORN_SIM_RATE;
+	uint32_t ticks = (uint32_t) ceil(script->duration*POPCORN_SIM_RATE);
+	uint32_t e     = 0;
+	uint32_t tick;
+	double   t0    = cc_timestamp();
+	for(tick = 1; tick <= ticks; ++tick)
+	{
+		// push the events which occurred before the tick
+		double t = ((double) tick)*dt;
+		while((e < script->count) && (script->event[e].t <= t))
+		{
+			popcorn_simrunEvent_t* ev = &script->event[e];
+			if(ev->control == POPCORN_SIMRUN_CONTROL_AXIS)
+			{
+				popcorn_input_axis(input,
+				                   (popcorn_inputAxis_e) ev->id,
+				                   scale[ev->id]*ev->value);
+			}
+			else if(ev->control == POPCORN_SIMRUN_CONTROL_BUTTON)
+			{
+				if(ev->id == POPCORN_INPUT_BUTTON_RESET)
+				{
+					popcorn_input_button(input,
+					                     POPCORN_INPUT_BUTTON_RESET,
+					                     1, ev->t);
+				}
+				popcorn_input_button(input,
+				                     (popcorn_inputButton_e) ev->id,
+				                     ev->value != 0.0f, ev->t);
+			}
+			++e;
+		}
+
+		popcorn_input_poll(input, t, &in);
+
+		// distance is measured in world coordinates
+		// since the position is rebased between sectors
+		double p0[3];
+		popcorn_flight_world(&state, p0);
+
+		uint32_t flags;
+		flags = popcorn_flight_step(&state, &in, collision, t);
+		if(flags & POPCORN_FLIGHT_FLAG_CONTACT)
+		{
+			++result->contacts;
+		}
+
+		if(flags & POPCORN_FLIGHT_FLAG_RESET)
+		{
+			++result->resets;
+		}
+		else
+		{
+			double p1[3];
+			popcorn_flight_world(&state, p1);
+
+			double dx = p1[0] - p0[0];
+			double dy = p1[1] - p0[1];
+			double dz = p1[2] - p0[2];
+			result->distance += (float) sqrt(dx*dx + dy*dy + dz*dz);
+		}
+
+		if(state.speed > result->max_speed)
+		{
+			result->max_speed = state.speed;
+		}
+
+		if(f && ((tick%self->every == 0) || flags))
+		{
+			double p[3];
+			popcorn_flight_world(&state, p);
+			fprintf(f, "%.4lf,%u,%u,%f,%f,%f,%f,%lf,%lf,%lf,%f\n",
+			        t, tick, flags,
+			        state.attitude.v.x, state.attitude.v.y,
+			        state.attitude.v.z, state.attitude.s,
+			        p[0], p[1], p[2], state.speed);
+		}
+	}
+
+	result->wall        = cc_timestamp() - t0;
+	result->ticks       = ticks;
+	result->attitude[0] = state.attitude.v.x;
+	result->attitude[1] = state.attitude.v.y;
+	result->attitude[2] = state.attitude.v.z;
+	result->attitude[3] = state.attitude.s;
+	popcorn_flight_world(&state, result->position);
+
+	if(f)
+	{
+		fclose(f);
+	}
+
+	return 1;
+}
+
+static void* popcorn_simrun_thread(void* arg)
+{
+	ASSERT(arg);
+
+	popcorn_simrun_t* self = (popcorn_simrun_t*) arg;
+
+	// each worker owns its world since a collision query
+	// updates the triangle stamps
+	popcorn_collision_t* collision = popcorn_simrun_world();
+	popcorn_input_t*     input     = popcorn_input_new();
+	if((collision == NULL) || (input == NULL))
+	{
+		atomic_store(&self->failed, 1);
+		goto fail_world;
+	}
+
+	while(atomic_load(&self->failed) == 0)
+	{
+		uint32_t flight = atomic_fetch_add(&self->next, 1);
+		if(flight >= self->flights)
+		{
+			break;
+		}
+
+		if(popcorn_simrun_fly(self, flight, collision,
+		                      input) == 0)
+		{
+			atomic_store(&self->failed, 1);
+		}
+	}
+
+	fail_world:
+		popcorn_input_delete(&input);
+		popcorn_collision_delete(&collision);
+	return NULL;
+}
+
+static void popcorn_simrun_report(popcorn_simrun_t* self,
+                                  double wall)
+{
+	ASSERT(self);
+
+	FILE* f = NULL;
+	if(self->prefix)
+	{
+		char fname[256];
+		snprintf(fname, 256, "%s.csv", self->prefix);
+		f = fopen(fname, "w");
+		if(f == NULL)
+		{
+			LOGE("invalid %s", fname);
+		}
+		else
+		{
+			fprintf(f, "flight,script,repeat,ticks,wall_ms,contacts,"
+			           "resets,max_speed,distance,qx,qy,qz,qw,x,y,z\n");
+		}
+	}
+
+	LOGI("%6s %-24s %6s %8s %10s %8s %8s %10s %10s",
+	     "flight", "script", "repeat", "ticks", "wall_ms",
+	     "contacts", "resets", "max_speed", "distance");
+
+	uint64_t ticks     = 0;
+	uint32_t contacts  = 0;
+	float    dmin      = 0.0f;
+	float    dmax      = 0.0f;
+	double   dsum      = 0.0;
+	uint32_t i;
+	for(i = 0; i < self->flights; ++i)
+	{
+		popcorn_simrunResult_t* r = &self->results[i];
+		const char* name = self->scripts[r->script].fname;
+		LOGI("%6u %-24s %6u %8u %10.3lf %8u %8u %10.6f %10.4f",
+		     i, name, r->repeat, r->ticks, 1000.0*r->wall,
+		     r->contacts, r->resets, r->max_speed, r->distance);
+
+		if(f)
+		{
+			fprintf(f, "%u,%s,%u,%u,%.3lf,%u,%u,%f,%f,"
+			           "%f,%f,%f,%f,%f,%f,%f\n",
+			        i, name, r->repeat, r->ticks,
+			        1000.0*r->wall, r->contacts, r->resets,
+			        r->max_speed, r->distance,
+			        r->attitude[0], r->attitude[1],
+			        r->attitude[2], r->attitude[3],
+			        r->position[0], r->position[1],
+			        r->position[2]);
+		}
+
+		ticks    += r->ticks;
+		contacts += r->contacts;
+		dsum     += r->distance;
+		if((i == 0) || (r->distance < dmin))
+		{
+			dmin = r->distance;
+		}
+		if((i == 0) || (r->distance > dmax))
+		{
+			dmax = r->distance;
+		}
+	}
+
+	if(f)
+	{
+		fclose(f);
+	}
+
+	// the speedup compares the simulated time with the
+	// wall time of the whole batch
+	double simulated = ((double) ticks)/POPCORN_SIM_RATE;
+	LOGI("flights=%u, ticks=%u, simulated=%.1lf s, wall=%.3lf s, "
+	     "speedup=%.0lfx",
+	     self->flights, (uint32_t) ticks, simulated, wall,
+	     (wall > 0.0) ? simulated/wall : 0.0);
+	LOGI("contacts=%u, distance min=%.4f, mean=%.4f, max=%.4f",
+	     contacts, dmin, (float) (dsum/((double) self->flights)),
+	     dmax);
+}
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+int main(int argc, char** argv)
+{
+	popcorn_simrun_t self =
+	{
+		.repeats = 1,
+		.jitter  = 0.0f,
+		.every   = 1,
+		.prefix  = NULL,
+	};
+
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	int opt;
+	while((opt = getopt(argc, argv, "j:n:x:e:o:")) != -1)
+	{
+		if(opt == 'j')
+		{
+			threads = strtol(optarg, NULL, 0);
+		}
+		else if(opt == 'n')
+		{
+			self.repeats = (uint32_t) strtoul(optarg, NULL, 0);
+		}
+		else if(opt == 'x')
+		{
+			self.jitter = strtof(optarg, NULL);
+		}
+		else if(opt == 'e')
+		{
+			self.every = (uint32_t) strtoul(optarg, NULL, 0);
+		}
+		else if(opt == 'o')
+		{
+			self.prefix = optarg;
+		}
+		else
+		{
+			goto fail_usage;
+		}
+	}
+
+	if((optind >= argc) || (self.repeats == 0) ||
+	   (self.every == 0))
+	{
+		goto fail_usage;
+	}
+
+	if(threads < 1)
+	{
+		threads = 1;
+	}
+	else if(threads > POPCORN_SIMRUN_THREADS)
+	{
+		threads = POPCORN_SIMRUN_THREADS;
+	}
+
+	self.script_count = (uint32_t) (argc - optind);
+	self.scripts = (popcorn_simrunScript_t*)
+	               popcorn_memory_calloc(POPCORN_MEMORY_TAG_SIM,
+	                                     self.script_count,
+	                                     sizeof(popcorn_simrunScript_t));
+	if(self.scripts == NULL)
+	{
+		LOGE("CALLOC failed");
+		return EXIT_FAILURE;
+	}
+
+	uint32_t i;
+	for(i = 0; i < self.script_count; ++i)
+	{
+		if(popcorn_simrun_parse(&self.scripts[i],
+		                        argv[optind + i]) == 0)
+		{
+			goto fail_parse;
+		}
+	}
+
+	self.flights = self.script_count*self.repeats;
+	self.results = (popcorn_simrunResult_t*)
+	               popcorn_memory_calloc(POPCORN_MEMORY_TAG_SIM,
+	                                     self.flights,
+	                                     sizeof(popcorn_simrunResult_t));
+	if(self.results == NULL)
+	{
+		LOGE("CALLOC failed");
+		goto fail_results;
+	}
+	atomic_init(&self.next, 0);
+	atomic_init(&self.failed, 0);
+
+	pthread_t thread[POPCORN_SIMRUN_THREADS];
+	long      started = 0;
+	double    t0      = cc_timestamp();
+	for(started = 0; started < threads; ++started)
+	{
+		if(pthread_create(&thread[started], NULL,
+		                  popcorn_simrun_thread,
+		                  (void*) &self) != 0)
+		{
+			LOGE("pthread_create failed");
+			atomic_store(&self.failed, 1);
+			break;
+		}
+	}
+
+	long j;
+	for(j = 0; j < started; ++j)
+	{
+		pthread_join(thread[j], NULL);
+	}
+	double wall = cc_timestamp() - t0;
+
+	if(atomic_load(&self.failed))
+	{
+		goto fail_run;
+	}
+
+	LOGI("threads=%i", (int) started);
+	popcorn_simrun_report(&self, wall);
+
+	popcorn_memory_free(self.results);
+	popcorn_memory_free(self.scripts);
+
+	// success
+	return EXIT_SUCCESS;
+
+	// failure
+	fail_run:
+		popcorn_memory_free(self.results);
+	fail_results:
+	fail_parse:
+		popcorn_memory_free(self.scripts);
+	return EXIT_FAILURE;
+
+	fail_usage:
+		LOGE("usage: %s [-j threads] [-n repeats] [-x jitter] "
+		     "[-e every] [-o prefix] script.txt ...", argv[0]);
+	return EXIT_FAILURE;
+}
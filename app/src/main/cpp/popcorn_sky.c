@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_frametime.h"
+#include "popcorn_memory.h"
+#include "popcorn_sky.h"
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_sky_t* popcorn_sky_new(vkk_engine_t* engine,
+                               popcorn_view_t* view,
+                               popcorn_shader_t* shader,
+                               popcorn_startup_t* startup)
+{
+	ASSERT(engine);
+	ASSERT(view);
+	ASSERT(shader);
+	ASSERT(startup);
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(engine);
+
+	popcorn_sky_t* self;
+	self = (popcorn_sky_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_sky_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->engine = engine;
+
+	vkk_uniformBinding_t ub_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformSky
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.stage   = VKK_STAGE_FS,
+		},
+	};
+
+	self->usf0 = vkk_uniformSetFactory_new(engine,
+	                                       VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                                       1, ub_array0);
+	if(self->usf0 == NULL)
+	{
+		goto fail_usf0;
+	}
+
+	// the view set is bound by the queue
+	vkk_uniformSetFactory_t* usf_array[] =
+	{
+		self->usf0,
+		view->usf1,
+	};
+
+	self->pl = vkk_pipelineLayout_new(engine,
+	                                  2, usf_array);
+	if(self->pl == NULL)
+	{
+		goto fail_pl;
+	}
+
+	const char* vs;
+	const char* fs;
+	vs = popcorn_shader_lookup(shader, "sky.vert", 0);
+	fs = popcorn_shader_lookup(shader, "sky.frag", 0);
+	if((vs == NULL) || (fs == NULL))
+	{
+		goto fail_gp;
+	}
+
+	// the sky is the background so it neither tests
+	// nor writes the depth
+	vkk_graphicsPipelineInfo_t gpi =
+	{
+		.renderer          = rend,
+		.pl                = self->pl,
+		.vs                = vs,
+		.fs                = fs,
+		.vb_count          = 0,
+		.vbi               = NULL,
+		.primitive         = VKK_PRIMITIVE_TRIANGLE_LIST,
+		.primitive_restart = 0,
+		.cull_back         = 0,
+		.depth_test        = 0,
+		.depth_write       = 0,
+		.blend_mode        = VKK_BLEND_MODE_DISABLED
+	};
+
+	popcorn_startup_mark(startup, "sky.pl");
+
+	popcorn_frametime_mark(POPCORN_FRAMETIME_CAUSE_PIPELINE);
+	self->gp = vkk_graphicsPipeline_new(engine, &gpi);
+	if(self->gp == NULL)
+	{
+		goto fail_gp;
+	}
+	popcorn_startup_mark(startup, "sky.gp");
+
+	self->ub00 = vkk_buffer_new(engine,
+	                            VKK_UPDATE_MODE_ASYNCHRONOUS,
+	                            VKK_BUFFER_USAGE_UNIFORM,
+	                            sizeof(popcorn_skyUniform_t),
+	                            NULL);
+	if(self->ub00 == NULL)
+	{
+		goto fail_ub00;
+	}
+
+	vkk_uniformAttachment_t ua_array0[] =
+	{
+		// layout(std140, set=0, binding=0) uniform uniformSky
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.buffer  = self->ub00
+		},
+	};
+
+	self->us0 = vkk_uniformSet_new(engine, 0, 1,
+	                               ua_array0,
+	                               self->usf0);
+	if(self->us0 == NULL)
+	{
+		goto fail_us0;
+	}
+
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_RENDERER,
+	                        sizeof(popcorn_skyUniform_t));
+
+	// success
+	return self;
+
+	// failure
+	fail_us0:
+		vkk_buffer_delete(&self->ub00);
+	fail_ub00:
+		vkk_graphicsPipeline_delete(&self->gp);
+	fail_gp:
+		vkk_pipelineLayout_delete(&self->pl);
+	fail_pl:
+		vkk_uniformSetFactory_delete(&self->usf0);
+	fail_usf0:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_sky_delete(popcorn_sky_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_sky_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_RENDERER,
+		                       sizeof(popcorn_skyUniform_t));
+		vkk_uniformSet_delete(&self->us0);
+		vkk_buffer_delete(&self->ub00);
+		vkk_graphicsPipeline_delete(&self->gp);
+		vkk_pipelineLayout_delete(&self->pl);
+		vkk_uniformSetFactory_delete(&self->usf0);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_sky_draw(popcorn_sky_t* self,
+                      popcorn_queue_t* queue,
+                      const cc_mat4f_t* pm,
+                      const cc_mat4f_t* rvm,
+                      const double* eye)
+{
+	ASSERT(self);
+	ASSERT(queue);
+	ASSERT(pm);
+	ASSERT(rvm);
+	ASSERT(eye);
+
+	vkk_renderer_t* rend;
+	rend = vkk_engine_defaultRenderer(self->engine);
+
+	// the inverse of the rotation-only view-projection
+	// maps each pixel to a view ray and the eye position
+	// is uploaded separately to preserve precision
+	// the stereo eye offset is negligible for the ground
+	// so the views share the uniform
+	popcorn_skyUniform_t* u = &self->uniform;
+	cc_mat4f_t vp;
+	cc_mat4f_mulm_copy(pm, rvm, &vp);
+	cc_mat4f_inverse_copy(&vp, &u->ivp);
+
+	// the checker repeats every 2 cells so the horizontal
+	// eye position is reduced in double precision
+	double period = 2.0*POPCORN_SKY_CELL;
+	cc_vec4f_load(&u->eye,
+	              (float) fmod(eye[0], period),
+	              (float) fmod(eye[1], period),
+	              (float) (eye[2]), 1.0f);
+	cc_vec4f_load(&u->ground, POPCORN_SKY_GROUND,
+	              POPCORN_SKY_CELL, POPCORN_SKY_FOG, 0.0f);
+	vkk_renderer_updateBuffer(rend, self->ub00,
+	                          sizeof(popcorn_skyUniform_t),
+	                          (const void*) u);
+
+	popcorn_queue_draw(queue, POPCORN_QUEUE_LAYER_BACKGROUND,
+	                   self->gp, self->us0, 0.0f, 3, 0, NULL);
+}
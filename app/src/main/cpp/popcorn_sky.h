@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_sky_H
+#define popcorn_sky_H
+
+#include "libcc/math/cc_mat4f.h"
+#include "libcc/math/cc_vec4f.h"
+#include "libvkk/vkk.h"
+#include "popcorn_queue.h"
+#include "popcorn_shader.h"
+#include "popcorn_startup.h"
+#include "popcorn_view.h"
+
+// sky and ground
+// a fullscreen triangle is generated by sky.vert without
+// vertex buffers and sky.frag intersects each view ray
+// with an infinite checkered ground plane or shades the
+// sky gradient so the world has a horizon for one draw
+
+// ground plane below the cube
+// the world up axis is -z
+#define POPCORN_SKY_GROUND 2.0f
+
+// checker cell size and fog density
+#define POPCORN_SKY_CELL 0.5f
+#define POPCORN_SKY_FOG  0.02f
+
+// see uniformSky in sky.frag
+typedef struct
+{
+	cc_mat4f_t ivp;
+	cc_vec4f_t eye;
+	cc_vec4f_t ground;
+} popcorn_skyUniform_t;
+
+typedef struct
+{
+	vkk_engine_t*            engine;
+	vkk_uniformSetFactory_t* usf0;
+	vkk_pipelineLayout_t*    pl;
+	vkk_graphicsPipeline_t*  gp;
+	vkk_buffer_t*            ub00;
+	vkk_uniformSet_t*        us0;
+
+	// uploaded once per frame
+	popcorn_skyUniform_t uniform;
+} popcorn_sky_t;
+
+popcorn_sky_t* popcorn_sky_new(vkk_engine_t* engine,
+                               popcorn_view_t* view,
+                               popcorn_shader_t* shader,
+                               popcorn_startup_t* startup);
+void           popcorn_sky_delete(popcorn_sky_t** _self);
+void           popcorn_sky_draw(popcorn_sky_t* self,
+                                popcorn_queue_t* queue,
+                                const cc_mat4f_t* pm,
+                                const cc_mat4f_t* rvm,
+                                const double* eye);
+
+#endif
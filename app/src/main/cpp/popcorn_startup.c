@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "libcc/cc_timestamp.h"
+#include "popcorn_memory.h"
+#include "popcorn_startup.h"
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_startup_t* popcorn_startup_new(void)
+{
+	popcorn_startup_t* self;
+	self = (popcorn_startup_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_startup_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->t0 = cc_timestamp();
+	self->t  = self->t0;
+
+	return self;
+}
+
+void popcorn_startup_delete(popcorn_startup_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_startup_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+void popcorn_startup_mark(popcorn_startup_t* self,
+                          const char* fmt, ...)
+{
+	ASSERT(self);
+	ASSERT(fmt);
+
+	// the phase ends now and the next phase begins
+	double t = cc_timestamp();
+	if(self->count >= POPCORN_STARTUP_PHASES)
+	{
+		LOGW("phase overflow");
+		self->t = t;
+		return;
+	}
+
+	popcorn_startupPhase_t* phase = &self->phase[self->count];
+
+	va_list argptr;
+	va_start(argptr, fmt);
+	vsnprintf(phase->name, 32, fmt, argptr);
+	va_end(argptr);
+
+	phase->t0 = self->t - self->t0;
+	phase->dt = t - self->t;
+
+	++self->count;
+	self->t = t;
+}
+
+void popcorn_startup_aggregate(popcorn_startup_t* self,
+                               const char* name,
+                               double t0,
+                               uint32_t count,
+                               double dt,
+                               double max)
+{
+	ASSERT(self);
+	ASSERT(name);
+
+	// the aggregate does not end the current phase
+	if(self->count >= POPCORN_STARTUP_PHASES)
+	{
+		LOGW("phase overflow");
+		return;
+	}
+
+	popcorn_startupPhase_t* phase = &self->phase[self->count];
+	snprintf(phase->name, 32, "%s", name);
+	phase->t0    = (count > 0) ? (t0 - self->t0) : 0.0;
+	phase->dt    = dt;
+	phase->count = count;
+	phase->max   = max;
+
+	++self->count;
+}
+
+int popcorn_startup_report(popcorn_startup_t* self,
+                           const char* fname)
+{
+	ASSERT(self);
+	ASSERT(fname);
+
+	double total = self->t - self->t0;
+	if(total <= 0.0)
+	{
+		total = 1.0;
+	}
+
+	LOGI("%-32s %10s %10s %6s",
+	     "phase", "start_ms", "ms", "%");
+
+	uint32_t i;
+	for(i = 0; i < self->count; ++i)
+	{
+		popcorn_startupPhase_t* phase = &self->phase[i];
+		LOGI("%-32s %10.3lf %10.3lf %6.1lf",
+		     phase->name, 1000.0*phase->t0,
+		     1000.0*phase->dt, 100.0*phase->dt/total);
+		if(phase->count)
+		{
+			LOGI("%-32s count=%u, max_ms=%.3lf", "",
+			     phase->count, 1000.0*phase->max);
+		}
+	}
+	LOGI("%-32s %10s %10.3lf", "total", "",
+	     1000.0*(self->t - self->t0));
+
+	FILE* f = fopen(fname, "w");
+	if(f == NULL)
+	{
+		LOGE("invalid %s", fname);
+		return 0;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"total_ms\": %.3lf,\n",
+	        1000.0*(self->t - self->t0));
+	fprintf(f, "\t\"phases\":\n\t[\n");
+	for(i = 0; i < self->count; ++i)
+	{
+		popcorn_startupPhase_t* phase = &self->phase[i];
+		fprintf(f, "\t\t{ \"name\": \"%s\", "
+		           "\"start_ms\": %.3lf, \"ms\": %.3lf",
+		        phase->name, 1000.0*phase->t0,
+		        1000.0*phase->dt);
+		if(phase->count)
+		{
+			fprintf(f, ", \"count\": %u, \"max_ms\": %.3lf",
+			        phase->count, 1000.0*phase->max);
+		}
+		fprintf(f, " }%s\n", (i + 1 < self->count) ? "," : "");
+	}
+	fprintf(f, "\t]\n}\n");
+	fclose(f);
+
+	return 1;
+}
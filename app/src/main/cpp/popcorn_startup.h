@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_startup_H
+#define popcorn_startup_H
+
+#include <stdint.h>
+
+// maximum number of timed phases
+#define POPCORN_STARTUP_PHASES 64
+
+// aggregated phases sum the count events of a phase which
+// is interleaved with other work and max is the longest
+typedef struct
+{
+	char     name[32];
+	double   t0;
+	double   dt;
+	uint32_t count;
+	double   max;
+} popcorn_startupPhase_t;
+
+typedef struct popcorn_startup_s
+{
+	// start of the current phase
+	double t0;
+	double t;
+
+	uint32_t               count;
+	popcorn_startupPhase_t phase[POPCORN_STARTUP_PHASES];
+} popcorn_startup_t;
+
+popcorn_startup_t* popcorn_startup_new(void);
+void               popcorn_startup_delete(popcorn_startup_t** _self);
+void               popcorn_startup_mark(popcorn_startup_t* self,
+                                        const char* fmt, ...);
+void               popcorn_startup_aggregate(popcorn_startup_t* self,
+                                             const char* name,
+                                             double t0,
+                                             uint32_t count,
+                                             double dt,
+                                             double max);
+int                popcorn_startup_report(popcorn_startup_t* self,
+                                          const char* fname);
+
+#endif
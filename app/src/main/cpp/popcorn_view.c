@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#define LOG_TAG "popcorn"
+#include "libcc/cc_log.h"
+#include "popcorn_memory.h"
+#include "popcorn_view.h"
+
+/***********************************************************
+* public                                                   *
+***********************************************************/
+
+popcorn_view_t* popcorn_view_new(vkk_engine_t* engine,
+                                 int stereo)
+{
+	ASSERT(engine);
+
+	popcorn_view_t* self;
+	self = (popcorn_view_t*)
+	       popcorn_memory_calloc(POPCORN_MEMORY_TAG_RENDERER,
+	                             1, sizeof(popcorn_view_t));
+	if(self == NULL)
+	{
+		LOGE("CALLOC failed");
+		return NULL;
+	}
+
+	self->engine = engine;
+	self->count  = stereo ? 2 : 1;
+
+	vkk_uniformBinding_t ub_array1[] =
+	{
+		// layout(std140, set=1, binding=0) uniform uniformView
+		{
+			.binding = 0,
+			.type    = VKK_UNIFORM_TYPE_BUFFER,
+			.stage   = VKK_STAGE_VS,
+		},
+	};
+
+	self->usf1 = vkk_uniformSetFactory_new(engine,
+	                                       VKK_UPDATE_MODE_STATIC,
+	                                       1, ub_array1);
+	if(self->usf1 == NULL)
+	{
+		goto fail_usf1;
+	}
+
+	// the view index is padded to a vec4
+	uint32_t i;
+	for(i = 0; i < POPCORN_VIEW_MAX; ++i)
+	{
+		int32_t index[4] = { (int32_t) i, 0, 0, 0 };
+
+		self->ub10_view[i] = vkk_buffer_new(engine,
+		                                    VKK_UPDATE_MODE_STATIC,
+		                                    VKK_BUFFER_USAGE_UNIFORM,
+		                                    sizeof(index),
+		                                    (const void*) index);
+		if(self->ub10_view[i] == NULL)
+		{
+			goto fail_views;
+		}
+
+		vkk_uniformAttachment_t ua_array1[] =
+		{
+			// layout(std140, set=1, binding=0) uniform uniformView
+			{
+				.binding = 0,
+				.type    = VKK_UNIFORM_TYPE_BUFFER,
+				.buffer  = self->ub10_view[i]
+			},
+		};
+
+		self->us1[i] = vkk_uniformSet_new(engine, 1, 1,
+		                                  ua_array1,
+		                                  self->usf1);
+		if(self->us1[i] == NULL)
+		{
+			goto fail_views;
+		}
+	}
+
+	popcorn_memory_gpuAlloc(POPCORN_MEMORY_TAG_RENDERER,
+	                        POPCORN_VIEW_MAX*4*sizeof(int32_t));
+
+	LOGI("views=%u", self->count);
+
+	// success
+	return self;
+
+	// failure
+	fail_views:
+	{
+		for(i = 0; i < POPCORN_VIEW_MAX; ++i)
+		{
+			vkk_uniformSet_delete(&self->us1[i]);
+			vkk_buffer_delete(&self->ub10_view[i]);
+		}
+		vkk_uniformSetFactory_delete(&self->usf1);
+	}
+	fail_usf1:
+		popcorn_memory_free(self);
+	return NULL;
+}
+
+void popcorn_view_delete(popcorn_view_t** _self)
+{
+	ASSERT(_self);
+
+	popcorn_view_t* self = *_self;
+	if(self)
+	{
+		popcorn_memory_gpuFree(POPCORN_MEMORY_TAG_RENDERER,
+		                       POPCORN_VIEW_MAX*4*sizeof(int32_t));
+
+		uint32_t i;
+		for(i = 0; i < POPCORN_VIEW_MAX; ++i)
+		{
+			vkk_uniformSet_delete(&self->us1[i]);
+			vkk_buffer_delete(&self->ub10_view[i]);
+		}
+		vkk_uniformSetFactory_delete(&self->usf1);
+		popcorn_memory_free(self);
+		*_self = NULL;
+	}
+}
+
+float popcorn_view_layout(popcorn_view_t* self,
+                          uint32_t width, uint32_t height)
+{
+	ASSERT(self);
+
+	// views split the surface horizontally and the
+	// left view is offset to the left eye
+	uint32_t w = width/self->count;
+	uint32_t i;
+	for(i = 0; i < self->count; ++i)
+	{
+		self->x[i]   = i*w;
+		self->w[i]   = w;
+		self->eye[i] = 0.0f;
+	}
+	self->h = height;
+
+	if(self->count == 2)
+	{
+		self->eye[0] = -0.5f*POPCORN_VIEW_IPD;
+		self->eye[1] =  0.5f*POPCORN_VIEW_IPD;
+	}
+
+	if((w == 0) || (height == 0))
+	{
+		return 1.0f;
+	}
+
+	// aspect ratio of each view
+	return ((float) w)/((float) height);
+}
+
+void popcorn_view_mvp(popcorn_view_t* self, uint32_t view,
+                      const cc_mat4f_t* pm,
+                      const cc_mat4f_t* mvm,
+                      cc_mat4f_t* mvp)
+{
+	ASSERT(self);
+	ASSERT(view < self->count);
+	ASSERT(pm);
+	ASSERT(mvm);
+	ASSERT(mvp);
+
+	// the eye is offset in view space
+	cc_mat4f_t eye;
+	cc_mat4f_translate(&eye, 1, -self->eye[view], 0.0f, 0.0f);
+	cc_mat4f_mulm(&eye, mvm);
+	cc_mat4f_mulm_copy(pm, &eye, mvp);
+}
+
+void popcorn_view_viewport(popcorn_view_t* self,
+                           uint32_t view,
+                           vkk_renderer_t* rend)
+{
+	ASSERT(self);
+	ASSERT(view < self->count);
+	ASSERT(rend);
+
+	vkk_renderer_viewport(rend, (float) self->x[view], 0.0f,
+	                      (float) self->w[view],
+	                      (float) self->h);
+	vkk_renderer_scissor(rend, self->x[view], 0,
+	                     self->w[view], self->h);
+}
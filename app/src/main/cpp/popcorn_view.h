@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2022 Jeff Boody
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef popcorn_view_H
+#define popcorn_view_H
+
+#include <stdint.h>
+
+#include "libcc/math/cc_mat4f.h"
+#include "libvkk/vkk.h"
+
+// stereo views are drawn side-by-side with one uniform
+// upload per pass containing the mvp of each view and a
+// static uniform set per view which selects its mvp
+// see uniformView in cube.vert and cockpit.vert
+#define POPCORN_VIEW_MAX 2
+
+// eye separation in world units
+#define POPCORN_VIEW_IPD 0.0065f
+
+typedef struct
+{
+	vkk_engine_t* engine;
+	uint32_t      count;
+
+	// layout(std140, set=1, binding=0) uniform uniformView
+	vkk_uniformSetFactory_t* usf1;
+	vkk_buffer_t*            ub10_view[POPCORN_VIEW_MAX];
+	vkk_uniformSet_t*        us1[POPCORN_VIEW_MAX];
+
+	// viewport of each view for the current surface
+	uint32_t x[POPCORN_VIEW_MAX];
+	uint32_t w[POPCORN_VIEW_MAX];
+	uint32_t h;
+	float    eye[POPCORN_VIEW_MAX];
+} popcorn_view_t;
+
+popcorn_view_t* popcorn_view_new(vkk_engine_t* engine,
+                                 int stereo);
+void            popcorn_view_delete(popcorn_view_t** _self);
+float           popcorn_view_layout(popcorn_view_t* self,
+                                    uint32_t width,
+                                    uint32_t height);
+void            popcorn_view_mvp(popcorn_view_t* self,
+                                 uint32_t view,
+                                 const cc_mat4f_t* pm,
+                                 const cc_mat4f_t* mvm,
+                                 cc_mat4f_t* mvp);
+void            popcorn_view_viewport(popcorn_view_t* self,
+                                      uint32_t view,
+                                      vkk_renderer_t* rend);
+
+#endif
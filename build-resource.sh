@@ -1,32 +1,177 @@
+#!/bin/bash
+
+# builds app/src/main/assets/resource.pak
+# requires bash (arrays and wait -n), glslangValidator, pak and
+# popcorn_meshc which must be built first:
+#	cd app/src/main/cpp && make popcorn_meshc
+
 export RESOURCE=$PWD/app/src/main/assets/resource.pak
 
+# incremental resource build
+# compiled shaders and meshes are cached by the hash of their
+# inputs and the pak is only rebuilt when an input has changed
+CACHE=$PWD/resource/.cache
+JOBS=`nproc 2>/dev/null || echo 4`
+VKUI=$PWD/app/src/main/cpp/libvkk/vkui/resource
+
+# mesh compressor
+# see app/src/main/cpp/Makefile
+MESHC=$PWD/app/src/main/cpp/popcorn_meshc
+if [ ! -x $MESHC ]; then
+	echo "build $MESHC first (make -C app/src/main/cpp popcorn_meshc)"
+	exit 1
+fi
+
+mkdir -p $CACHE/spv $CACHE/pcm $CACHE/stage/shaders $CACHE/stage/models
+
 echo RESOURCES
 cd resource
 
-# shaders
-cd shaders
-glslangValidator -V cube.vert    -o cube_vert.spv
-glslangValidator -V cube.frag    -o cube_frag.spv
-glslangValidator -V cockpit.frag -o cockpit_frag.spv
-glslangValidator -V cockpit.vert -o cockpit_vert.spv
-cd ..
+# meshes
+MESHES="bat-rider"
 
-# pak resources
-pak -c $RESOURCE readme.txt
-pak -a $RESOURCE shaders/cube_vert.spv
-pak -a $RESOURCE shaders/cube_frag.spv
-pak -a $RESOURCE shaders/cockpit_frag.spv
-pak -a $RESOURCE shaders/cockpit_vert.spv
-pak -a $RESOURCE models/bat-rider.glb
+# textures are copied as is
+TEXTURES="screen.png"
+for MESH in $MESHES; do
+	KEY=`cat models/$MESH.glb $MESHC | sha1sum | cut -c 1-40`
+	echo "$KEY" > $CACHE/pcm/$MESH.key
+	if [ -e $CACHE/pcm/$KEY.pcm ]; then
+		continue
+	fi
+
+	echo COMPRESS $MESH
+	($MESHC models/$MESH.glb $CACHE/pcm/$KEY.tmp > $CACHE/pcm/$KEY.log 2>&1 &&
+	 mv $CACHE/pcm/$KEY.tmp $CACHE/pcm/$KEY.pcm) &
+done
+
+# shader variants
+# see shaders/variants.txt
+GLSLANG=`glslangValidator --version | sha1sum | cut -c 1-40`
+
+compile()
+{
+	SRC=$1
+	KEY=$2
+	FLAGS=$3
+
+	# write to a temporary file so an interrupted
+	# build never leaves a partial cache entry
+	glslangValidator -V $FLAGS shaders/$SRC \
+	                 -o $CACHE/spv/$KEY.tmp > $CACHE/spv/$KEY.log || return 1
+	mv $CACHE/spv/$KEY.tmp $CACHE/spv/$KEY.spv
+}
+
+VARIANTS=()
+while read SRC DEFINES; do
+	# skip comments and empty lines
+	case "$SRC" in
+		""|\#*) continue;;
+	esac
+
+	FLAGS=""
+	for DEFINE in $DEFINES; do
+		FLAGS="$FLAGS -D$DEFINE"
+	done
 
-# cleanup shaders
-rm shaders/*.spv
-cd ..
+	# the key covers the source, defines and compiler
+	KEY=`(echo "$GLSLANG $FLAGS"; cat shaders/$SRC) | sha1sum | cut -c 1-40`
+	VARIANTS+=("$KEY $SRC $DEFINES")
+	if [ -e $CACHE/spv/$KEY.spv ]; then
+		continue
+	fi
+
+	echo COMPILE $SRC $DEFINES
+	compile $SRC $KEY "$FLAGS" &
+
+	# limit the number of parallel jobs
+	while [ `jobs -rp | wc -l` -ge $JOBS ]; do
+		wait -n
+	done
+done < shaders/variants.txt
+wait
+
+# a failed job leaves no cache entry
+FAILED=0
+for MESH in $MESHES; do
+	KEY=`cat $CACHE/pcm/$MESH.key`
+	if [ ! -e $CACHE/pcm/$KEY.pcm ]; then
+		cat $CACHE/pcm/$KEY.log
+		FAILED=1
+	fi
+done
+for VARIANT in "${VARIANTS[@]}"; do
+	set -- $VARIANT
+	if [ ! -e $CACHE/spv/$1.spv ]; then
+		FAILED=1
+	fi
+done
+
+if [ $FAILED -ne 0 ]; then
+	echo "build failed"
+	cat $CACHE/spv/*.log
+	exit 1
+fi
+
+rm -f $CACHE/stage/models/*
+for MESH in $MESHES; do
+	KEY=`cat $CACHE/pcm/$MESH.key`
+	cp $CACHE/pcm/$KEY.pcm $CACHE/stage/models/$MESH.pcm
+done
+for TEXTURE in $TEXTURES; do
+	cp models/$TEXTURE $CACHE/stage/models/$TEXTURE
+done
+
+# name the SPIR-V by content hash to dedupe variants
+rm -f $CACHE/stage/shaders/*
+for VARIANT in "${VARIANTS[@]}"; do
+	set -- $VARIANT
+	KEY=$1
+	SRC=$2
+	shift 2
+	HASH=`sha1sum $CACHE/spv/$KEY.spv | cut -c 1-16`
+	cp $CACHE/spv/$KEY.spv $CACHE/stage/shaders/$HASH.spv
+	echo "$SRC shaders/$HASH.spv" $* >> $CACHE/stage/shaders/variants.idx
+done
+
+# skip the pak when no input has changed
+STAMP=`(cat $CACHE/stage/shaders/variants.idx;
+        cat $CACHE/pcm/*.key;
+        (cd models && sha1sum $TEXTURES);
+        sha1sum ../build-resource.sh readme.txt;
+        cd $VKUI && find . -type f | sort | xargs sha1sum) |
+       sha1sum | cut -c 1-40`
+if [ -e $RESOURCE ] && [ -e $CACHE/pak.stamp ] &&
+   [ "$STAMP" == "`cat $CACHE/pak.stamp`" ]; then
+	echo UP-TO-DATE
+	exit 0
+fi
+
+# build the pak in a temporary file
+TMP=$RESOURCE.tmp.$$
+rm -f $TMP
+
+# pak resources
+pak -c $TMP readme.txt || exit 1
+cd $CACHE/stage
+for PCM in models/*.pcm; do
+	pak -a $TMP $PCM || exit 1
+done
+for TEXTURE in $TEXTURES; do
+	pak -a $TMP models/$TEXTURE || exit 1
+done
+pak -a $TMP shaders/variants.idx || exit 1
+for SPV in shaders/*.spv; do
+	pak -a $TMP $SPV || exit 1
+done
 
 # VKUI
-cd app/src/main/cpp/libvkk/vkui/resource
-./build-resource.sh $RESOURCE
-cd ../../../../../../..
+cd $VKUI
+./build-resource.sh $TMP || exit 1
+cd - > /dev/null
+
+# replace the pak atomically
+mv -f $TMP $RESOURCE
+echo $STAMP > $CACHE/pak.stamp
 
 echo CONTENTS
 pak -l $RESOURCE
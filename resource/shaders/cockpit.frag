@@ -9,6 +9,7 @@ void main()
 {
 	vec3 ambient = vec3(0.2, 0.2, 0.2);
 
+	#ifdef LIGHTING
 	vec3  l     = vec3(0.0, 0.0, 0.0);
 	vec3  n     = normalize(varying_normal.xyz);
 	vec3  p     = varying_vertex.xyz;
@@ -25,4 +26,7 @@ void main()
 	{
 		fragColor = vec4(ambient, 1.0);
 	}
+	#else
+	fragColor = vec4(ambient, 1.0);
+	#endif
 }
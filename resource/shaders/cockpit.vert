@@ -2,10 +2,18 @@
 
 layout(location=0) in vec3 vertex;
 layout(location=1) in vec3 normal;
+layout(location=2) in uint node;
 
+// see POPCORN_VIEW_MAX and POPCORN_COCKPIT_NODES
 layout(std140, set=0, binding=0) uniform uniformMvp
 {
-	mat4 mvp;
+	mat4 mvp[2];
+	mat4 mvm[254];
+};
+
+layout(std140, set=1, binding=0) uniform uniformView
+{
+	int view;
 };
 
 layout(location=0) out vec3 varying_vertex;
@@ -13,7 +21,9 @@ layout(location=1) out vec3 varying_normal;
 
 void main()
 {
-	varying_vertex = vertex;
-	varying_normal = normal;
-	gl_Position    = mvp*vec4(vertex, 1.0);
+	// the node transform places the part in the cockpit
+	vec4 v         = mvm[node]*vec4(vertex, 1.0);
+	varying_vertex = v.xyz;
+	varying_normal = mat3(mvm[node])*normal;
+	gl_Position    = mvp[view]*v;
 }
@@ -4,9 +4,15 @@ layout(location=0) in vec4 xyzw;
 layout(location=1) in vec2 uv;
 layout(location=2) in vec4 rgba;
 
+// see POPCORN_VIEW_MAX
 layout(std140, set=0, binding=0) uniform uniformMvp
 {
-	mat4 mvp;
+	mat4 mvp[2];
+};
+
+layout(std140, set=1, binding=0) uniform uniformView
+{
+	int view;
 };
 
 layout(location=0) out vec2 varying_uv;
@@ -16,5 +22,5 @@ void main()
 {
 	varying_uv   = uv;
 	varying_rgba = rgba;
-	gl_Position  = mvp*xyzw;
+	gl_Position  = mvp[view]*xyzw;
 }
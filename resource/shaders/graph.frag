@@ -0,0 +1,10 @@
+#version 450
+
+layout(location=0) in vec4 varying_rgba;
+
+layout(location=0) out vec4 fragColor;
+
+void main()
+{
+	fragColor = varying_rgba;
+}
@@ -0,0 +1,17 @@
+#version 450
+
+layout(location=0) in vec2 xy;
+layout(location=1) in vec4 rgba;
+
+layout(std140, set=0, binding=0) uniform uniformMvp
+{
+	mat4 mvp;
+};
+
+layout(location=0) out vec4 varying_rgba;
+
+void main()
+{
+	varying_rgba = rgba;
+	gl_Position  = mvp*vec4(xy, 0.0, 1.0);
+}
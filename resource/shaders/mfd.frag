@@ -0,0 +1,103 @@
+#version 450
+
+layout(location=0) in vec2 varying_ndc;
+
+// see popcorn_mfdUniform_t
+// attitude is the bearing, pitch and bank in degrees and
+// the speed relative to the maximum speed
+layout(std140, set=0, binding=0) uniform uniformMfd
+{
+	vec4 attitude;
+};
+
+layout(set=0, binding=1) uniform sampler2D bezel;
+
+layout(location=0) out vec4 fragColor;
+
+const vec3 SKY    = vec3(0.20, 0.45, 0.80);
+const vec3 GROUND = vec3(0.45, 0.30, 0.15);
+const vec3 LINE   = vec3(1.00, 1.00, 1.00);
+const vec3 SYMBOL = vec3(1.00, 0.80, 0.00);
+const vec3 SPEED  = vec3(0.20, 0.90, 0.30);
+const vec3 TAPE   = vec3(0.05, 0.05, 0.05);
+
+// display units per degree of pitch and bearing
+const float PITCH_SCALE   = 1.0/45.0;
+const float BEARING_SCALE = 1.0/45.0;
+
+// border covered by the bezel
+const float BORDER = 0.9;
+
+// anti-aliased coverage of a signed distance in display
+// units where negative is inside
+float coverage(float d)
+{
+	float w = max(fwidth(d), 1.0e-4);
+	return clamp(0.5 - d/w, 0.0, 1.0);
+}
+
+// distance to the nearest multiple of step
+float ticks(float x, float step)
+{
+	return step*abs(fract(x/step + 0.5) - 0.5);
+}
+
+void main()
+{
+	// display coordinates with y up
+	vec2  p       = vec2(varying_ndc.x, -varying_ndc.y);
+	float bearing = attitude.x;
+	float pitch   = attitude.y;
+	float bank    = radians(attitude.z);
+	float speed   = attitude.w;
+
+	// attitude indicator
+	// the horizon rotates with the bank like the horizon
+	// bar and moves down as the nose pitches up
+	vec2  n = vec2(sin(bank), cos(bank));
+	vec2  d = vec2(n.y, -n.x);
+	float h = dot(p, n) + PITCH_SCALE*pitch;
+	vec3  c = mix(GROUND, SKY, coverage(-h));
+	c = mix(c, LINE, coverage(abs(h) - 0.008));
+
+	// pitch ladder every 10 degrees
+	float rung = ticks(h/PITCH_SCALE, 10.0)*PITCH_SCALE;
+	float span = (abs(h) < 0.5*PITCH_SCALE) ? 0.0 : 0.15;
+	c = mix(c, LINE, coverage(max(rung - 0.004,
+	                              abs(dot(p, d)) - span)));
+
+	// aircraft symbol
+	float wing = max(abs(p.y) - 0.012,
+	                 abs(abs(p.x) - 0.22) - 0.12);
+	c = mix(c, SYMBOL, coverage(min(wing, length(p) - 0.02)));
+
+	// heading tape at the top with major ticks every 30
+	// degrees and a marker at the current bearing
+	float b     = bearing + p.x/BEARING_SCALE;
+	float minor = max(ticks(b, 10.0)*BEARING_SCALE - 0.004,
+	                  0.72 - p.y);
+	float major = max(ticks(b, 30.0)*BEARING_SCALE - 0.006,
+	                  0.66 - p.y);
+	float north = max(ticks(b, 360.0)*BEARING_SCALE - 0.010,
+	                  0.60 - p.y);
+	c = mix(c, TAPE, 0.6*coverage(0.62 - p.y));
+	c = mix(c, LINE, coverage(min(minor, major)));
+	c = mix(c, SYMBOL, coverage(north));
+	c = mix(c, SYMBOL, coverage(max(abs(p.x) - 0.5*(p.y - 0.56),
+	                                p.y - 0.62)));
+
+	// speed bar on the left
+	float top = -0.6 + 1.2*clamp(speed, 0.0, 1.0);
+	float bar = max(abs(p.x + 0.8) - 0.05,
+	                max(-0.6 - p.y, p.y - top));
+	c = mix(c, TAPE, 0.6*coverage(max(abs(p.x + 0.8) - 0.06,
+	                                  abs(p.y) - 0.61)));
+	c = mix(c, SPEED, coverage(bar));
+
+	// the screen bezel frames the display
+	float frame = max(abs(p.x), abs(p.y)) - BORDER;
+	vec3  bz    = texture(bezel, 0.5*varying_ndc + 0.5).rgb;
+	c = mix(c, bz, coverage(-frame));
+
+	fragColor = vec4(c, 1.0);
+}
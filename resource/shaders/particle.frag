@@ -0,0 +1,14 @@
+#version 450
+
+layout(location=0) in vec2  varying_uv;
+layout(location=1) in float varying_alpha;
+
+layout(location=0) out vec4 fragColor;
+
+void main()
+{
+	// soft round sprite
+	float r = length(varying_uv);
+	float a = varying_alpha*(1.0 - smoothstep(0.5, 1.0, r));
+	fragColor = vec4(0.9, 0.9, 0.9, a);
+}
@@ -0,0 +1,44 @@
+#version 450
+
+// xyz is the position and w is the normalized age
+layout(location=0) in vec4 center;
+
+// see popcorn_contrailUniform_t
+layout(std140, set=0, binding=0) uniform uniformParticle
+{
+	mat4 mvp[2];
+	vec4 right;
+	vec4 up;
+	vec4 size;
+};
+
+layout(std140, set=1, binding=0) uniform uniformView
+{
+	int view;
+};
+
+layout(location=0) out vec2  varying_uv;
+layout(location=1) out float varying_alpha;
+
+// corners of the two triangles of each billboard
+const vec2 CORNER[6] = vec2[]
+(
+	vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0,  1.0),
+	vec2(-1.0, -1.0), vec2(1.0,  1.0), vec2(-1.0, 1.0)
+);
+
+void main()
+{
+	vec2 corner = CORNER[gl_VertexIndex%6];
+
+	vec3  xyz = center.xyz;
+	float a   = center.w;
+
+	// billboards grow and fade with age
+	float s = size.x*(1.0 + 3.0*a);
+	xyz += s*(corner.x*right.xyz + corner.y*up.xyz);
+
+	varying_uv    = corner;
+	varying_alpha = 0.5*(1.0 - a);
+	gl_Position   = mvp[view]*vec4(xyz, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 450
+
+layout(location=0) in vec2 varying_uv;
+
+// see popcorn_mfd_update
+layout(set=0, binding=1) uniform sampler2D image;
+
+layout(location=0) out vec4 fragColor;
+
+void main()
+{
+	fragColor = texture(image, varying_uv);
+}
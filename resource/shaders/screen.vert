@@ -0,0 +1,24 @@
+#version 450
+
+layout(location=0) in vec3 vertex;
+layout(location=1) in vec2 uv;
+
+// see POPCORN_VIEW_MAX
+layout(std140, set=0, binding=0) uniform uniformMvp
+{
+	mat4 mvp[2];
+};
+
+layout(std140, set=1, binding=0) uniform uniformView
+{
+	int view;
+};
+
+layout(location=0) out vec2 varying_uv;
+
+void main()
+{
+	// the screen is placed in cockpit coordinates
+	varying_uv  = uv;
+	gl_Position = mvp[view]*vec4(vertex, 1.0);
+}
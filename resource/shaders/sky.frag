@@ -0,0 +1,62 @@
+#version 450
+
+layout(location=0) in vec2 varying_ndc;
+
+// see popcorn_skyUniform_t
+layout(std140, set=0, binding=0) uniform uniformSky
+{
+	mat4 ivp;
+	vec4 eye;
+	vec4 ground;
+};
+
+layout(location=0) out vec4 fragColor;
+
+const vec3 ZENITH  = vec3(0.20, 0.35, 0.70);
+const vec3 HORIZON = vec3(0.70, 0.78, 0.88);
+const vec3 LIGHT   = vec3(0.45, 0.55, 0.35);
+const vec3 DARK    = vec3(0.30, 0.40, 0.25);
+
+// distance of rays which miss the ground
+const float FAR = 1.0e4;
+
+// box filtered checker where w is the footprint of the
+// pixel in cells so distant cells average to gray
+// rather than alias
+// https://iquilezles.org/articles/checkerfiltering/
+float checker(vec2 p, vec2 w)
+{
+	vec2 i = 2.0*(abs(fract(0.5*(p - 0.5*w)) - 0.5) -
+	              abs(fract(0.5*(p + 0.5*w)) - 0.5))/w;
+	return 0.5 - 0.5*i.x*i.y;
+}
+
+void main()
+{
+	// view ray through the far plane
+	// the ivp has no translation so the eye is the origin
+	vec4 far = ivp*vec4(varying_ndc, 1.0, 1.0);
+	vec3 dir = normalize(far.xyz/far.w);
+
+	// sky gradient where the world up axis is -z
+	float up  = -dir.z;
+	vec3  sky = mix(HORIZON, ZENITH, sqrt(max(up, 0.0)));
+
+	// intersect the ground plane z=ground.x
+	// the derivatives must be evaluated for every pixel
+	// so the miss case is replaced by a distant hit
+	float t   = (ground.x - eye.z)/dir.z;
+	bool  hit = (t > 0.0) && (t < FAR);
+	t = hit ? t : FAR;
+
+	vec2 p = (eye.xy + t*dir.xy)/ground.y;
+	vec2 w = max(abs(dFdx(p)), abs(dFdy(p))) + 0.001;
+	vec3 g = mix(DARK, LIGHT, checker(p, w));
+
+	// fog hides the horizon where the cells are smaller
+	// than a pixel
+	float fog = 1.0 - exp(-ground.z*t);
+	g = mix(g, HORIZON, fog);
+
+	fragColor = vec4(hit ? g : sky, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 450
+
+layout(location=0) out vec2 varying_ndc;
+
+void main()
+{
+	// fullscreen triangle generated from the vertex index
+	// (-1,-1), (3,-1), (-1,3)
+	vec2 ndc = 2.0*vec2(float((gl_VertexIndex << 1) & 2),
+	                    float(gl_VertexIndex & 2)) - 1.0;
+
+	varying_ndc = ndc;
+	gl_Position = vec4(ndc, 0.0, 1.0);
+}